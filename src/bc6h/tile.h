@@ -24,14 +24,14 @@ class Tile
 {
 public:
 	// NOTE: this returns the appropriately-clamped BIT PATTERN of the half as an INTEGRAL float value
-	static float half2float(uint16 h)
+	static float half2float(uint16 h, Format format)
 	{
-		return (float) Utils::ushort_to_format(h);
+		return (float) Utils::ushort_to_format(h, format);
 	}
 	// NOTE: this is the inverse of the above operation
-	static uint16 float2half(float f)
+	static uint16 float2half(float f, Format format)
 	{
-		return Utils::format_to_ushort((int)f);
+		return Utils::format_to_ushort((int)f, format);
 	}
 
 	// look for adjacent pixels that are identical. if there are enough of them, increase their importance
@@ -27,12 +27,20 @@ bool ZOH::isone(const char *block)
 	return (code == 0x03 || code == 0x07 || code == 0x0b || code == 0x0f);
 }
 
-void ZOH::compress(const Tile &t, char *block)
+void ZOH::compress(const Tile &t, const Options &options, char *block)
 {
+	// refining the one-region modes costs more than the rough pass and one two-region refinement together, and
+	// the two-region modes usually win, so the fastest settings only try those
+	if (!options.one_region)
+	{
+		ZOH::compresstwo(t, options, block);
+		return;
+	}
+
 	char oneblock[ZOH::BLOCKSIZE], twoblock[ZOH::BLOCKSIZE];
 
-	float mseone = ZOH::compressone(t, oneblock);
-	float msetwo = ZOH::compresstwo(t, twoblock);
+	float mseone = ZOH::compressone(t, options, oneblock);
+	float msetwo = ZOH::compresstwo(t, options, twoblock);
 
 	if (mseone <= msetwo)
 		memcpy(block, oneblock, ZOH::BLOCKSIZE);
@@ -40,12 +48,12 @@ void ZOH::compress(const Tile &t, char *block)
 		memcpy(block, twoblock, ZOH::BLOCKSIZE);
 }
 
-void ZOH::decompress(const char *block, Tile &t)
+void ZOH::decompress(const char *block, const Options &options, Tile &t)
 {
 	if (ZOH::isone(block))
-		ZOH::decompressone(block, t);
+		ZOH::decompressone(block, options, t);
 	else
-		ZOH::decompresstwo(block, t);
+		ZOH::decompresstwo(block, options, t);
 }
 
 /*
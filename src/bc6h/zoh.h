@@ -44,19 +44,35 @@ struct ComprEndpts
 static const int BLOCKSIZE=16;
 static const int BITSIZE=128;
 
-void compress(const Tile &t, char *block);
-void decompress(const char *block, Tile &t);
+// settings of a single compress or decompress call, passed down instead of kept in globals so that tiles
+// with different settings can be processed concurrently
+struct Options
+{
+	Options() : format(UNSIGNED_F16), one_region(true), refine_count(1) {}
+
+	Format format;		// whether the tile holds unsigned or signed half values
+
+	// search effort, see ZOH::compress
+	bool one_region;	// also try the one-region modes, which have more precision but fit a single line to the tile
+	int refine_count;	// number of two-region shapes refined, in order of their rough error
+};
+
+void compress(const Tile &t, const Options &options, char *block);
+void decompress(const char *block, const Options &options, Tile &t);
+
+float compressone(const Tile &t, const Options &options, char *block);
+float compresstwo(const Tile &t, const Options &options, char *block);
+void decompressone(const char *block, const Options &options, Tile &t);
+void decompresstwo(const char *block, const Options &options, Tile &t);
 
-float compressone(const Tile &t, char *block);
-float compresstwo(const Tile &t, char *block);
-void decompressone(const char *block, Tile &t);
-void decompresstwo(const char *block, Tile &t);
+// encode a tile of a single color, the color holds half values like the tiles
+void compress_single_color(const nv::Vector3 &color, const Options &options, char *block);
 
-float refinetwo(const Tile &tile, int shapeindex_best, const FltEndpts endpts[NREGIONS_TWO], char *block);
-float roughtwo(const Tile &tile, int shape, FltEndpts endpts[NREGIONS_TWO]);
+float refinetwo(const Tile &tile, int shapeindex_best, const FltEndpts endpts[NREGIONS_TWO], const Options &options, char *block);
+float roughtwo(const Tile &tile, int shape, const Options &options, FltEndpts endpts[NREGIONS_TWO]);
 
-float refineone(const Tile &tile, int shapeindex_best, const FltEndpts endpts[NREGIONS_ONE], char *block);
-float roughone(const Tile &tile, int shape, FltEndpts endpts[NREGIONS_ONE]);
+float refineone(const Tile &tile, int shapeindex_best, const FltEndpts endpts[NREGIONS_ONE], const Options &options, char *block);
+float roughone(const Tile &tile, int shape, const Options &options, FltEndpts endpts[NREGIONS_ONE]);
 
 bool isone(const char *block);
 
@@ -22,8 +22,6 @@ using namespace ZOH;
 static const int denom7_weights_64[] = {0, 9, 18, 27, 37, 46, 55, 64};										// divided by 64
 static const int denom15_weights_64[] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};		// divided by 64
 
-/*static*/ Format Utils::FORMAT;
-
 int Utils::lerp(int a, int b, int i, int denom)
 {
 	nvDebugCheck (denom == 3 || denom == 7 || denom == 15);
@@ -78,15 +76,15 @@ Vector3 Utils::lerp(const Vector3& a, const Vector3 &b, int i, int denom)
 	The inverse conversions are just the inverse of the above.
 */
 
-// clamp the 3 channels of the input vector to the allowable range based on FORMAT
+// clamp the 3 channels of the input vector to the allowable range based on format
 // note that each channel is a float storing the allowable range as a bit pattern converted to float
 // that is, for unsigned f16 say, we would clamp each channel to the range [0, F16MAX]
 
-void Utils::clamp(Vector3 &v)
+void Utils::clamp(Vector3 &v, Format format)
 {
 	for (int i=0; i<3; ++i)
 	{
-		switch(Utils::FORMAT)
+		switch(format)
 		{
 		case UNSIGNED_F16:
 			if (v.component[i] < 0.0) v.component[i] = 0;
@@ -105,12 +103,12 @@ void Utils::clamp(Vector3 &v)
 }
 
 // convert a u16 value to s17 (represented as an int) based on the format expected
-int Utils::ushort_to_format(unsigned short input)
+int Utils::ushort_to_format(unsigned short input, Format format)
 {
 	int out, s;
 
 	// clamp to the valid range we are expecting
-	switch (Utils::FORMAT)
+	switch (format)
 	{
 	case UNSIGNED_F16:
 		if (input & F16S_MASK) out = 0;
@@ -130,12 +128,12 @@ int Utils::ushort_to_format(unsigned short input)
 }
 
 // convert a s17 value to u16 based on the format expected
-unsigned short Utils::format_to_ushort(int input)
+unsigned short Utils::format_to_ushort(int input, Format format)
 {
 	unsigned short out;
 
 	// clamp to the valid range we are expecting
-	switch (Utils::FORMAT)
+	switch (format)
 	{
 	case UNSIGNED_F16:
 		nvDebugCheck (input >= 0 && input <= F16MAX);
@@ -155,7 +153,7 @@ unsigned short Utils::format_to_ushort(int input)
 }
 
 // quantize the input range into equal-sized bins
-int Utils::quantize(float value, int prec)
+int Utils::quantize(float value, int prec, Format format)
 {
 	int q, ivalue, s;
 
@@ -165,7 +163,7 @@ int Utils::quantize(float value, int prec)
 
 	int bias = (prec > 10) ? ((1<<(prec-1))-1) : 0;	// bias precisions 11..16 to get a more accurate quantization
 
-	switch (Utils::FORMAT)
+	switch (format)
 	{
 	case UNSIGNED_F16:
 		nvDebugCheck (value >= 0 && value <= F16MAX);
@@ -190,11 +188,11 @@ int Utils::quantize(float value, int prec)
 	return q;
 }
 
-int Utils::finish_unquantize(int q, int prec)
+int Utils::finish_unquantize(int q, int prec, Format format)
 {
-	if (Utils::FORMAT == UNSIGNED_F16)
+	if (format == UNSIGNED_F16)
 		return (q * 31) >> 6;										// scale the magnitude by 31/64
-	else if (Utils::FORMAT == SIGNED_F16)
+	else if (format == SIGNED_F16)
 		return (q < 0) ? -(((-q) * 31) >> 5) : (q * 31) >> 5;		// scale the magnitude by 31/32
 	else
 		return q;
@@ -206,13 +204,13 @@ int Utils::finish_unquantize(int q, int prec)
 // the asymmetric end bins do not affect PSNR for the test images.
 //
 // code this function assuming an arbitrary bit pattern as the encoded block
-int Utils::unquantize(int q, int prec)
+int Utils::unquantize(int q, int prec, Format format)
 {
 	int unq, s;
 
 	nvDebugCheck (prec > 1);	// not implemented for prec 1
 
-	switch (Utils::FORMAT)
+	switch (format)
 	{
 	// modify this case to move the multiplication by 31 after interpolation.
 	// Need to use finish_unquantize.
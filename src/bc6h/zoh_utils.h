@@ -43,23 +43,21 @@ enum Format { UNSIGNED_F16, SIGNED_F16 };
 class Utils
 {
 public:
-    static Format FORMAT;     // this is a global -- we're either handling unsigned or unsigned half values
-
     // error metrics
     static float norm(const nv::Vector3 &a, const nv::Vector3 &b);
     static float mpsnr_norm(const nv::Vector3 &a, int exposure, const nv::Vector3 &b);
 
     // conversion & clamp
-    static int ushort_to_format(unsigned short input);
-    static unsigned short format_to_ushort(int input);
+    static int ushort_to_format(unsigned short input, Format format);
+    static unsigned short format_to_ushort(int input, Format format);
 
     // clamp to format
-    static void clamp(nv::Vector3 &v);
+    static void clamp(nv::Vector3 &v, Format format);
 
     // quantization and unquantization
-    static int finish_unquantize(int q, int prec);
-    static int unquantize(int q, int prec);
-    static int quantize(float value, int prec);
+    static int finish_unquantize(int q, int prec, Format format);
+    static int unquantize(int q, int prec, Format format);
+    static int quantize(float value, int prec, Format format);
 
     static void parse(const char *encoding, int &ptr, Field & field, int &endbit, int &len);
 
@@ -160,9 +160,9 @@ static void compress_endpts(const IntEndpts in[NREGIONS_TWO], ComprEndpts out[NR
 }
 
 // decompress endpoints
-static void decompress_endpts(const ComprEndpts in[NREGIONS_TWO], IntEndpts out[NREGIONS_TWO], const Pattern &p)
+static void decompress_endpts(const ComprEndpts in[NREGIONS_TWO], IntEndpts out[NREGIONS_TWO], const Pattern &p, Format format)
 {
-    bool issigned = Utils::FORMAT == SIGNED_F16;
+    bool issigned = format == SIGNED_F16;
 
     if (p.transformed)
     {
@@ -193,16 +193,16 @@ static void decompress_endpts(const ComprEndpts in[NREGIONS_TWO], IntEndpts out[
     }
 }
 
-static void quantize_endpts(const FltEndpts endpts[NREGIONS_TWO], int prec, IntEndpts q_endpts[NREGIONS_TWO])
+static void quantize_endpts(const FltEndpts endpts[NREGIONS_TWO], int prec, Format format, IntEndpts q_endpts[NREGIONS_TWO])
 {
     for (int region = 0; region < NREGIONS_TWO; ++region)
     {
-        q_endpts[region].A[0] = Utils::quantize(endpts[region].A.x, prec);
-        q_endpts[region].A[1] = Utils::quantize(endpts[region].A.y, prec);
-        q_endpts[region].A[2] = Utils::quantize(endpts[region].A.z, prec);
-        q_endpts[region].B[0] = Utils::quantize(endpts[region].B.x, prec);
-        q_endpts[region].B[1] = Utils::quantize(endpts[region].B.y, prec);
-        q_endpts[region].B[2] = Utils::quantize(endpts[region].B.z, prec);
+        q_endpts[region].A[0] = Utils::quantize(endpts[region].A.x, prec, format);
+        q_endpts[region].A[1] = Utils::quantize(endpts[region].A.y, prec, format);
+        q_endpts[region].A[2] = Utils::quantize(endpts[region].A.z, prec, format);
+        q_endpts[region].B[0] = Utils::quantize(endpts[region].B.x, prec, format);
+        q_endpts[region].B[1] = Utils::quantize(endpts[region].B.y, prec, format);
+        q_endpts[region].B[2] = Utils::quantize(endpts[region].B.z, prec, format);
     }
 }
 
@@ -234,11 +234,11 @@ static void swap_indices(IntEndpts endpts[NREGIONS_TWO], int indices[Tile::TILE_
 }
 
 // endpoints fit only if the compression was lossless
-static bool endpts_fit(const IntEndpts orig[NREGIONS_TWO], const ComprEndpts compressed[NREGIONS_TWO], const Pattern &p)
+static bool endpts_fit(const IntEndpts orig[NREGIONS_TWO], const ComprEndpts compressed[NREGIONS_TWO], const Pattern &p, Format format)
 {
     IntEndpts uncompressed[NREGIONS_TWO];
 
-    decompress_endpts(compressed, uncompressed, p);
+    decompress_endpts(compressed, uncompressed, p, format);
 
     for (int j=0; j<NREGIONS_TWO; ++j)
     {
@@ -387,31 +387,31 @@ static void emit_block(const ComprEndpts compr_endpts[NREGIONS_TWO], int shapein
     nvDebugCheck(out.getptr() == ZOH::BITSIZE);
 }
 
-static void generate_palette_quantized(const IntEndpts &endpts, int prec, Vector3 palette[NINDICES])
+static void generate_palette_quantized(const IntEndpts &endpts, int prec, Format format, Vector3 palette[NINDICES])
 {
     // scale endpoints
     int a, b;			// really need a IntVector3...
 
-    a = Utils::unquantize(endpts.A[0], prec);
-    b = Utils::unquantize(endpts.B[0], prec);
+    a = Utils::unquantize(endpts.A[0], prec, format);
+    b = Utils::unquantize(endpts.B[0], prec, format);
 
     // interpolate
     for (int i = 0; i < NINDICES; ++i)
-        palette[i].x = float(Utils::finish_unquantize(Utils::lerp(a, b, i, DENOM), prec));
+        palette[i].x = float(Utils::finish_unquantize(Utils::lerp(a, b, i, DENOM), prec, format));
 
-    a = Utils::unquantize(endpts.A[1], prec);
-    b = Utils::unquantize(endpts.B[1], prec);
+    a = Utils::unquantize(endpts.A[1], prec, format);
+    b = Utils::unquantize(endpts.B[1], prec, format);
 
     // interpolate
     for (int i = 0; i < NINDICES; ++i)
-        palette[i].y = float(Utils::finish_unquantize(Utils::lerp(a, b, i, DENOM), prec));
+        palette[i].y = float(Utils::finish_unquantize(Utils::lerp(a, b, i, DENOM), prec, format));
 
-    a = Utils::unquantize(endpts.A[2], prec);
-    b = Utils::unquantize(endpts.B[2], prec);
+    a = Utils::unquantize(endpts.A[2], prec, format);
+    b = Utils::unquantize(endpts.B[2], prec, format);
 
     // interpolate
     for (int i = 0; i < NINDICES; ++i)
-        palette[i].z = float(Utils::finish_unquantize(Utils::lerp(a, b, i, DENOM), prec));
+        palette[i].z = float(Utils::finish_unquantize(Utils::lerp(a, b, i, DENOM), prec, format));
 }
 
 static void read_indices(Bits &in, int shapeindex, int indices[Tile::TILE_H][Tile::TILE_W])
@@ -435,7 +435,7 @@ static void read_indices(Bits &in, int shapeindex, int indices[Tile::TILE_H][Til
     }
 }
 
-void ZOH::decompresstwo(const char *block, Tile &t)
+void ZOH::decompresstwo(const char *block, const Options &options, Tile &t)
 {
     Bits in(block, ZOH::BITSIZE);
 
@@ -454,11 +454,11 @@ void ZOH::decompresstwo(const char *block, Tile &t)
         return;
     }
 
-    decompress_endpts(compr_endpts, endpts, p);
+    decompress_endpts(compr_endpts, endpts, p, options.format);
 
     Vector3 palette[NREGIONS_TWO][NINDICES];
     for (int r = 0; r < NREGIONS_TWO; ++r)
-        generate_palette_quantized(endpts[r], p.chan[0].prec[0], &palette[r][0]);
+        generate_palette_quantized(endpts[r], p.chan[0].prec[0], options.format, &palette[r][0]);
 
     int indices[Tile::TILE_H][Tile::TILE_W];
 
@@ -473,13 +473,13 @@ void ZOH::decompresstwo(const char *block, Tile &t)
 }
 
 // given a collection of colors and quantized endpoints, generate a palette, choose best entries, and return a single toterr
-static float map_colors(const Vector3 colors[], const float importance[], int np, const IntEndpts &endpts, int prec)
+static float map_colors(const Vector3 colors[], const float importance[], int np, const IntEndpts &endpts, int prec, Format format)
 {
     Vector3 palette[NINDICES];
     float toterr = 0;
     Vector3 err;
 
-    generate_palette_quantized(endpts, prec, palette);
+    generate_palette_quantized(endpts, prec, format, palette);
 
     for (int i = 0; i < np; ++i)
     {
@@ -502,7 +502,7 @@ static float map_colors(const Vector3 colors[], const float importance[], int np
 }
 
 // assign indices given a tile, shape, and quantized endpoints, return toterr for each region
-static void assign_indices(const Tile &tile, int shapeindex, IntEndpts endpts[NREGIONS_TWO], int prec, 
+static void assign_indices(const Tile &tile, int shapeindex, IntEndpts endpts[NREGIONS_TWO], int prec, Format format,
                            int indices[Tile::TILE_H][Tile::TILE_W], float toterr[NREGIONS_TWO])
 {
     // build list of possibles
@@ -510,7 +510,7 @@ static void assign_indices(const Tile &tile, int shapeindex, IntEndpts endpts[NR
 
     for (int region = 0; region < NREGIONS_TWO; ++region)
     {
-        generate_palette_quantized(endpts[region], prec, &palette[region][0]);
+        generate_palette_quantized(endpts[region], prec, format, &palette[region][0]);
         toterr[region] = 0;
     }
 
@@ -541,7 +541,7 @@ static void assign_indices(const Tile &tile, int shapeindex, IntEndpts endpts[NR
     }
 }
 
-static float perturb_one(const Vector3 colors[], const float importance[], int np, int ch, int prec, const IntEndpts &old_endpts, IntEndpts &new_endpts,
+static float perturb_one(const Vector3 colors[], const float importance[], int np, int ch, int prec, Format format, const IntEndpts &old_endpts, IntEndpts &new_endpts,
                           float old_err, int do_b)
 {
     // we have the old endpoints: old_endpts
@@ -574,7 +574,7 @@ static float perturb_one(const Vector3 colors[], const float importance[], int n
                     continue;
             }
 
-            float err = map_colors(colors, importance, np, temp_endpts, prec);
+            float err = map_colors(colors, importance, np, temp_endpts, prec, format);
 
             if (err < min_err)
             {
@@ -595,7 +595,7 @@ static float perturb_one(const Vector3 colors[], const float importance[], int n
     return min_err;
 }
 
-static void optimize_one(const Vector3 colors[], const float importance[], int np, float orig_err, const IntEndpts &orig_endpts, int prec, IntEndpts &opt_endpts)
+static void optimize_one(const Vector3 colors[], const float importance[], int np, float orig_err, const IntEndpts &orig_endpts, int prec, Format format, IntEndpts &opt_endpts)
 {
     float opt_err = orig_err;
     for (int ch = 0; ch < NCHANNELS; ++ch)
@@ -630,8 +630,8 @@ static void optimize_one(const Vector3 colors[], const float importance[], int n
     {
         // figure out which endpoint when perturbed gives the most improvement and start there
         // if we just alternate, we can easily end up in a local minima
-        float err0 = perturb_one(colors, importance, np, ch, prec, opt_endpts, new_a, opt_err, 0);	// perturb endpt A
-        float err1 = perturb_one(colors, importance, np, ch, prec, opt_endpts, new_b, opt_err, 1);	// perturb endpt B
+        float err0 = perturb_one(colors, importance, np, ch, prec, format, opt_endpts, new_a, opt_err, 0);	// perturb endpt A
+        float err1 = perturb_one(colors, importance, np, ch, prec, format, opt_endpts, new_b, opt_err, 1);	// perturb endpt B
 
         if (err0 < err1)
         {
@@ -654,7 +654,7 @@ static void optimize_one(const Vector3 colors[], const float importance[], int n
         // now alternate endpoints and keep trying until there is no improvement
         for (;;)
         {
-            float err = perturb_one(colors, importance, np, ch, prec, opt_endpts, new_endpt, opt_err, do_b);
+            float err = perturb_one(colors, importance, np, ch, prec, format, opt_endpts, new_endpt, opt_err, do_b);
             if (err >= opt_err)
                 break;
             if (do_b == 0)
@@ -668,7 +668,7 @@ static void optimize_one(const Vector3 colors[], const float importance[], int n
 }
 
 static void optimize_endpts(const Tile &tile, int shapeindex, const float orig_err[NREGIONS_TWO], 
-                            const IntEndpts orig_endpts[NREGIONS_TWO], int prec, IntEndpts opt_endpts[NREGIONS_TWO])
+                            const IntEndpts orig_endpts[NREGIONS_TWO], int prec, Format format, IntEndpts opt_endpts[NREGIONS_TWO])
 {
     Vector3 pixels[Tile::TILE_TOTAL];
     float importance[Tile::TILE_TOTAL];
@@ -688,7 +688,7 @@ static void optimize_endpts(const Tile &tile, int shapeindex, const float orig_e
             ++np;
         }
 
-        optimize_one(pixels, importance, np, orig_err[region], orig_endpts[region], prec, opt_endpts[region]);
+        optimize_one(pixels, importance, np, orig_err[region], orig_endpts[region], prec, format, opt_endpts[region]);
     }
 }
 
@@ -709,7 +709,7 @@ static void optimize_endpts(const Tile &tile, int shapeindex, const float orig_e
                 emit compressed block with original data // to try to preserve maximum endpoint precision
 */
 
-float ZOH::refinetwo(const Tile &tile, int shapeindex_best, const FltEndpts endpts[NREGIONS_TWO], char *block)
+float ZOH::refinetwo(const Tile &tile, int shapeindex_best, const FltEndpts endpts[NREGIONS_TWO], const Options &options, char *block)
 {
     float orig_err[NREGIONS_TWO], opt_err[NREGIONS_TWO], orig_toterr, opt_toterr;
     IntEndpts orig_endpts[NREGIONS_TWO], opt_endpts[NREGIONS_TWO];
@@ -721,19 +721,19 @@ float ZOH::refinetwo(const Tile &tile, int shapeindex_best, const FltEndpts endp
         // precisions for all channels need to be the same
         for (int i=1; i<NCHANNELS; ++i) nvDebugCheck (patterns[sp].chan[0].prec[0] == patterns[sp].chan[i].prec[0]);
 
-        quantize_endpts(endpts, patterns[sp].chan[0].prec[0], orig_endpts);
-        assign_indices(tile, shapeindex_best, orig_endpts, patterns[sp].chan[0].prec[0], orig_indices, orig_err);
+        quantize_endpts(endpts, patterns[sp].chan[0].prec[0], options.format, orig_endpts);
+        assign_indices(tile, shapeindex_best, orig_endpts, patterns[sp].chan[0].prec[0], options.format, orig_indices, orig_err);
         swap_indices(orig_endpts, orig_indices, shapeindex_best);
         compress_endpts(orig_endpts, compr_orig, patterns[sp]);
-        if (endpts_fit(orig_endpts, compr_orig, patterns[sp]))
+        if (endpts_fit(orig_endpts, compr_orig, patterns[sp], options.format))
         {
-            optimize_endpts(tile, shapeindex_best, orig_err, orig_endpts, patterns[sp].chan[0].prec[0], opt_endpts);
-            assign_indices(tile, shapeindex_best, opt_endpts, patterns[sp].chan[0].prec[0], opt_indices, opt_err);
+            optimize_endpts(tile, shapeindex_best, orig_err, orig_endpts, patterns[sp].chan[0].prec[0], options.format, opt_endpts);
+            assign_indices(tile, shapeindex_best, opt_endpts, patterns[sp].chan[0].prec[0], options.format, opt_indices, opt_err);
             swap_indices(opt_endpts, opt_indices, shapeindex_best);
             compress_endpts(opt_endpts, compr_opt, patterns[sp]);
             orig_toterr = opt_toterr = 0;
             for (int i=0; i < NREGIONS_TWO; ++i) { orig_toterr += orig_err[i]; opt_toterr += opt_err[i]; }
-            if (endpts_fit(opt_endpts, compr_opt, patterns[sp]) && opt_toterr < orig_toterr)
+            if (endpts_fit(opt_endpts, compr_opt, patterns[sp], options.format) && opt_toterr < orig_toterr)
             {
                 emit_block(compr_opt, shapeindex_best, patterns[sp], opt_indices, block);
                 return opt_toterr;
@@ -791,7 +791,7 @@ static float map_colors(const Tile &tile, int shapeindex, const FltEndpts endpts
     return toterr;
 }
 
-float ZOH::roughtwo(const Tile &tile, int shapeindex, FltEndpts endpts[NREGIONS_TWO])
+float ZOH::roughtwo(const Tile &tile, int shapeindex, const Options &options, FltEndpts endpts[NREGIONS_TWO])
 {
     for (int region=0; region<NREGIONS_TWO; ++region)
     {
@@ -849,35 +849,59 @@ float ZOH::roughtwo(const Tile &tile, int shapeindex, FltEndpts endpts[NREGIONS_
         // clamp endpoints
         // the argument for clamping is that the actual endpoints need to be clamped and thus we need to choose the best
         // shape based on endpoints being clamped
-        Utils::clamp(endpts[region].A);
-        Utils::clamp(endpts[region].B);
+        Utils::clamp(endpts[region].A, options.format);
+        Utils::clamp(endpts[region].B, options.format);
     }
 
     return map_colors(tile, shapeindex, endpts);
 }
 
-float ZOH::compresstwo(const Tile &t, char *block)
+static void swap(float *list1, int *list2, int i, int j)
 {
-    int shapeindex_best = 0;
-    FltEndpts endptsbest[NREGIONS_TWO], tempendpts[NREGIONS_TWO];
+    float t = list1[i]; list1[i] = list1[j]; list1[j] = t;
+    int t1 = list2[i]; list2[i] = list2[j]; list2[j] = t1;
+}
+
+float ZOH::compresstwo(const Tile &t, const Options &options, char *block)
+{
+    // number of rough cases to refine. 1 is what this always did, NSHAPES is exhaustive
+    const int NITEMS = options.refine_count < 1 ? 1 : (options.refine_count > NSHAPES ? NSHAPES : options.refine_count);
+
+    // pick the best NITEMS shapes and refine these.
+    struct {
+        FltEndpts endpts[NREGIONS_TWO];
+    } all[NSHAPES];
+    float roughmse[NSHAPES];
+    int index[NSHAPES];
+    char tempblock[ZOH::BLOCKSIZE];
     float msebest = FLT_MAX;
+    int nshapes = NSHAPES;
 
-    /*
-    collect the mse values that are within 5% of the best values
-    optimize each one and choose the best
-    */
-    // hack for now -- just use the best value WORK
-    for (int i=0; i<NSHAPES && msebest>0.0; ++i)
+    for (int i=0; i<NSHAPES; ++i)
     {
-        float mse = roughtwo(t, i, tempendpts);
+        roughmse[i] = roughtwo(t, i, options, all[i].endpts);
+        index[i] = i;
+
+        // a perfect fit can't be improved upon
+        if (roughmse[i] == 0.0f) { nshapes = i+1; break; }
+    }
+
+    // bubble sort -- only need to bubble up the first NITEMS items
+    for (int i=0; i<NITEMS && i<nshapes; ++i)
+    for (int j=i+1; j<nshapes; ++j)
+        if (roughmse[i] > roughmse[j])
+            swap(roughmse, index, i, j);
+
+    for (int i=0; i<NITEMS && i<nshapes && msebest>0; ++i)
+    {
+        int shape = index[i];
+        float mse = refinetwo(t, shape, all[shape].endpts, options, tempblock);
         if (mse < msebest)
         {
+            memcpy(block, tempblock, sizeof(tempblock));
             msebest = mse;
-            shapeindex_best = i;
-            memcpy(endptsbest, tempendpts, sizeof(endptsbest));
         }
-
     }
-    return refinetwo(t, shapeindex_best, endptsbest, block);
+    return msebest;
 }
 
@@ -22,27 +22,67 @@ See the License for the specific language governing permissions and limitations
 using namespace nv;
 using namespace AVPCL;
 
-// global flags
-bool AVPCL::flag_premult = false;
-bool AVPCL::flag_nonuniform = false;
-bool AVPCL::flag_nonuniform_ati = false;
+// true if every pixel of the tile has alpha = 255
+static bool is_opaque(const Tile &t)
+{
+	for (int y=0; y<t.size_y; ++y)
+	for (int x=0; x<t.size_x; ++x)
+		if (t.data[y][x].w != 255.0f)
+			return false;
+	return true;
+}
 
-// global mode
-bool AVPCL::mode_rgb = false;		// true if image had constant alpha = 255
+// largest range spanned by any of the channels of the tile
+static float channel_range(const Tile &t)
+{
+	Vector4 mn = t.data[0][0], mx = t.data[0][0];
+	for (int y=0; y<t.size_y; ++y)
+	for (int x=0; x<t.size_x; ++x)
+	{
+		mn = min(mn, t.data[y][x]);
+		mx = max(mx, t.data[y][x]);
+	}
+	Vector4 range = mx - mn;
+	return max(max(range.x, range.y), max(range.z, range.w));
+}
 
-void AVPCL::compress(const Tile &t, char *block)
+void AVPCL::compress(const Tile &t, const Options &tile_options, char *block)
 {
+	Options options = tile_options;
+
+	// skip the modes that cannot win on this tile:
+	// - on opaque tiles mode 7 is never better than mode 3, which has the same shapes and more color precision. modes 4
+	//   and 5 only help by rotating a color channel into the separate alpha indices.
+	// - on flat tiles the single region modes already reproduce the colors closely, a partition cannot gain much.
+	const bool opaque = options.mode_rgb || is_opaque(t);
+	const bool flat = options.flat_range > 0 && channel_range(t) <= options.flat_range;
+
+	// the premultiplied-alpha error metric is pointless if alpha is constant
+	if (opaque)
+		options.mode_rgb = true;
+	if (options.mode_rgb)
+		options.flag_premult = false;
+
 	char tempblock[AVPCL::BLOCKSIZE];
 	float msebest = FLT_MAX;
 
-	float mse_mode0 = AVPCL::compress_mode0(t, tempblock);		if(mse_mode0 < msebest) { msebest = mse_mode0; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
-	float mse_mode1 = AVPCL::compress_mode1(t, tempblock);		if(mse_mode1 < msebest) { msebest = mse_mode1; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
-	float mse_mode2 = AVPCL::compress_mode2(t, tempblock);		if(mse_mode2 < msebest) { msebest = mse_mode2; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
-	float mse_mode3 = AVPCL::compress_mode3(t, tempblock);		if(mse_mode3 < msebest) { msebest = mse_mode3; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
-	float mse_mode4 = AVPCL::compress_mode4(t, tempblock);		if(mse_mode4 < msebest) { msebest = mse_mode4; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
-	float mse_mode5 = AVPCL::compress_mode5(t, tempblock);		if(mse_mode5 < msebest) { msebest = mse_mode5; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
-	float mse_mode6 = AVPCL::compress_mode6(t, tempblock);		if(mse_mode6 < msebest) { msebest = mse_mode6; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
-	float mse_mode7 = AVPCL::compress_mode7(t, tempblock);		if(mse_mode7 < msebest) { msebest = mse_mode7; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
+	if (!flat)
+	{
+	float mse_mode0 = AVPCL::compress_mode0(t, options, tempblock);		if(mse_mode0 < msebest) { msebest = mse_mode0; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
+	float mse_mode1 = AVPCL::compress_mode1(t, options, tempblock);		if(mse_mode1 < msebest) { msebest = mse_mode1; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
+	float mse_mode2 = AVPCL::compress_mode2(t, options, tempblock);		if(mse_mode2 < msebest) { msebest = mse_mode2; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
+	float mse_mode3 = AVPCL::compress_mode3(t, options, tempblock);		if(mse_mode3 < msebest) { msebest = mse_mode3; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
+	}
+	if (!opaque || options.opaque_rotations)
+	{
+	float mse_mode4 = AVPCL::compress_mode4(t, options, tempblock);		if(mse_mode4 < msebest) { msebest = mse_mode4; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
+	float mse_mode5 = AVPCL::compress_mode5(t, options, tempblock);		if(mse_mode5 < msebest) { msebest = mse_mode5; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
+	}
+	float mse_mode6 = AVPCL::compress_mode6(t, options, tempblock);		if(mse_mode6 < msebest) { msebest = mse_mode6; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
+	if (!flat && !opaque)
+	{
+	float mse_mode7 = AVPCL::compress_mode7(t, options, tempblock);		if(mse_mode7 < msebest) { msebest = mse_mode7; memcpy(block, tempblock, AVPCL::BLOCKSIZE); }
+	}
 		
 	/*if (errfile)
 	{
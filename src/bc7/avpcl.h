@@ -28,39 +28,34 @@ static const int NREGIONS_THREE	= 3;
 static const int BLOCKSIZE=16;
 static const int BITSIZE=128;
 
-// global flags
-extern bool flag_premult;
-extern bool flag_nonuniform;
-extern bool flag_nonuniform_ati;
-
-// global mode
-extern bool mode_rgb;		// true if image had constant alpha = 255
-
-void compress(const Tile &t, char *block);
+void compress(const Tile &t, const Options &options, char *block);
 void decompress(const char *block, Tile &t);
 
-float compress_mode0(const Tile &t, char *block);
+float compress_mode0(const Tile &t, const Options &options, char *block);
 void decompress_mode0(const char *block, Tile &t);
 
-float compress_mode1(const Tile &t, char *block);
+float compress_mode1(const Tile &t, const Options &options, char *block);
 void decompress_mode1(const char *block, Tile &t);
 
-float compress_mode2(const Tile &t, char *block);
+float compress_mode2(const Tile &t, const Options &options, char *block);
 void decompress_mode2(const char *block, Tile &t);
 
-float compress_mode3(const Tile &t, char *block);
+float compress_mode3(const Tile &t, const Options &options, char *block);
 void decompress_mode3(const char *block, Tile &t);
 
-float compress_mode4(const Tile &t, char *block);
+float compress_mode4(const Tile &t, const Options &options, char *block);
 void decompress_mode4(const char *block, Tile &t);
 
-float compress_mode5(const Tile &t, char *block);
+float compress_mode5(const Tile &t, const Options &options, char *block);
 void decompress_mode5(const char *block, Tile &t);
 
-float compress_mode6(const Tile &t, char *block);
+// encode a tile of a single color with mode 5, the color is in the [0, 255] range of the tiles
+void compress_single_color(const nv::Vector4 &color, char *block);
+
+float compress_mode6(const Tile &t, const Options &options, char *block);
 void decompress_mode6(const char *block, Tile &t);
 
-float compress_mode7(const Tile &t, char *block);
+float compress_mode7(const Tile &t, const Options &options, char *block);
 void decompress_mode7(const char *block, Tile &t);
 
 inline int getmode(Bits &in)
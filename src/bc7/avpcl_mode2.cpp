@@ -342,7 +342,7 @@ void AVPCL::decompress_mode2(const char *block, Tile &t)
 }
 
 // given a collection of colors and quantized endpoints, generate a palette, choose best entries, and return a single toterr
-static float map_colors(const Vector4 colors[], const float importance[], int np, const IntEndptsRGB &endpts, const RegionPrec &region_prec, float current_err, int indices[Tile::TILE_TOTAL])
+static float map_colors(const Vector4 colors[], const float importance[], int np, const IntEndptsRGB &endpts, const RegionPrec &region_prec, float current_err, int indices[Tile::TILE_TOTAL], const Options &options)
 {
 	Vector4 palette[NINDICES];
 	float toterr = 0;
@@ -356,7 +356,7 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 
 		for (int j = 0; j < NINDICES && besterr > 0; ++j)
 		{
-			float err = Utils::metric4(colors[i], palette[j]) * importance[i];
+			float err = Utils::metric4(colors[i], palette[j], options) * importance[i];
 
 			if (err > besterr)	// error increased, so we're done searching
 				break;
@@ -383,7 +383,7 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 
 // assign indices given a tile, shape, and quantized endpoints, return toterr for each region
 static void assign_indices(const Tile &tile, int shapeindex, IntEndptsRGB endpts[NREGIONS_THREE], const PatternPrec &pattern_prec, 
-						   int indices[Tile::TILE_H][Tile::TILE_W], float toterr[NREGIONS_THREE])
+						   int indices[Tile::TILE_H][Tile::TILE_W], float toterr[NREGIONS_THREE], const Options &options)
 {
 	// build list of possibles
 	Vector4 palette[NREGIONS_THREE][NINDICES];
@@ -404,7 +404,7 @@ static void assign_indices(const Tile &tile, int shapeindex, IntEndptsRGB endpts
 
 		for (int i = 0; i < NINDICES && besterr > 0; ++i)
 		{
-			err = Utils::metric4(tile.data[y][x], palette[region][i]);
+			err = Utils::metric4(tile.data[y][x], palette[region][i], options);
 
 			if (err > besterr)	// error increased, so we're done searching
 				break;
@@ -421,7 +421,7 @@ static void assign_indices(const Tile &tile, int shapeindex, IntEndptsRGB endpts
 // note: indices are valid only if the value returned is less than old_err; otherwise they contain -1's
 // this function returns either old_err or a value smaller (if it was successful in improving the error)
 static float perturb_one(const Vector4 colors[], const float importance[], int np, int ch, const RegionPrec &region_prec, const IntEndptsRGB &old_endpts, IntEndptsRGB &new_endpts, 
-						  float old_err, int do_b, int indices[Tile::TILE_TOTAL])
+						  float old_err, int do_b, int indices[Tile::TILE_TOTAL], const Options &options)
 {
 	// we have the old endpoints: old_endpts
 	// we have the perturbed endpoints: new_endpts
@@ -459,7 +459,7 @@ static float perturb_one(const Vector4 colors[], const float importance[], int n
 					continue;
 			}
 
-			float err = map_colors(colors, importance, np, temp_endpts, region_prec, min_err, temp_indices);
+			float err = map_colors(colors, importance, np, temp_endpts, region_prec, min_err, temp_indices, options);
 
 			if (err < min_err)
 			{
@@ -491,7 +491,7 @@ static float perturb_one(const Vector4 colors[], const float importance[], int n
 // for np = 16 -- adjust error thresholds as a function of np
 // always ensure endpoint ordering is preserved (no need to overlap the scan)
 // if orig_err returned from this is less than its input value, then indices[] will contain valid indices
-static float exhaustive(const Vector4 colors[], const float importance[], int np, int ch, const RegionPrec &region_prec, float orig_err, IntEndptsRGB &opt_endpts, int indices[Tile::TILE_TOTAL])
+static float exhaustive(const Vector4 colors[], const float importance[], int np, int ch, const RegionPrec &region_prec, float orig_err, IntEndptsRGB &opt_endpts, int indices[Tile::TILE_TOTAL], const Options &options)
 {
 	IntEndptsRGB temp_endpts;
 	float best_err = orig_err;
@@ -541,7 +541,7 @@ static float exhaustive(const Vector4 colors[], const float importance[], int np
 			temp_endpts.A[ch] = a;
 			temp_endpts.B[ch] = b;
 		
-            float err = map_colors(colors, importance, np, temp_endpts, region_prec, best_err, temp_indices);
+            float err = map_colors(colors, importance, np, temp_endpts, region_prec, best_err, temp_indices, options);
 			if (err < best_err) 
 			{ 
 				amin = a; 
@@ -561,7 +561,7 @@ static float exhaustive(const Vector4 colors[], const float importance[], int np
 			temp_endpts.A[ch] = a;
 			temp_endpts.B[ch] = b;
 		
-            float err = map_colors(colors, importance, np, temp_endpts, region_prec, best_err, temp_indices);
+            float err = map_colors(colors, importance, np, temp_endpts, region_prec, best_err, temp_indices, options);
 			if (err < best_err) 
 			{ 
 				amin = a; 
@@ -584,7 +584,7 @@ static float exhaustive(const Vector4 colors[], const float importance[], int np
 	return best_err;
 }
 
-static float optimize_one(const Vector4 colors[], const float importance[], int np, float orig_err, const IntEndptsRGB &orig_endpts, const RegionPrec &region_prec, IntEndptsRGB &opt_endpts)
+static float optimize_one(const Vector4 colors[], const float importance[], int np, float orig_err, const IntEndptsRGB &orig_endpts, const RegionPrec &region_prec, IntEndptsRGB &opt_endpts, const Options &options)
 {
 	float opt_err = orig_err;
 
@@ -623,8 +623,8 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 	{
 		// figure out which endpoint when perturbed gives the most improvement and start there
 		// if we just alternate, we can easily end up in a local minima
-		float err0 = perturb_one(colors, importance, np, ch, region_prec, opt_endpts, new_a, opt_err, 0, temp_indices0);	// perturb endpt A
-        float err1 = perturb_one(colors, importance, np, ch, region_prec, opt_endpts, new_b, opt_err, 1, temp_indices1);	// perturb endpt B
+		float err0 = perturb_one(colors, importance, np, ch, region_prec, opt_endpts, new_a, opt_err, 0, temp_indices0, options);	// perturb endpt A
+        float err1 = perturb_one(colors, importance, np, ch, region_prec, opt_endpts, new_b, opt_err, 1, temp_indices1, options);	// perturb endpt B
 
 		if (err0 < err1)
 		{
@@ -660,7 +660,7 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 		// now alternate endpoints and keep trying until there is no improvement
 		for (;;)
 		{
-            float err = perturb_one(colors, importance, np, ch, region_prec, opt_endpts, new_endpt, opt_err, do_b, temp_indices0);
+            float err = perturb_one(colors, importance, np, ch, region_prec, opt_endpts, new_endpt, opt_err, do_b, temp_indices0, options);
 			if (err >= opt_err)
 				break;
 
@@ -694,7 +694,7 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 	bool first = true;
 	for (int ch = 0; ch < NCHANNELS_RGB; ++ch)
 	{
-        float new_err = exhaustive(colors, importance, np, ch, region_prec, opt_err, opt_endpts, temp_indices0);
+        float new_err = exhaustive(colors, importance, np, ch, region_prec, opt_err, opt_endpts, temp_indices0, options);
 
 		if (new_err < opt_err)
 		{
@@ -730,7 +730,7 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 }
 
 static void optimize_endpts(const Tile &tile, int shapeindex, const float orig_err[NREGIONS_THREE], 
-							const IntEndptsRGB orig_endpts[NREGIONS_THREE], const PatternPrec &pattern_prec, float opt_err[NREGIONS], IntEndptsRGB opt_endpts[NREGIONS_THREE])
+							const IntEndptsRGB orig_endpts[NREGIONS_THREE], const PatternPrec &pattern_prec, float opt_err[NREGIONS], IntEndptsRGB opt_endpts[NREGIONS_THREE], const Options &options)
 {
 	Vector4 pixels[Tile::TILE_TOTAL];
     float importance[Tile::TILE_TOTAL];
@@ -761,7 +761,7 @@ static void optimize_endpts(const Tile &tile, int shapeindex, const float orig_e
 		float temp_in_err = orig_err[region];
 
 		// now try to optimize these endpoints
-		float temp_out_err = optimize_one(pixels, importance, np, temp_in_err, temp_in, pattern_prec.region_precs[region], temp_out);
+		float temp_out_err = optimize_one(pixels, importance, np, temp_in_err, temp_in, pattern_prec.region_precs[region], temp_out, options);
 
 		// if we find an improvement, update the best so far and correct the output endpoints and errors
 		if (temp_out_err < best_err)
@@ -790,7 +790,7 @@ static void optimize_endpts(const Tile &tile, int shapeindex, const float orig_e
 				emit compressed block with original data // to try to preserve maximum endpoint precision
 */
 
-static float refine(const Tile &tile, int shapeindex_best, const FltEndpts endpts[NREGIONS_THREE], char *block)
+static float refine(const Tile &tile, int shapeindex_best, const FltEndpts endpts[NREGIONS_THREE], char *block, const Options &options)
 {
 	float orig_err[NREGIONS_THREE], opt_err[NREGIONS_THREE], orig_toterr, opt_toterr, expected_opt_err[NREGIONS];
 	IntEndptsRGB orig_endpts[NREGIONS_THREE], opt_endpts[NREGIONS_THREE];
@@ -799,7 +799,7 @@ static float refine(const Tile &tile, int shapeindex_best, const FltEndpts endpt
 	for (int sp = 0; sp < NPATTERNS; ++sp)
 	{
 		quantize_endpts(endpts, pattern_precs[sp], orig_endpts);
-		assign_indices(tile, shapeindex_best, orig_endpts, pattern_precs[sp], orig_indices, orig_err);
+		assign_indices(tile, shapeindex_best, orig_endpts, pattern_precs[sp], orig_indices, orig_err, options);
 		swap_indices(orig_endpts, orig_indices, shapeindex_best);
 		if (patterns[sp].transformed)
 			transform_forward(orig_endpts);
@@ -809,8 +809,8 @@ static float refine(const Tile &tile, int shapeindex_best, const FltEndpts endpt
 		{
 			if (patterns[sp].transformed)
 				transform_inverse(orig_endpts);
-			optimize_endpts(tile, shapeindex_best, orig_err, orig_endpts, pattern_precs[sp], expected_opt_err, opt_endpts);
-			assign_indices(tile, shapeindex_best, opt_endpts, pattern_precs[sp], opt_indices, opt_err);
+			optimize_endpts(tile, shapeindex_best, orig_err, orig_endpts, pattern_precs[sp], expected_opt_err, opt_endpts, options);
+			assign_indices(tile, shapeindex_best, opt_endpts, pattern_precs[sp], opt_indices, opt_err, options);
 			// (nreed) Commented out asserts because they go off all the time...not sure why
 			//for (int i=0; i<NREGIONS; ++i)
 			//	nvAssert(expected_opt_err[i] == opt_err[i]);
@@ -859,7 +859,7 @@ static void generate_palette_unquantized(const FltEndpts endpts[NREGIONS_THREE],
 }
 
 // generate a palette from unquantized endpoints, then pick best palette color for all pixels in each region, return toterr for all regions combined
-static float map_colors(const Tile &tile, int shapeindex, const FltEndpts endpts[NREGIONS_THREE])
+static float map_colors(const Tile &tile, int shapeindex, const FltEndpts endpts[NREGIONS_THREE], const Options &options)
 {
 	// build list of possibles
 	Vector4 palette[NREGIONS_THREE][NINDICES];
@@ -877,7 +877,7 @@ static float map_colors(const Tile &tile, int shapeindex, const FltEndpts endpts
 
 		for (int i = 0; i < NINDICES && besterr > 0; ++i)
 		{
-			err = Utils::metric4(tile.data[y][x], palette[region][i]);
+			err = Utils::metric4(tile.data[y][x], palette[region][i], options);
 
 			if (err > besterr)	// error increased, so we're done searching. this works for most norms.
 				break;
@@ -889,7 +889,7 @@ static float map_colors(const Tile &tile, int shapeindex, const FltEndpts endpts
 	return toterr;
 }
 
-static float rough(const Tile &tile, int shapeindex, FltEndpts endpts[NREGIONS_THREE])
+static float rough(const Tile &tile, int shapeindex, FltEndpts endpts[NREGIONS_THREE], const Options &options)
 {
 	for (int region=0; region<NREGIONS_THREE; ++region)
 	{
@@ -953,7 +953,7 @@ static float rough(const Tile &tile, int shapeindex, FltEndpts endpts[NREGIONS_T
 		clamp(endpts[region].B);
 	}
 
-	return map_colors(tile, shapeindex, endpts);
+	return map_colors(tile, shapeindex, endpts, options);
 }
 
 static void swap(float *list1, int *list2, int i, int j)
@@ -962,11 +962,11 @@ static void swap(float *list1, int *list2, int i, int j)
 	int t1 = list2[i]; list2[i] = list2[j]; list2[j] = t1;
 }
 
-float AVPCL::compress_mode2(const Tile &t, char *block)
+float AVPCL::compress_mode2(const Tile &t, const Options &options, char *block)
 {
 	// number of rough cases to look at. reasonable values of this are 1, NSHAPES/4, and NSHAPES
 	// NSHAPES/4 gets nearly all the cases; you can increase that a bit (say by 3 or 4) if you really want to squeeze the last bit out
-	const int NITEMS=NSHAPES/4;
+	const int NITEMS=options.refine_count(NSHAPES);
 
 	// pick the best NITEMS shapes and refine these.
 	struct {
@@ -979,7 +979,7 @@ float AVPCL::compress_mode2(const Tile &t, char *block)
 
 	for (int i=0; i<NSHAPES; ++i)
 	{
-		roughmse[i] = rough(t, i, &all[i].endpts[0]);
+		roughmse[i] = rough(t, i, &all[i].endpts[0], options);
 		index[i] = i;
 	}
 
@@ -992,7 +992,7 @@ float AVPCL::compress_mode2(const Tile &t, char *block)
 	for (int i=0; i<NITEMS && msebest>0; ++i)
 	{
 		int shape = index[i];
-		float mse = refine(t, shape, &all[shape].endpts[0], tempblock);
+		float mse = refine(t, shape, &all[shape].endpts[0], tempblock, options);
 		if (mse < msebest)
 		{
 			memcpy(block, tempblock, sizeof(tempblock));
@@ -390,7 +390,7 @@ void AVPCL::decompress_mode3(const char *block, Tile &t)
 }
 
 // given a collection of colors and quantized endpoints, generate a palette, choose best entries, and return a single toterr
-static float map_colors(const Vector4 colors[], const float importance[], int np, const IntEndptsRGB_2 &endpts, const RegionPrec &region_prec, float current_err, int indices[Tile::TILE_TOTAL])
+static float map_colors(const Vector4 colors[], const float importance[], int np, const IntEndptsRGB_2 &endpts, const RegionPrec &region_prec, float current_err, int indices[Tile::TILE_TOTAL], const Options &options)
 {
 	Vector4 palette[NINDICES];
 	float toterr = 0;
@@ -404,7 +404,7 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 
 		for (int j = 0; j < NINDICES && besterr > 0; ++j)
 		{
-            float err = Utils::metric4(colors[i], palette[j]) * importance[i];
+            float err = Utils::metric4(colors[i], palette[j], options) * importance[i];
 
 			if (err > besterr)	// error increased, so we're done searching
 				break;
@@ -430,7 +430,7 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 }
 
 static void assign_indices(const Tile &tile, int shapeindex, IntEndptsRGB_2 endpts[NREGIONS], const PatternPrec &pattern_prec, 
-						   int indices[Tile::TILE_H][Tile::TILE_W], float toterr[NREGIONS])
+						   int indices[Tile::TILE_H][Tile::TILE_W], float toterr[NREGIONS], const Options &options)
 {
 	// build list of possibles
 	Vector4 palette[NREGIONS][NINDICES];
@@ -451,7 +451,7 @@ static void assign_indices(const Tile &tile, int shapeindex, IntEndptsRGB_2 endp
 
 		for (int i = 0; i < NINDICES && besterr > 0; ++i)
 		{
-			err = Utils::metric4(tile.data[y][x], palette[region][i]);
+			err = Utils::metric4(tile.data[y][x], palette[region][i], options);
 
 			if (err > besterr)	// error increased, so we're done searching
 				break;
@@ -468,7 +468,7 @@ static void assign_indices(const Tile &tile, int shapeindex, IntEndptsRGB_2 endp
 // note: indices are valid only if the value returned is less than old_err; otherwise they contain -1's
 // this function returns either old_err or a value smaller (if it was successful in improving the error)
 static float perturb_one(const Vector4 colors[], const float importance[], int np, int ch, const RegionPrec &region_prec, const IntEndptsRGB_2 &old_endpts, IntEndptsRGB_2 &new_endpts, 
-						  float old_err, int do_b, int indices[Tile::TILE_TOTAL])
+						  float old_err, int do_b, int indices[Tile::TILE_TOTAL], const Options &options)
 {
 	// we have the old endpoints: old_endpts
 	// we have the perturbed endpoints: new_endpts
@@ -506,7 +506,7 @@ static float perturb_one(const Vector4 colors[], const float importance[], int n
 					continue;
 			}
 
-            float err = map_colors(colors, importance, np, temp_endpts, region_prec, min_err, temp_indices);
+            float err = map_colors(colors, importance, np, temp_endpts, region_prec, min_err, temp_indices, options);
 
 			if (err < min_err)
 			{
@@ -538,7 +538,7 @@ static float perturb_one(const Vector4 colors[], const float importance[], int n
 // for np = 16 -- adjust error thresholds as a function of np
 // always ensure endpoint ordering is preserved (no need to overlap the scan)
 // if orig_err returned from this is less than its input value, then indices[] will contain valid indices
-static float exhaustive(const Vector4 colors[], const float importance[], int np, int ch, const RegionPrec &region_prec, float &orig_err, IntEndptsRGB_2 &opt_endpts, int indices[Tile::TILE_TOTAL])
+static float exhaustive(const Vector4 colors[], const float importance[], int np, int ch, const RegionPrec &region_prec, float &orig_err, IntEndptsRGB_2 &opt_endpts, int indices[Tile::TILE_TOTAL], const Options &options)
 {
 	IntEndptsRGB_2 temp_endpts;
 	float best_err = orig_err;
@@ -588,7 +588,7 @@ static float exhaustive(const Vector4 colors[], const float importance[], int np
 			temp_endpts.A[ch] = a;
 			temp_endpts.B[ch] = b;
 		
-            float err = map_colors(colors, importance, np, temp_endpts, region_prec, best_err, temp_indices);
+            float err = map_colors(colors, importance, np, temp_endpts, region_prec, best_err, temp_indices, options);
 			if (err < best_err) 
 			{ 
 				amin = a; 
@@ -608,7 +608,7 @@ static float exhaustive(const Vector4 colors[], const float importance[], int np
 			temp_endpts.A[ch] = a;
 			temp_endpts.B[ch] = b;
 		
-            float err = map_colors(colors, importance, np, temp_endpts, region_prec, best_err, temp_indices);
+            float err = map_colors(colors, importance, np, temp_endpts, region_prec, best_err, temp_indices, options);
 			if (err < best_err) 
 			{ 
 				amin = a; 
@@ -631,7 +631,7 @@ static float exhaustive(const Vector4 colors[], const float importance[], int np
 	return best_err;
 }
 
-static float optimize_one(const Vector4 colors[], const float importance[], int np, float orig_err, const IntEndptsRGB_2 &orig_endpts, const RegionPrec &region_prec, IntEndptsRGB_2 &opt_endpts)
+static float optimize_one(const Vector4 colors[], const float importance[], int np, float orig_err, const IntEndptsRGB_2 &orig_endpts, const RegionPrec &region_prec, IntEndptsRGB_2 &opt_endpts, const Options &options)
 {
 	float opt_err = orig_err;
 
@@ -670,8 +670,8 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 	{
 		// figure out which endpoint when perturbed gives the most improvement and start there
 		// if we just alternate, we can easily end up in a local minima
-		float err0 = perturb_one(colors, importance, np, ch, region_prec, opt_endpts, new_a, opt_err, 0, temp_indices0);	// perturb endpt A
-        float err1 = perturb_one(colors, importance, np, ch, region_prec, opt_endpts, new_b, opt_err, 1, temp_indices1);	// perturb endpt B
+		float err0 = perturb_one(colors, importance, np, ch, region_prec, opt_endpts, new_a, opt_err, 0, temp_indices0, options);	// perturb endpt A
+        float err1 = perturb_one(colors, importance, np, ch, region_prec, opt_endpts, new_b, opt_err, 1, temp_indices1, options);	// perturb endpt B
 
 		if (err0 < err1)
 		{
@@ -707,7 +707,7 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 		// now alternate endpoints and keep trying until there is no improvement
 		for (;;)
 		{
-            float err = perturb_one(colors, importance, np, ch, region_prec, opt_endpts, new_endpt, opt_err, do_b, temp_indices0);
+            float err = perturb_one(colors, importance, np, ch, region_prec, opt_endpts, new_endpt, opt_err, do_b, temp_indices0, options);
 			if (err >= opt_err)
 				break;
 
@@ -741,7 +741,7 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 	bool first = true;
 	for (int ch = 0; ch < NCHANNELS_RGB; ++ch)
 	{
-        float new_err = exhaustive(colors, importance, np, ch, region_prec, opt_err, opt_endpts, temp_indices0);
+        float new_err = exhaustive(colors, importance, np, ch, region_prec, opt_err, opt_endpts, temp_indices0, options);
 
 		if (new_err < opt_err)
 		{
@@ -778,7 +778,7 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 
 // this will return a valid set of endpoints in opt_endpts regardless of whether it improve orig_endpts or not
 static void optimize_endpts(const Tile &tile, int shapeindex, const float orig_err[NREGIONS], 
-							const IntEndptsRGB_2 orig_endpts[NREGIONS], const PatternPrec &pattern_prec, float opt_err[NREGIONS], IntEndptsRGB_2 opt_endpts[NREGIONS])
+							const IntEndptsRGB_2 orig_endpts[NREGIONS], const PatternPrec &pattern_prec, float opt_err[NREGIONS], IntEndptsRGB_2 opt_endpts[NREGIONS], const Options &options)
 {
 	Vector4 pixels[Tile::TILE_TOTAL];
     float importance[Tile::TILE_TOTAL];
@@ -813,10 +813,10 @@ static void optimize_endpts(const Tile &tile, int shapeindex, const float orig_e
 			// make sure we have a valid error for temp_in
 			// we use FLT_MAX here because we want an accurate temp_in_err, no shortcuts
 			// (mapcolors will compute a mapping but will stop if the error exceeds the value passed in the FLT_MAX position)
-            float temp_in_err = map_colors(pixels, importance, np, temp_in, pattern_prec.region_precs[region], FLT_MAX, temp_indices);
+            float temp_in_err = map_colors(pixels, importance, np, temp_in, pattern_prec.region_precs[region], FLT_MAX, temp_indices, options);
 
 			// now try to optimize these endpoints
-            float temp_out_err = optimize_one(pixels, importance, np, temp_in_err, temp_in, pattern_prec.region_precs[region], temp_out);
+            float temp_out_err = optimize_one(pixels, importance, np, temp_in_err, temp_in, pattern_prec.region_precs[region], temp_out, options);
 
 			// if we find an improvement, update the best so far and correct the output endpoints and errors
 			if (temp_out_err < best_err)
@@ -846,7 +846,7 @@ static void optimize_endpts(const Tile &tile, int shapeindex, const float orig_e
 				emit compressed block with original data // to try to preserve maximum endpoint precision
 */
 
-static float refine(const Tile &tile, int shapeindex_best, const FltEndpts endpts[NREGIONS], char *block)
+static float refine(const Tile &tile, int shapeindex_best, const FltEndpts endpts[NREGIONS], char *block, const Options &options)
 {
 	float orig_err[NREGIONS], opt_err[NREGIONS], orig_toterr, opt_toterr, expected_opt_err[NREGIONS];
 	IntEndptsRGB_2 orig_endpts[NREGIONS], opt_endpts[NREGIONS];
@@ -855,7 +855,7 @@ static float refine(const Tile &tile, int shapeindex_best, const FltEndpts endpt
 	for (int sp = 0; sp < NPATTERNS; ++sp)
 	{
 		quantize_endpts(endpts, pattern_precs[sp], orig_endpts);
-		assign_indices(tile, shapeindex_best, orig_endpts, pattern_precs[sp], orig_indices, orig_err);
+		assign_indices(tile, shapeindex_best, orig_endpts, pattern_precs[sp], orig_indices, orig_err, options);
 		swap_indices(orig_endpts, orig_indices, shapeindex_best);
 		if (patterns[sp].transformed)
 			transform_forward(orig_endpts);
@@ -865,8 +865,8 @@ static float refine(const Tile &tile, int shapeindex_best, const FltEndpts endpt
 		{
 			if (patterns[sp].transformed)
 				transform_inverse(orig_endpts);
-			optimize_endpts(tile, shapeindex_best, orig_err, orig_endpts, pattern_precs[sp], expected_opt_err, opt_endpts);
-			assign_indices(tile, shapeindex_best, opt_endpts, pattern_precs[sp], opt_indices, opt_err);
+			optimize_endpts(tile, shapeindex_best, orig_err, orig_endpts, pattern_precs[sp], expected_opt_err, opt_endpts, options);
+			assign_indices(tile, shapeindex_best, opt_endpts, pattern_precs[sp], opt_indices, opt_err, options);
 			// (nreed) Commented out asserts because they go off all the time...not sure why
 			//for (int i=0; i<NREGIONS; ++i)
 			//	nvAssert(expected_opt_err[i] == opt_err[i]);
@@ -914,7 +914,7 @@ static void generate_palette_unquantized(const FltEndpts endpts[NREGIONS], Vecto
 }
 
 // generate a palette from unquantized endpoints, then pick best palette color for all pixels in each region, return toterr for all regions combined
-static float map_colors(const Tile &tile, int shapeindex, const FltEndpts endpts[NREGIONS])
+static float map_colors(const Tile &tile, int shapeindex, const FltEndpts endpts[NREGIONS], const Options &options)
 {
 	// build list of possibles
 	Vector4 palette[NREGIONS][NINDICES];
@@ -932,7 +932,7 @@ static float map_colors(const Tile &tile, int shapeindex, const FltEndpts endpts
 
 		for (int i = 0; i < NINDICES && besterr > 0; ++i)
 		{
-			err = Utils::metric4(tile.data[y][x], palette[region][i]);
+			err = Utils::metric4(tile.data[y][x], palette[region][i], options);
 
 			if (err > besterr)	// error increased, so we're done searching. this works for most norms.
 				break;
@@ -944,7 +944,7 @@ static float map_colors(const Tile &tile, int shapeindex, const FltEndpts endpts
 	return toterr;
 }
 
-static float rough(const Tile &tile, int shapeindex, FltEndpts endpts[NREGIONS])
+static float rough(const Tile &tile, int shapeindex, FltEndpts endpts[NREGIONS], const Options &options)
 {
 	for (int region=0; region<NREGIONS; ++region)
 	{
@@ -1008,7 +1008,7 @@ static float rough(const Tile &tile, int shapeindex, FltEndpts endpts[NREGIONS])
 		clamp(endpts[region].B);
 	}
 
-	return map_colors(tile, shapeindex, endpts);
+	return map_colors(tile, shapeindex, endpts, options);
 }
 
 static void swap(float *list1, int *list2, int i, int j)
@@ -1017,11 +1017,11 @@ static void swap(float *list1, int *list2, int i, int j)
 	int t1 = list2[i]; list2[i] = list2[j]; list2[j] = t1;
 }
 
-float AVPCL::compress_mode3(const Tile &t, char *block)
+float AVPCL::compress_mode3(const Tile &t, const Options &options, char *block)
 {
 	// number of rough cases to look at. reasonable values of this are 1, NSHAPES/4, and NSHAPES
 	// NSHAPES/4 gets nearly all the cases; you can increase that a bit (say by 3 or 4) if you really want to squeeze the last bit out
-	const int NITEMS=NSHAPES/4;
+	const int NITEMS=options.refine_count(NSHAPES);
 
 	// pick the best NITEMS shapes and refine these.
 	struct {
@@ -1034,7 +1034,7 @@ float AVPCL::compress_mode3(const Tile &t, char *block)
 
 	for (int i=0; i<NSHAPES; ++i)
 	{
-		roughmse[i] = rough(t, i, &all[i].endpts[0]);
+		roughmse[i] = rough(t, i, &all[i].endpts[0], options);
 		index[i] = i;
 	}
 
@@ -1047,7 +1047,7 @@ float AVPCL::compress_mode3(const Tile &t, char *block)
 	for (int i=0; i<NITEMS && msebest>0; ++i)
 	{
 		int shape = index[i];
-		float mse = refine(t, shape, &all[shape].endpts[0], tempblock);
+		float mse = refine(t, shape, &all[shape].endpts[0], tempblock, options);
 		if (mse < msebest)
 		{
 			memcpy(block, tempblock, sizeof(tempblock));
@@ -422,7 +422,7 @@ void AVPCL::decompress_mode4(const char *block, Tile &t)
 // given a collection of colors and quantized endpoints, generate a palette, choose best entries, and return a single toterr
 // we already have a candidate mapping when we call this function, thus an error. take an early exit if the accumulated error so far
 // exceeds what we already have
-static float map_colors(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, const IntEndptsRGBA &endpts, const RegionPrec &region_prec, float current_besterr, int indices[NINDEXARRAYS][Tile::TILE_TOTAL])
+static float map_colors(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, const IntEndptsRGBA &endpts, const RegionPrec &region_prec, float current_besterr, int indices[NINDEXARRAYS][Tile::TILE_TOTAL], const Options &options)
 {
 	Vector3 palette_rgb[NINDICES3];	// could be nindices2
 	float palette_a[NINDICES3];	// could be nindices2
@@ -438,7 +438,7 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 		float err, besterr;
 		float palette_alpha = 0, tile_alpha = 0;
 
-		if(AVPCL::flag_premult)
+		if(options.flag_premult)
 				tile_alpha = (rotatemode == ROTATEMODE_RGBA_AGBR) ? (colors[i]).x :
 							 (rotatemode == ROTATEMODE_RGBA_RABG) ? (colors[i]).y :
 							 (rotatemode == ROTATEMODE_RGBA_RGAB) ? (colors[i]).z : (colors[i]).w;
@@ -458,7 +458,7 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 			besterr = FLT_MAX;
 			for (int j = 0; j < NINDICES_A(indexmode) && besterr > 0; ++j)
 			{
-				err = Utils::metric1(a, palette_a[j], rotatemode);
+				err = Utils::metric1(a, palette_a[j], rotatemode, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -475,8 +475,8 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 			besterr = FLT_MAX;
 			for (int j = 0; j < NINDICES_RGB(indexmode) && besterr > 0; ++j)
 			{
-				err = !AVPCL::flag_premult ? Utils::metric3(rgb, palette_rgb[j], rotatemode) :
-											 Utils::metric3premult_alphaout(rgb, tile_alpha, palette_rgb[j], palette_alpha);
+				err = !options.flag_premult ? Utils::metric3(rgb, palette_rgb[j], rotatemode, options) :
+											 Utils::metric3premult_alphaout(rgb, tile_alpha, palette_rgb[j], palette_alpha, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -505,8 +505,8 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 			int bestindex;
 			for (int j = 0; j < NINDICES_RGB(indexmode) && besterr > 0; ++j)
 			{
-				err = !AVPCL::flag_premult ? Utils::metric3(rgb, palette_rgb[j], rotatemode) :
-											 Utils::metric3premult_alphain(rgb, palette_rgb[j], rotatemode);
+				err = !options.flag_premult ? Utils::metric3(rgb, palette_rgb[j], rotatemode, options) :
+											 Utils::metric3premult_alphain(rgb, palette_rgb[j], rotatemode, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -526,8 +526,8 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 			besterr = FLT_MAX;
 			for (int j = 0; j < NINDICES_A(indexmode) && besterr > 0; ++j)
 			{
-				err = !AVPCL::flag_premult ? Utils::metric1(a, palette_a[j], rotatemode) :
-											 Utils::metric1premult(a, tile_alpha, palette_a[j], palette_alpha, rotatemode);
+				err = !options.flag_premult ? Utils::metric1(a, palette_a[j], rotatemode, options) :
+											 Utils::metric1premult(a, tile_alpha, palette_a[j], palette_alpha, rotatemode, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -555,7 +555,7 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 
 // assign indices given a tile, shape, and quantized endpoints, return toterr for each region
 static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int indexmode, IntEndptsRGBA endpts[NREGIONS], const PatternPrec &pattern_prec, 
-						   int indices[NINDEXARRAYS][Tile::TILE_H][Tile::TILE_W], float toterr[NREGIONS])
+						   int indices[NINDEXARRAYS][Tile::TILE_H][Tile::TILE_W], float toterr[NREGIONS], const Options &options)
 {
 	Vector3 palette_rgb[NREGIONS][NINDICES3];	// could be nindices2
 	float palette_a[NREGIONS][NINDICES3];	// could be nindices2
@@ -581,7 +581,7 @@ static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int
 		rgb.z = (tile.data[y][x]).z;
 		a = (tile.data[y][x]).w;
 
-		if(AVPCL::flag_premult)
+		if(options.flag_premult)
 				tile_alpha = (rotatemode == ROTATEMODE_RGBA_AGBR) ? (tile.data[y][x]).x :
 							 (rotatemode == ROTATEMODE_RGBA_RABG) ? (tile.data[y][x]).y :
 							 (rotatemode == ROTATEMODE_RGBA_RGAB) ? (tile.data[y][x]).z : (tile.data[y][x]).w;
@@ -596,7 +596,7 @@ static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int
 			besterr = FLT_MAX;
 			for (int i = 0; i < NINDICES_A(indexmode) && besterr > 0; ++i)
 			{
-				err = Utils::metric1(a, palette_a[region][i], rotatemode);
+				err = Utils::metric1(a, palette_a[region][i], rotatemode, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -613,8 +613,8 @@ static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int
 			besterr = FLT_MAX;
 			for (int i = 0; i < NINDICES_RGB(indexmode) && besterr > 0; ++i)
 			{
-				err = !AVPCL::flag_premult ? Utils::metric3(rgb, palette_rgb[region][i], rotatemode) :
-											 Utils::metric3premult_alphaout(rgb, tile_alpha, palette_rgb[region][i], palette_alpha);
+				err = !options.flag_premult ? Utils::metric3(rgb, palette_rgb[region][i], rotatemode, options) :
+											 Utils::metric3premult_alphaout(rgb, tile_alpha, palette_rgb[region][i], palette_alpha, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -633,8 +633,8 @@ static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int
 			int bestindex;
 			for (int i = 0; i < NINDICES_RGB(indexmode) && besterr > 0; ++i)
 			{
-				err = !AVPCL::flag_premult ? Utils::metric3(rgb, palette_rgb[region][i], rotatemode) :
-											 Utils::metric3premult_alphain(rgb, palette_rgb[region][i], rotatemode);
+				err = !options.flag_premult ? Utils::metric3(rgb, palette_rgb[region][i], rotatemode, options) :
+											 Utils::metric3premult_alphain(rgb, palette_rgb[region][i], rotatemode, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -654,8 +654,8 @@ static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int
 			besterr = FLT_MAX;
 			for (int i = 0; i < NINDICES_A(indexmode) && besterr > 0; ++i)
 			{
-				err = !AVPCL::flag_premult ? Utils::metric1(a, palette_a[region][i], rotatemode) :
-											 Utils::metric1premult(a, tile_alpha, palette_a[region][i], palette_alpha, rotatemode);
+				err = !options.flag_premult ? Utils::metric1(a, palette_a[region][i], rotatemode, options) :
+											 Utils::metric1premult(a, tile_alpha, palette_a[region][i], palette_alpha, rotatemode, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -673,7 +673,7 @@ static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int
 // note: indices are valid only if the value returned is less than old_err; otherwise they contain -1's
 // this function returns either old_err or a value smaller (if it was successful in improving the error)
 static float perturb_one(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, int ch, const RegionPrec &region_prec, const IntEndptsRGBA &old_endpts, IntEndptsRGBA &new_endpts, 
-						  float old_err, int do_b, int indices[NINDEXARRAYS][Tile::TILE_TOTAL])
+						  float old_err, int do_b, int indices[NINDEXARRAYS][Tile::TILE_TOTAL], const Options &options)
 {
 	// we have the old endpoints: old_endpts
 	// we have the perturbed endpoints: new_endpts
@@ -712,7 +712,7 @@ static float perturb_one(const Vector4 colors[], const float importance[], int n
 					continue;
 			}
 
-            float err = map_colors(colors, importance, np, rotatemode, indexmode, temp_endpts, region_prec, min_err, temp_indices);
+            float err = map_colors(colors, importance, np, rotatemode, indexmode, temp_endpts, region_prec, min_err, temp_indices, options);
 
 			if (err < min_err)
 			{
@@ -744,7 +744,7 @@ static float perturb_one(const Vector4 colors[], const float importance[], int n
 // if err > 40  6.25%
 // for np = 16 -- adjust error thresholds as a function of np
 // always ensure endpoint ordering is preserved (no need to overlap the scan)
-static float exhaustive(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, int ch, const RegionPrec &region_prec, float orig_err, IntEndptsRGBA &opt_endpts, int indices[NINDEXARRAYS][Tile::TILE_TOTAL])
+static float exhaustive(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, int ch, const RegionPrec &region_prec, float orig_err, IntEndptsRGBA &opt_endpts, int indices[NINDEXARRAYS][Tile::TILE_TOTAL], const Options &options)
 {
 	IntEndptsRGBA temp_endpts;
 	float best_err = orig_err;
@@ -795,7 +795,7 @@ static float exhaustive(const Vector4 colors[], const float importance[], int np
 			temp_endpts.A[ch] = a;
 			temp_endpts.B[ch] = b;
 		
-            float err = map_colors(colors, importance, np, rotatemode, indexmode, temp_endpts, region_prec, best_err, temp_indices);
+            float err = map_colors(colors, importance, np, rotatemode, indexmode, temp_endpts, region_prec, best_err, temp_indices, options);
 			if (err < best_err) 
 			{ 
 				amin = a; 
@@ -816,7 +816,7 @@ static float exhaustive(const Vector4 colors[], const float importance[], int np
 			temp_endpts.A[ch] = a;
 			temp_endpts.B[ch] = b;
 		
-            float err = map_colors(colors, importance, np, rotatemode, indexmode, temp_endpts, region_prec, best_err, temp_indices);
+            float err = map_colors(colors, importance, np, rotatemode, indexmode, temp_endpts, region_prec, best_err, temp_indices, options);
 			if (err < best_err) 
 			{ 
 				amin = a; 
@@ -841,7 +841,7 @@ static float exhaustive(const Vector4 colors[], const float importance[], int np
 	return best_err;
 }
 
-static float optimize_one(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, float orig_err, const IntEndptsRGBA &orig_endpts, const RegionPrec &region_prec, IntEndptsRGBA &opt_endpts)
+static float optimize_one(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, float orig_err, const IntEndptsRGBA &orig_endpts, const RegionPrec &region_prec, IntEndptsRGBA &opt_endpts, const Options &options)
 {
 	float opt_err = orig_err;
 
@@ -878,8 +878,8 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 	{
 		// figure out which endpoint when perturbed gives the most improvement and start there
 		// if we just alternate, we can easily end up in a local minima
-		float err0 = perturb_one(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_endpts, new_a, opt_err, 0, temp_indices0);	// perturb endpt A
-        float err1 = perturb_one(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_endpts, new_b, opt_err, 1, temp_indices1);	// perturb endpt B
+		float err0 = perturb_one(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_endpts, new_a, opt_err, 0, temp_indices0, options);	// perturb endpt A
+        float err1 = perturb_one(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_endpts, new_b, opt_err, 1, temp_indices1, options);	// perturb endpt B
 
 		if (err0 < err1)
 		{
@@ -917,7 +917,7 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 		// now alternate endpoints and keep trying until there is no improvement
 		for (;;)
 		{
-            float err = perturb_one(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_endpts, new_endpt, opt_err, do_b, temp_indices0);
+            float err = perturb_one(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_endpts, new_endpt, opt_err, do_b, temp_indices0, options);
 			if (err >= opt_err)
 				break;
 
@@ -950,7 +950,7 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 	bool first = true;
 	for (int ch = 0; ch < NCHANNELS_RGBA; ++ch)
 	{
-        float new_err = exhaustive(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_err, opt_endpts, temp_indices0);
+        float new_err = exhaustive(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_err, opt_endpts, temp_indices0, options);
 
 		if (new_err < opt_err)
 		{
@@ -987,7 +987,7 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 }
 
 static void optimize_endpts(const Tile &tile, int shapeindex, int rotatemode, int indexmode, const float orig_err[NREGIONS], 
-							const IntEndptsRGBA orig_endpts[NREGIONS], const PatternPrec &pattern_prec, float opt_err[NREGIONS], IntEndptsRGBA opt_endpts[NREGIONS])
+							const IntEndptsRGBA orig_endpts[NREGIONS], const PatternPrec &pattern_prec, float opt_err[NREGIONS], IntEndptsRGBA opt_endpts[NREGIONS], const Options &options)
 {
 	Vector4 pixels[Tile::TILE_TOTAL];
     float importance[Tile::TILE_TOTAL];
@@ -1018,7 +1018,7 @@ static void optimize_endpts(const Tile &tile, int shapeindex, int rotatemode, in
 		float temp_in_err = orig_err[region];
 
 		// now try to optimize these endpoints
-        float temp_out_err = optimize_one(pixels, importance, np, rotatemode, indexmode, temp_in_err, temp_in, pattern_prec.region_precs[region], temp_out);
+        float temp_out_err = optimize_one(pixels, importance, np, rotatemode, indexmode, temp_in_err, temp_in, pattern_prec.region_precs[region], temp_out, options);
 
 		// if we find an improvement, update the best so far and correct the output endpoints and errors
 		if (temp_out_err < best_err)
@@ -1047,7 +1047,7 @@ static void optimize_endpts(const Tile &tile, int shapeindex, int rotatemode, in
 				emit compressed block with original data // to try to preserve maximum endpoint precision
 */
 
-static float refine(const Tile &tile, int shapeindex_best, int rotatemode, int indexmode, const FltEndpts endpts[NREGIONS], char *block)
+static float refine(const Tile &tile, int shapeindex_best, int rotatemode, int indexmode, const FltEndpts endpts[NREGIONS], char *block, const Options &options)
 {
 	float orig_err[NREGIONS], opt_err[NREGIONS], orig_toterr, opt_toterr, expected_opt_err[NREGIONS];
 	IntEndptsRGBA orig_endpts[NREGIONS], opt_endpts[NREGIONS];
@@ -1057,7 +1057,7 @@ static float refine(const Tile &tile, int shapeindex_best, int rotatemode, int i
 	{
 		quantize_endpts(endpts, pattern_precs[sp], orig_endpts);
 
-		assign_indices(tile, shapeindex_best, rotatemode, indexmode, orig_endpts, pattern_precs[sp], orig_indices, orig_err);
+		assign_indices(tile, shapeindex_best, rotatemode, indexmode, orig_endpts, pattern_precs[sp], orig_indices, orig_err, options);
 		swap_indices(shapeindex_best, indexmode, orig_endpts, orig_indices);
 
 		if (patterns[sp].transform_mode)
@@ -1070,9 +1070,9 @@ static float refine(const Tile &tile, int shapeindex_best, int rotatemode, int i
 			if (patterns[sp].transform_mode)
 				transform_inverse(patterns[sp].transform_mode, orig_endpts);
 
-			optimize_endpts(tile, shapeindex_best, rotatemode, indexmode, orig_err, orig_endpts, pattern_precs[sp], expected_opt_err, opt_endpts);
+			optimize_endpts(tile, shapeindex_best, rotatemode, indexmode, orig_err, orig_endpts, pattern_precs[sp], expected_opt_err, opt_endpts, options);
 
-			assign_indices(tile, shapeindex_best, rotatemode, indexmode, opt_endpts, pattern_precs[sp], opt_indices, opt_err);
+			assign_indices(tile, shapeindex_best, rotatemode, indexmode, opt_endpts, pattern_precs[sp], opt_indices, opt_err, options);
 			// (nreed) Commented out asserts because they go off all the time...not sure why
 			//for (int i=0; i<NREGIONS; ++i)
 			//	nvAssert(expected_opt_err[i] == opt_err[i]);
@@ -1187,7 +1187,7 @@ static void rough(const Tile &tile, int shapeindex, FltEndpts endpts[NREGIONS])
 	}
 }
 
-float AVPCL::compress_mode4(const Tile &t, char *block)
+float AVPCL::compress_mode4(const Tile &t, const Options &options, char *block)
 {
 	FltEndpts endpts[NREGIONS];
 	char tempblock[AVPCL::BLOCKSIZE];
@@ -1202,7 +1202,7 @@ float AVPCL::compress_mode4(const Tile &t, char *block)
 		rough(t1, shape, endpts);
 		for (int i = 0; i < NINDEXMODES && msebest > 0; ++i)
 		{
-			float mse = refine(t1, shape, r, i, endpts, tempblock);
+			float mse = refine(t1, shape, r, i, endpts, tempblock, options);
 			if (mse < msebest)
 			{
 				memcpy(block, tempblock, sizeof(tempblock));
@@ -423,7 +423,7 @@ void AVPCL::decompress_mode5(const char *block, Tile &t)
 // given a collection of colors and quantized endpoints, generate a palette, choose best entries, and return a single toterr
 // we already have a candidate mapping when we call this function, thus an error. take an early exit if the accumulated error so far
 // exceeds what we already have
-static float map_colors(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, const IntEndptsRGBA &endpts, const RegionPrec &region_prec, float current_besterr, int indices[NINDEXARRAYS][Tile::TILE_TOTAL])
+static float map_colors(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, const IntEndptsRGBA &endpts, const RegionPrec &region_prec, float current_besterr, int indices[NINDEXARRAYS][Tile::TILE_TOTAL], const Options &options)
 {
 	Vector3 palette_rgb[NINDICES3];	// could be nindices2
 	float palette_a[NINDICES3];	// could be nindices2
@@ -439,7 +439,7 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 		float err, besterr;
 		float palette_alpha = 0, tile_alpha = 0;
 
-		if(AVPCL::flag_premult)
+		if(options.flag_premult)
 				tile_alpha = (rotatemode == ROTATEMODE_RGBA_AGBR) ? (colors[i]).x :
 							 (rotatemode == ROTATEMODE_RGBA_RABG) ? (colors[i]).y :
 							 (rotatemode == ROTATEMODE_RGBA_RGAB) ? (colors[i]).z : (colors[i]).w;
@@ -459,7 +459,7 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 			besterr = FLT_MAX;
 			for (int j = 0; j < NINDICES_A(indexmode) && besterr > 0; ++j)
 			{
-				err = Utils::metric1(a, palette_a[j], rotatemode);
+				err = Utils::metric1(a, palette_a[j], rotatemode, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -476,8 +476,8 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 			besterr = FLT_MAX;
 			for (int j = 0; j < NINDICES_RGB(indexmode) && besterr > 0; ++j)
 			{
-				err = !AVPCL::flag_premult ? Utils::metric3(rgb, palette_rgb[j], rotatemode) :
-											 Utils::metric3premult_alphaout(rgb, tile_alpha, palette_rgb[j], palette_alpha);
+				err = !options.flag_premult ? Utils::metric3(rgb, palette_rgb[j], rotatemode, options) :
+											 Utils::metric3premult_alphaout(rgb, tile_alpha, palette_rgb[j], palette_alpha, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -506,8 +506,8 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 			int bestindex;
 			for (int j = 0; j < NINDICES_RGB(indexmode) && besterr > 0; ++j)
 			{
-				err = !AVPCL::flag_premult ? Utils::metric3(rgb, palette_rgb[j], rotatemode) :
-											 Utils::metric3premult_alphain(rgb, palette_rgb[j], rotatemode);
+				err = !options.flag_premult ? Utils::metric3(rgb, palette_rgb[j], rotatemode, options) :
+											 Utils::metric3premult_alphain(rgb, palette_rgb[j], rotatemode, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -527,8 +527,8 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 			besterr = FLT_MAX;
 			for (int j = 0; j < NINDICES_A(indexmode) && besterr > 0; ++j)
 			{
-				err = !AVPCL::flag_premult ? Utils::metric1(a, palette_a[j], rotatemode) :
-											 Utils::metric1premult(a, tile_alpha, palette_a[j], palette_alpha, rotatemode);
+				err = !options.flag_premult ? Utils::metric1(a, palette_a[j], rotatemode, options) :
+											 Utils::metric1premult(a, tile_alpha, palette_a[j], palette_alpha, rotatemode, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -556,7 +556,7 @@ static float map_colors(const Vector4 colors[], const float importance[], int np
 
 // assign indices given a tile, shape, and quantized endpoints, return toterr for each region
 static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int indexmode, IntEndptsRGBA endpts[NREGIONS], const PatternPrec &pattern_prec, 
-						   int indices[NINDEXARRAYS][Tile::TILE_H][Tile::TILE_W], float toterr[NREGIONS])
+						   int indices[NINDEXARRAYS][Tile::TILE_H][Tile::TILE_W], float toterr[NREGIONS], const Options &options)
 {
 	Vector3 palette_rgb[NREGIONS][NINDICES3];	// could be nindices2
 	float palette_a[NREGIONS][NINDICES3];	// could be nindices2
@@ -582,7 +582,7 @@ static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int
 		rgb.z = (tile.data[y][x]).z;
 		a = (tile.data[y][x]).w;
 
-		if(AVPCL::flag_premult)
+		if(options.flag_premult)
 				tile_alpha = (rotatemode == ROTATEMODE_RGBA_AGBR) ? (tile.data[y][x]).x :
 							 (rotatemode == ROTATEMODE_RGBA_RABG) ? (tile.data[y][x]).y :
 							 (rotatemode == ROTATEMODE_RGBA_RGAB) ? (tile.data[y][x]).z : (tile.data[y][x]).w;
@@ -597,7 +597,7 @@ static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int
 			besterr = FLT_MAX;
 			for (int i = 0; i < NINDICES_A(indexmode) && besterr > 0; ++i)
 			{
-				err = Utils::metric1(a, palette_a[region][i], rotatemode);
+				err = Utils::metric1(a, palette_a[region][i], rotatemode, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -614,8 +614,8 @@ static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int
 			besterr = FLT_MAX;
 			for (int i = 0; i < NINDICES_RGB(indexmode) && besterr > 0; ++i)
 			{
-				err = !AVPCL::flag_premult ? Utils::metric3(rgb, palette_rgb[region][i], rotatemode) :
-											 Utils::metric3premult_alphaout(rgb, tile_alpha, palette_rgb[region][i], palette_alpha);
+				err = !options.flag_premult ? Utils::metric3(rgb, palette_rgb[region][i], rotatemode, options) :
+											 Utils::metric3premult_alphaout(rgb, tile_alpha, palette_rgb[region][i], palette_alpha, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -634,8 +634,8 @@ static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int
 			int bestindex;
 			for (int i = 0; i < NINDICES_RGB(indexmode) && besterr > 0; ++i)
 			{
-				err = !AVPCL::flag_premult ? Utils::metric3(rgb, palette_rgb[region][i], rotatemode) :
-											 Utils::metric3premult_alphain(rgb, palette_rgb[region][i], rotatemode);
+				err = !options.flag_premult ? Utils::metric3(rgb, palette_rgb[region][i], rotatemode, options) :
+											 Utils::metric3premult_alphain(rgb, palette_rgb[region][i], rotatemode, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -655,8 +655,8 @@ static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int
 			besterr = FLT_MAX;
 			for (int i = 0; i < NINDICES_A(indexmode) && besterr > 0; ++i)
 			{
-				err = !AVPCL::flag_premult ? Utils::metric1(a, palette_a[region][i], rotatemode) :
-											 Utils::metric1premult(a, tile_alpha, palette_a[region][i], palette_alpha, rotatemode);
+				err = !options.flag_premult ? Utils::metric1(a, palette_a[region][i], rotatemode, options) :
+											 Utils::metric1premult(a, tile_alpha, palette_a[region][i], palette_alpha, rotatemode, options);
 
 				if (err > besterr)	// error increased, so we're done searching
 					break;
@@ -674,7 +674,7 @@ static void assign_indices(const Tile &tile, int shapeindex, int rotatemode, int
 // note: indices are valid only if the value returned is less than old_err; otherwise they contain -1's
 // this function returns either old_err or a value smaller (if it was successful in improving the error)
 static float perturb_one(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, int ch, const RegionPrec &region_prec, const IntEndptsRGBA &old_endpts, IntEndptsRGBA &new_endpts,
-						  float old_err, int do_b, int indices[NINDEXARRAYS][Tile::TILE_TOTAL])
+						  float old_err, int do_b, int indices[NINDEXARRAYS][Tile::TILE_TOTAL], const Options &options)
 {
 	// we have the old endpoints: old_endpts
 	// we have the perturbed endpoints: new_endpts
@@ -713,7 +713,7 @@ static float perturb_one(const Vector4 colors[], const float importance[], int n
 					continue;
 			}
 
-            float err = map_colors(colors, importance, np, rotatemode, indexmode, temp_endpts, region_prec, min_err, temp_indices);
+            float err = map_colors(colors, importance, np, rotatemode, indexmode, temp_endpts, region_prec, min_err, temp_indices, options);
 
 			if (err < min_err)
 			{
@@ -745,7 +745,7 @@ static float perturb_one(const Vector4 colors[], const float importance[], int n
 // if err > 40  6.25%
 // for np = 16 -- adjust error thresholds as a function of np
 // always ensure endpoint ordering is preserved (no need to overlap the scan)
-static float exhaustive(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, int ch, const RegionPrec &region_prec, float orig_err, IntEndptsRGBA &opt_endpts, int indices[NINDEXARRAYS][Tile::TILE_TOTAL])
+static float exhaustive(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, int ch, const RegionPrec &region_prec, float orig_err, IntEndptsRGBA &opt_endpts, int indices[NINDEXARRAYS][Tile::TILE_TOTAL], const Options &options)
 {
 	IntEndptsRGBA temp_endpts;
 	float best_err = orig_err;
@@ -796,7 +796,7 @@ static float exhaustive(const Vector4 colors[], const float importance[], int np
 			temp_endpts.A[ch] = a;
 			temp_endpts.B[ch] = b;
 		
-            float err = map_colors(colors, importance, np, rotatemode, indexmode, temp_endpts, region_prec, best_err, temp_indices);
+            float err = map_colors(colors, importance, np, rotatemode, indexmode, temp_endpts, region_prec, best_err, temp_indices, options);
 			if (err < best_err) 
 			{ 
 				amin = a; 
@@ -817,7 +817,7 @@ static float exhaustive(const Vector4 colors[], const float importance[], int np
 			temp_endpts.A[ch] = a;
 			temp_endpts.B[ch] = b;
 		
-            float err = map_colors(colors, importance, np, rotatemode, indexmode, temp_endpts, region_prec, best_err, temp_indices);
+            float err = map_colors(colors, importance, np, rotatemode, indexmode, temp_endpts, region_prec, best_err, temp_indices, options);
 			if (err < best_err) 
 			{ 
 				amin = a; 
@@ -842,7 +842,7 @@ static float exhaustive(const Vector4 colors[], const float importance[], int np
 	return best_err;
 }
 
-static float optimize_one(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, float orig_err, const IntEndptsRGBA &orig_endpts, const RegionPrec &region_prec, IntEndptsRGBA &opt_endpts)
+static float optimize_one(const Vector4 colors[], const float importance[], int np, int rotatemode, int indexmode, float orig_err, const IntEndptsRGBA &orig_endpts, const RegionPrec &region_prec, IntEndptsRGBA &opt_endpts, const Options &options)
 {
 	float opt_err = orig_err;
 
@@ -879,8 +879,8 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 	{
 		// figure out which endpoint when perturbed gives the most improvement and start there
 		// if we just alternate, we can easily end up in a local minima
-        float err0 = perturb_one(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_endpts, new_a, opt_err, 0, temp_indices0);	// perturb endpt A
-        float err1 = perturb_one(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_endpts, new_b, opt_err, 1, temp_indices1);	// perturb endpt B
+        float err0 = perturb_one(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_endpts, new_a, opt_err, 0, temp_indices0, options);	// perturb endpt A
+        float err1 = perturb_one(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_endpts, new_b, opt_err, 1, temp_indices1, options);	// perturb endpt B
 
 		if (err0 < err1)
 		{
@@ -918,7 +918,7 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 		// now alternate endpoints and keep trying until there is no improvement
 		for (;;)
 		{
-            float err = perturb_one(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_endpts, new_endpt, opt_err, do_b, temp_indices0);
+            float err = perturb_one(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_endpts, new_endpt, opt_err, do_b, temp_indices0, options);
 			if (err >= opt_err)
 				break;
 
@@ -951,7 +951,7 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 	bool first = true;
 	for (int ch = 0; ch < NCHANNELS_RGBA; ++ch)
 	{
-        float new_err = exhaustive(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_err, opt_endpts, temp_indices0);
+        float new_err = exhaustive(colors, importance, np, rotatemode, indexmode, ch, region_prec, opt_err, opt_endpts, temp_indices0, options);
 
 		if (new_err < opt_err)
 		{
@@ -988,7 +988,7 @@ static float optimize_one(const Vector4 colors[], const float importance[], int
 }
 
 static void optimize_endpts(const Tile &tile, int shapeindex, int rotatemode, int indexmode, const float orig_err[NREGIONS], 
-							const IntEndptsRGBA orig_endpts[NREGIONS], const PatternPrec &pattern_prec, float opt_err[NREGIONS], IntEndptsRGBA opt_endpts[NREGIONS])
+							const IntEndptsRGBA orig_endpts[NREGIONS], const PatternPrec &pattern_prec, float opt_err[NREGIONS], IntEndptsRGBA opt_endpts[NREGIONS], const Options &options)
 {
 	Vector4 pixels[Tile::TILE_TOTAL];
     float importance[Tile::TILE_TOTAL];
@@ -1019,7 +1019,7 @@ static void optimize_endpts(const Tile &tile, int shapeindex, int rotatemode, in
 		float temp_in_err = orig_err[region];
 
 		// now try to optimize these endpoints
-        float temp_out_err = optimize_one(pixels, importance, np, rotatemode, indexmode, temp_in_err, temp_in, pattern_prec.region_precs[region], temp_out);
+        float temp_out_err = optimize_one(pixels, importance, np, rotatemode, indexmode, temp_in_err, temp_in, pattern_prec.region_precs[region], temp_out, options);
 
 		// if we find an improvement, update the best so far and correct the output endpoints and errors
 		if (temp_out_err < best_err)
@@ -1048,7 +1048,7 @@ static void optimize_endpts(const Tile &tile, int shapeindex, int rotatemode, in
 				emit compressed block with original data // to try to preserve maximum endpoint precision
 */
 
-static float refine(const Tile &tile, int shapeindex_best, int rotatemode, int indexmode, const FltEndpts endpts[NREGIONS], char *block)
+static float refine(const Tile &tile, int shapeindex_best, int rotatemode, int indexmode, const FltEndpts endpts[NREGIONS], char *block, const Options &options)
 {
 	float orig_err[NREGIONS], opt_err[NREGIONS], orig_toterr, opt_toterr, expected_opt_err[NREGIONS];
 	IntEndptsRGBA orig_endpts[NREGIONS], opt_endpts[NREGIONS];
@@ -1058,7 +1058,7 @@ static float refine(const Tile &tile, int shapeindex_best, int rotatemode, int i
 	{
 		quantize_endpts(endpts, pattern_precs[sp], orig_endpts);
 
-		assign_indices(tile, shapeindex_best, rotatemode, indexmode, orig_endpts, pattern_precs[sp], orig_indices, orig_err);
+		assign_indices(tile, shapeindex_best, rotatemode, indexmode, orig_endpts, pattern_precs[sp], orig_indices, orig_err, options);
 		swap_indices(shapeindex_best, indexmode, orig_endpts, orig_indices);
 
 		if (patterns[sp].transform_mode)
@@ -1071,9 +1071,9 @@ static float refine(const Tile &tile, int shapeindex_best, int rotatemode, int i
 			if (patterns[sp].transform_mode)
 				transform_inverse(patterns[sp].transform_mode, orig_endpts);
 
-			optimize_endpts(tile, shapeindex_best, rotatemode, indexmode, orig_err, orig_endpts, pattern_precs[sp], expected_opt_err, opt_endpts);
+			optimize_endpts(tile, shapeindex_best, rotatemode, indexmode, orig_err, orig_endpts, pattern_precs[sp], expected_opt_err, opt_endpts, options);
 
-			assign_indices(tile, shapeindex_best, rotatemode, indexmode, opt_endpts, pattern_precs[sp], opt_indices, opt_err);
+			assign_indices(tile, shapeindex_best, rotatemode, indexmode, opt_endpts, pattern_precs[sp], opt_indices, opt_err, options);
 			// (nreed) Commented out asserts because they go off all the time...not sure why
 			//for (int i=0; i<NREGIONS; ++i)
 			//	nvAssert(expected_opt_err[i] == opt_err[i]);
@@ -1188,7 +1188,58 @@ static void rough(const Tile &tile, int shapeindex, FltEndpts endpts[NREGIONS])
 	}
 }
 
-float AVPCL::compress_mode5(const Tile &t, char *block)
+// 7 bit endpoints whose interpolation at index 1 is closest to each 8 bit value, for compress_single_color
+static int single_color_endpts[256][2];
+
+static void init_single_color_endpts()
+{
+	for (int v = 0; v < 256; ++v)
+	{
+		int besterr = 256 * 256;
+		for (int a = 0; a < 128 && besterr > 0; ++a)
+		for (int b = 0; b < 128 && besterr > 0; ++b)
+		{
+			int c = Utils::lerp(Utils::unquantize(a, 7), Utils::unquantize(b, 7), 1, BIAS2, DENOM2);
+			int err = (c - v) * (c - v);
+			if (err < besterr)
+			{
+				besterr = err;
+				single_color_endpts[v][0] = a;
+				single_color_endpts[v][1] = b;
+			}
+		}
+	}
+}
+
+// a tile of a single color doesn't need a search. all the indices are the same, the color endpoints come from the
+// table and alpha uses its 8 bit value for both endpoints. the table is built the first time, not at startup.
+void AVPCL::compress_single_color(const Vector4 &color, char *block)
+{
+	static const bool initialized = (init_single_color_endpts(), true);
+	(void)initialized;
+
+	IntEndptsRGBA endpts[NREGIONS];
+	int indices[NINDEXARRAYS][Tile::TILE_H][Tile::TILE_W];
+
+	for (int i=0; i<NCHANNELS_RGB; ++i)
+	{
+		int v = clamp(int(floorf(color.component[i] + 0.5f)), 0, 255);
+		endpts[0].A[i] = single_color_endpts[v][0];
+		endpts[0].B[i] = single_color_endpts[v][1];
+	}
+	endpts[0].A[3] = endpts[0].B[3] = clamp(int(floorf(color.w + 0.5f)), 0, 255);
+
+	for (int y = 0; y < Tile::TILE_H; ++y)
+	for (int x = 0; x < Tile::TILE_W; ++x)
+	{
+		indices[INDEXARRAY_RGB][y][x] = 1;
+		indices[INDEXARRAY_A][y][x] = 0;
+	}
+
+	emit_block(endpts, 0, patterns[0], indices, ROTATEMODE_RGBA_RGBA, INDEXMODE_ALPHA_IS_3BITS, block);
+}
+
+float AVPCL::compress_mode5(const Tile &t, const Options &options, char *block)
 {
 	FltEndpts endpts[NREGIONS];
 	char tempblock[AVPCL::BLOCKSIZE];
@@ -1204,7 +1255,7 @@ float AVPCL::compress_mode5(const Tile &t, char *block)
 //		for (int i = 0; i < NINDEXMODES && msebest > 0; ++i)
 		for (int i = 0; i < 1 && msebest > 0; ++i)
 		{
-			float mse = refine(t1, shape, r, i, endpts, tempblock);
+			float mse = refine(t1, shape, r, i, endpts, tempblock, options);
 			if (mse < msebest)
 			{
 				memcpy(block, tempblock, sizeof(tempblock));
@@ -117,19 +117,19 @@ int Utils::quantize(float value, int prec)
 	return q;
 }
 
-float Utils::metric4(Vector4::Arg a, Vector4::Arg b)
+float Utils::metric4(Vector4::Arg a, Vector4::Arg b, const Options &options)
 {
 	Vector4 err = a - b;
 
 	// if nonuniform, select weights and weigh away
-	if (AVPCL::flag_nonuniform || AVPCL::flag_nonuniform_ati)
+	if (options.flag_nonuniform || options.flag_nonuniform_ati)
 	{
 		float rwt, gwt, bwt;
-		if (AVPCL::flag_nonuniform)
+		if (options.flag_nonuniform)
 		{
 			rwt = 0.299f; gwt = 0.587f; bwt = 0.114f;
 		}
-		else /*if (AVPCL::flag_nonuniform_ati)*/
+		else /*if (options.flag_nonuniform_ati)*/
 		{
 			rwt = 0.3086f; gwt = 0.6094f; bwt = 0.0820f;
 		}
@@ -144,19 +144,19 @@ float Utils::metric4(Vector4::Arg a, Vector4::Arg b)
 }
 
 // WORK -- implement rotatemode for the below -- that changes where the rwt, gwt, and bwt's go.
-float Utils::metric3(Vector3::Arg a, Vector3::Arg b, int rotatemode)
+float Utils::metric3(Vector3::Arg a, Vector3::Arg b, int rotatemode, const Options &options)
 {
 	Vector3 err = a - b;
 
 	// if nonuniform, select weights and weigh away
-	if (AVPCL::flag_nonuniform || AVPCL::flag_nonuniform_ati)
+	if (options.flag_nonuniform || options.flag_nonuniform_ati)
 	{
 		float rwt, gwt, bwt;
-		if (AVPCL::flag_nonuniform)
+		if (options.flag_nonuniform)
 		{
 			rwt = 0.299f; gwt = 0.587f; bwt = 0.114f;
 		}
-		else if (AVPCL::flag_nonuniform_ati)
+		else if (options.flag_nonuniform_ati)
 		{
 			rwt = 0.3086f; gwt = 0.6094f; bwt = 0.0820f;
 		}
@@ -180,19 +180,19 @@ float Utils::metric3(Vector3::Arg a, Vector3::Arg b, int rotatemode)
 	return lengthSquared(err);
 }
 
-float Utils::metric1(const float a, const float b, int rotatemode)
+float Utils::metric1(const float a, const float b, int rotatemode, const Options &options)
 {
 	float err = a - b;
 
 	// if nonuniform, select weights and weigh away
-	if (AVPCL::flag_nonuniform || AVPCL::flag_nonuniform_ati)
+	if (options.flag_nonuniform || options.flag_nonuniform_ati)
 	{
 		float rwt, gwt, bwt, awt;
-		if (AVPCL::flag_nonuniform)
+		if (options.flag_nonuniform)
 		{
 			rwt = 0.299f; gwt = 0.587f; bwt = 0.114f;
 		}
-		else if (AVPCL::flag_nonuniform_ati)
+		else if (options.flag_nonuniform_ati)
 		{
 			rwt = 0.3086f; gwt = 0.6094f; bwt = 0.0820f;
 		}
@@ -238,7 +238,7 @@ static void premult3(Vector3& rgb, float a)
 	rgb.z = Utils::premult(rgb.z, a);
 }
 
-float Utils::metric4premult(Vector4::Arg a, Vector4::Arg b)
+float Utils::metric4premult(Vector4::Arg a, Vector4::Arg b, const Options &options)
 {
 	Vector4 pma = a, pmb = b;
 
@@ -248,14 +248,14 @@ float Utils::metric4premult(Vector4::Arg a, Vector4::Arg b)
 	Vector4 err = pma - pmb;
 
 	// if nonuniform, select weights and weigh away
-	if (AVPCL::flag_nonuniform || AVPCL::flag_nonuniform_ati)
+	if (options.flag_nonuniform || options.flag_nonuniform_ati)
 	{
 		float rwt, gwt, bwt;
-		if (AVPCL::flag_nonuniform)
+		if (options.flag_nonuniform)
 		{
 			rwt = 0.299f; gwt = 0.587f; bwt = 0.114f;
 		}
-		else /*if (AVPCL::flag_nonuniform_ati)*/
+		else /*if (options.flag_nonuniform_ati)*/
 		{
 			rwt = 0.3086f; gwt = 0.6094f; bwt = 0.0820f;
 		}
@@ -269,7 +269,7 @@ float Utils::metric4premult(Vector4::Arg a, Vector4::Arg b)
 	return lengthSquared(err);
 }
 
-float Utils::metric3premult_alphaout(Vector3::Arg rgb0, float a0, Vector3::Arg rgb1, float a1)
+float Utils::metric3premult_alphaout(Vector3::Arg rgb0, float a0, Vector3::Arg rgb1, float a1, const Options &options)
 {
 	Vector3 pma = rgb0, pmb = rgb1;
 
@@ -279,14 +279,14 @@ float Utils::metric3premult_alphaout(Vector3::Arg rgb0, float a0, Vector3::Arg r
 	Vector3 err = pma - pmb;
 
 	// if nonuniform, select weights and weigh away
-	if (AVPCL::flag_nonuniform || AVPCL::flag_nonuniform_ati)
+	if (options.flag_nonuniform || options.flag_nonuniform_ati)
 	{
 		float rwt, gwt, bwt;
-		if (AVPCL::flag_nonuniform)
+		if (options.flag_nonuniform)
 		{
 			rwt = 0.299f; gwt = 0.587f; bwt = 0.114f;
 		}
-		else /*if (AVPCL::flag_nonuniform_ati)*/
+		else /*if (options.flag_nonuniform_ati)*/
 		{
 			rwt = 0.3086f; gwt = 0.6094f; bwt = 0.0820f;
 		}
@@ -300,7 +300,7 @@ float Utils::metric3premult_alphaout(Vector3::Arg rgb0, float a0, Vector3::Arg r
 	return lengthSquared(err);
 }
 
-float Utils::metric3premult_alphain(Vector3::Arg rgb0, Vector3::Arg rgb1, int rotatemode)
+float Utils::metric3premult_alphain(Vector3::Arg rgb0, Vector3::Arg rgb1, int rotatemode, const Options &options)
 {
 	Vector3 pma = rgb0, pmb = rgb1;
 
@@ -334,14 +334,14 @@ float Utils::metric3premult_alphain(Vector3::Arg rgb0, Vector3::Arg rgb1, int ro
 	Vector3 err = pma - pmb;
 
 	// if nonuniform, select weights and weigh away
-	if (AVPCL::flag_nonuniform || AVPCL::flag_nonuniform_ati)
+	if (options.flag_nonuniform || options.flag_nonuniform_ati)
 	{
 		float rwt, gwt, bwt;
-		if (AVPCL::flag_nonuniform)
+		if (options.flag_nonuniform)
 		{
 			rwt = 0.299f; gwt = 0.587f; bwt = 0.114f;
 		}
-		else /*if (AVPCL::flag_nonuniform_ati)*/
+		else /*if (options.flag_nonuniform_ati)*/
 		{
 			rwt = 0.3086f; gwt = 0.6094f; bwt = 0.0820f;
 		}
@@ -355,19 +355,19 @@ float Utils::metric3premult_alphain(Vector3::Arg rgb0, Vector3::Arg rgb1, int ro
 	return lengthSquared(err);
 }
 
-float Utils::metric1premult(float rgb0, float a0, float rgb1, float a1, int rotatemode)
+float Utils::metric1premult(float rgb0, float a0, float rgb1, float a1, int rotatemode, const Options &options)
 {
 	float err = premult(rgb0, a0) - premult(rgb1, a1);
 
 	// if nonuniform, select weights and weigh away
-	if (AVPCL::flag_nonuniform || AVPCL::flag_nonuniform_ati)
+	if (options.flag_nonuniform || options.flag_nonuniform_ati)
 	{
 		float rwt, gwt, bwt, awt;
-		if (AVPCL::flag_nonuniform)
+		if (options.flag_nonuniform)
 		{
 			rwt = 0.299f; gwt = 0.587f; bwt = 0.114f;
 		}
-		else if (AVPCL::flag_nonuniform_ati)
+		else if (options.flag_nonuniform_ati)
 		{
 			rwt = 0.3086f; gwt = 0.6094f; bwt = 0.0820f;
 		}
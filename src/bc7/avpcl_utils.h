@@ -32,18 +32,39 @@ static const int ROTATEMODE_RGBA_AGBR	= 1;
 static const int ROTATEMODE_RGBA_RABG	= 2;
 static const int ROTATEMODE_RGBA_RGAB	= 3;
 
+// settings of a single compress call, passed down instead of kept in globals so that tiles
+// with different settings can be compressed concurrently
+struct Options
+{
+	Options() : flag_premult(false), flag_nonuniform(false), flag_nonuniform_ati(false), mode_rgb(false),
+		shape_divisor(4), flat_range(0.0f), opaque_rotations(true) {}
+
+	bool flag_premult;			// use the premultiplied-alpha error metric
+	bool flag_nonuniform;		// weigh the color channels by luminance
+	bool flag_nonuniform_ati;	// weigh the color channels with ATI's weights
+	bool mode_rgb;				// true if image had constant alpha = 255
+
+	// search effort, see AVPCL::compress
+	int shape_divisor;			// the partitioned modes refine the best NSHAPES/shape_divisor shapes of the rough pass
+	float flat_range;			// tiles whose channels all span at most this range skip the partitioned modes
+	bool opaque_rotations;		// try modes 4 and 5 on opaque tiles, where they only help by rotating a color channel into alpha
+
+	// number of shapes refined by a mode with nshapes partitions
+	int refine_count(int nshapes) const { int n = nshapes / shape_divisor; return n < 1 ? 1 : n; }
+};
+
 class Utils
 {
 public:
 	// error metrics
-	static float metric4(nv::Vector4::Arg a, nv::Vector4::Arg b);
-	static float metric3(nv::Vector3::Arg a, nv::Vector3::Arg b, int rotatemode);
-	static float metric1(float a, float b, int rotatemode);
-
-	static float metric4premult(nv::Vector4::Arg rgba0, nv::Vector4::Arg rgba1);
-	static float metric3premult_alphaout(nv::Vector3::Arg rgb0, float a0, nv::Vector3::Arg rgb1, float a1);
-	static float metric3premult_alphain(nv::Vector3::Arg rgb0, nv::Vector3::Arg rgb1, int rotatemode);
-	static float metric1premult(float rgb0, float a0, float rgb1, float a1, int rotatemode);
+	static float metric4(nv::Vector4::Arg a, nv::Vector4::Arg b, const Options &options);
+	static float metric3(nv::Vector3::Arg a, nv::Vector3::Arg b, int rotatemode, const Options &options);
+	static float metric1(float a, float b, int rotatemode, const Options &options);
+
+	static float metric4premult(nv::Vector4::Arg rgba0, nv::Vector4::Arg rgba1, const Options &options);
+	static float metric3premult_alphaout(nv::Vector3::Arg rgb0, float a0, nv::Vector3::Arg rgb1, float a1, const Options &options);
+	static float metric3premult_alphain(nv::Vector3::Arg rgb0, nv::Vector3::Arg rgb1, int rotatemode, const Options &options);
+	static float metric1premult(float rgb0, float a0, float rgb1, float a1, int rotatemode, const Options &options);
 
 	static float premult(float r, float a);
 
@@ -18,6 +18,18 @@ namespace nv
         return h;
     }
 
+    // Same as sdbmHash, but processes the data a word at a time, which is much faster for large keys. The size must be a
+    // multiple of 4.
+    inline uint sdbmWordHash(const void * data_in, uint size, uint h = 5381)
+    {
+        const uint32 * data = (const uint32 *) data_in;
+        const uint count = size / 4;
+        for (uint i = 0; i < count; i++) {
+            h = (h << 16) + (h << 6) - h + data[i];
+        }
+        return h;
+    }
+
     // Note that this hash does not handle NaN properly.
     inline uint sdbmFloatHash(const float * f, uint count, uint h = 5381)
     {
@@ -0,0 +1,98 @@
+// This code is in the public domain -- castano@gmail.com
+
+#include "ScratchArena.h"
+#include "Memory.h"
+#include "Debug.h"
+#include "Utils.h" // max, isPowerOfTwo
+
+using namespace nv;
+
+// Alignment of the chunks, allocations with larger alignment are not supported.
+#define CHUNK_ALIGNMENT 64
+
+// The arena of a thread is freed when the thread exits. This includes the threads that nvtt does not own, like the
+// threads that call it and the threads of OpenMP and TBB. NV_THREAD_LOCAL does not support destructors.
+struct ThreadArena {
+    ScratchArena * arena;
+    ~ThreadArena() { delete arena; }
+};
+
+static thread_local ThreadArena s_threadArena;
+
+
+ScratchArena::ScratchArena(uint chunkSize/*= 64 * 1024*/) :
+    m_chunks(NULL), m_chunkCount(0), m_chunkCapacity(0), m_chunkSize(chunkSize), m_current(0), m_offset(0)
+{
+}
+
+ScratchArena::~ScratchArena()
+{
+    for (uint i = 0; i < m_chunkCount; i++) {
+        aligned_free(m_chunks[i].data);
+    }
+    ::free(m_chunks);
+}
+
+void * ScratchArena::allocate(uint size, uint alignment/*= 16*/)
+{
+    nvDebugCheck(isPowerOfTwo(alignment) && alignment <= CHUNK_ALIGNMENT);
+
+    if (m_current < m_chunkCount) {
+        const uint offset = (m_offset + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= m_chunks[m_current].size) {
+            m_offset = offset + size;
+            return m_chunks[m_current].data + offset;
+        }
+
+        // Continue in the next chunk.
+        m_current++;
+    }
+
+    // The next chunk may have been allocated by an earlier allocation, but it could be too small for this one.
+    if (m_current < m_chunkCount && m_chunks[m_current].size < size) {
+        aligned_free(m_chunks[m_current].data);
+        m_chunks[m_current].size = max(m_chunkSize, size);
+        m_chunks[m_current].data = (uint8 *)aligned_malloc(m_chunks[m_current].size, CHUNK_ALIGNMENT);
+    }
+
+    if (m_current == m_chunkCount) {
+        if (m_chunkCount == m_chunkCapacity) {
+            m_chunkCapacity = max(2 * m_chunkCapacity, 4U);
+            m_chunks = (Chunk *)::realloc(m_chunks, sizeof(Chunk) * m_chunkCapacity);
+        }
+        m_chunks[m_chunkCount].size = max(m_chunkSize, size);
+        m_chunks[m_chunkCount].data = (uint8 *)aligned_malloc(m_chunks[m_chunkCount].size, CHUNK_ALIGNMENT);
+        m_chunkCount++;
+    }
+
+    m_offset = size;
+    return m_chunks[m_current].data;
+}
+
+ScratchArena::Mark ScratchArena::mark() const
+{
+    Mark mark = { m_current, m_offset };
+    return mark;
+}
+
+void ScratchArena::release(Mark mark)
+{
+    nvDebugCheck(mark.chunk < m_current || (mark.chunk == m_current && mark.offset <= m_offset));
+
+    m_current = mark.chunk;
+    m_offset = mark.offset;
+}
+
+/*static*/ ScratchArena & ScratchArena::current()
+{
+    if (s_threadArena.arena == NULL) {
+        s_threadArena.arena = new ScratchArena;
+    }
+    return *s_threadArena.arena;
+}
+
+/*static*/ void ScratchArena::releaseCurrent()
+{
+    delete s_threadArena.arena;
+    s_threadArena.arena = NULL;
+}
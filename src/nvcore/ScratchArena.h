@@ -0,0 +1,81 @@
+// This code is in the public domain -- castano@gmail.com
+
+#pragma once
+#ifndef NV_CORE_SCRATCHARENA_H
+#define NV_CORE_SCRATCHARENA_H
+
+#include "nvcore.h"
+
+namespace nv {
+
+    // Linear allocator for temporary memory.
+    // Memory is released in LIFO order by restoring a mark, usually with a ScratchScope. The memory of the arena is
+    // kept around and reused by subsequent allocations.
+    // Each thread has its own arena, so that tasks can borrow temporary memory without taking any locks. Tasks that
+    // wait for other tasks may execute them in the same thread, so memory has to be released before returning.
+    class NVCORE_CLASS ScratchArena
+    {
+        NV_FORBID_COPY(ScratchArena);
+    public:
+
+        struct Mark {
+            uint chunk;
+            uint offset;
+        };
+
+        ScratchArena(uint chunkSize = 64 * 1024);
+        ~ScratchArena();
+
+        void * allocate(uint size, uint alignment = 16);
+
+        template <typename T>
+        T * allocate(uint count, uint alignment = 16) {
+            return (T *)allocate(uint(sizeof(T)) * count, alignment);
+        }
+
+        Mark mark() const;
+        void release(Mark mark);
+
+        // Arena of the calling thread.
+        static ScratchArena & current();
+
+        // Free the arena of the calling thread. The arena is also freed when the thread exits, this releases it earlier.
+        static void releaseCurrent();
+
+    private:
+
+        struct Chunk {
+            uint8 * data;
+            uint size;
+        };
+
+        Chunk * m_chunks;
+        uint m_chunkCount;
+        uint m_chunkCapacity;
+        uint m_chunkSize;
+
+        uint m_current;     // Index of the chunk being used.
+        uint m_offset;      // Offset into the current chunk.
+    };
+
+    // Releases the memory allocated from the arena while the scope was alive.
+    class ScratchScope
+    {
+        NV_FORBID_COPY(ScratchScope);
+    public:
+        ScratchScope(ScratchArena & arena = ScratchArena::current()) : m_arena(arena), m_mark(arena.mark()) {}
+        ~ScratchScope() { m_arena.release(m_mark); }
+
+        void * allocate(uint size, uint alignment = 16) { return m_arena.allocate(size, alignment); }
+
+        template <typename T>
+        T * allocate(uint count, uint alignment = 16) { return m_arena.allocate<T>(count, alignment); }
+
+    private:
+        ScratchArena & m_arena;
+        const ScratchArena::Mark m_mark;
+    };
+
+} // nv namespace
+
+#endif // NV_CORE_SCRATCHARENA_H
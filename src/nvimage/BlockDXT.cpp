@@ -631,17 +631,19 @@ void BlockCTX1::setIndices(int * idx)
 /// Decode BC6 block.
 void BlockBC6::decodeBlock(Vector4 colors[16]) const
 {
+    // BC6H_UF16 is assumed, signed blocks would need ZOH::SIGNED_F16.
+    ZOH::Options options;
     ZOH::Tile tile(4, 4);
-    ZOH::decompress((const char *)data, tile);
+    ZOH::decompress((const char *)data, options, tile);
 
     // Convert ZOH's tile struct to Vector3, and convert half to float.
     for (uint y = 0; y < 4; ++y)
     {
         for (uint x = 0; x < 4; ++x)
         {
-            uint16 rHalf = ZOH::Tile::float2half(tile.data[y][x].x);
-            uint16 gHalf = ZOH::Tile::float2half(tile.data[y][x].y);
-            uint16 bHalf = ZOH::Tile::float2half(tile.data[y][x].z);
+            uint16 rHalf = ZOH::Tile::float2half(tile.data[y][x].x, options.format);
+            uint16 gHalf = ZOH::Tile::float2half(tile.data[y][x].y, options.format);
+            uint16 bHalf = ZOH::Tile::float2half(tile.data[y][x].z, options.format);
             colors[y * 4 + x].x = to_float(rHalf);
             colors[y * 4 + x].y = to_float(gHalf);
             colors[y * 4 + x].z = to_float(bHalf);
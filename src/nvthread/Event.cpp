@@ -1,85 +1,172 @@
 // This code is in the public domain -- castano@gmail.com
 
 #include "Event.h"
+#include "Thread.h"
+#include "Atomic.h"
+
+#include "nvcore/Utils.h" // min, max
 
 #if NV_OS_WIN32
 #include "Win32.h"
+#elif NV_OS_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #elif NV_OS_USE_PTHREAD
 #include <pthread.h>
 #endif
 
 using namespace nv;
 
-#if NV_OS_WIN32
-
+// The event counts the posts that have not been consumed yet. Waiters first spin on the count and only park the thread
+// when nothing is posted within the spin budget. Posters only enter the kernel when there's a parked waiter.
 struct Event::Private {
+    uint32 count;       // Pending posts.
+    uint32 parked;      // Number of parked waiters.
+    uint spinCount;     // Maximum spin budget.
+    uint spinBudget;    // Current spin budget, adapted to the recent wait times.
+
+#if NV_OS_WIN32
     HANDLE handle;
+#elif NV_OS_LINUX
+    // The count is used as the futex word.
+#elif NV_OS_USE_PTHREAD
+    pthread_cond_t pt_cond;
+    pthread_mutex_t pt_mutex;
+#endif
+
+    void init();
+    void destroy();
+    bool tryConsume();
+    void park();
+    void wake();
 };
 
-Event::Event() : m(new Private) {
-    m->handle = CreateEvent(/*lpEventAttributes=*/NULL, /*bManualReset=*/FALSE, /*bInitialState=*/FALSE, /*lpName=*/NULL);
+// Consume one post if available.
+bool Event::Private::tryConsume() {
+    uint32 value = loadAcquire(&count);
+    while (value != 0) {
+        if (atomicCompareAndSwap(&count, value, value - 1)) {
+            return true;
+        }
+        value = loadAcquire(&count);
+    }
+    return false;
 }
 
-Event::~Event() {
-    CloseHandle(m->handle);
+#if NV_OS_WIN32
+
+void Event::Private::init() {
+    handle = CreateEvent(/*lpEventAttributes=*/NULL, /*bManualReset=*/FALSE, /*bInitialState=*/FALSE, /*lpName=*/NULL);
 }
 
-void Event::post() {
-    SetEvent(m->handle);
+void Event::Private::destroy() {
+    CloseHandle(handle);
 }
 
-void Event::wait() {
-    WaitForSingleObject(m->handle, INFINITE);
+// May return spuriously, the caller checks the count again.
+void Event::Private::park() {
+    WaitForSingleObject(handle, INFINITE);
+}
+
+void Event::Private::wake() {
+    SetEvent(handle);
+}
+
+#elif NV_OS_LINUX
+
+void Event::Private::init() {}
+void Event::Private::destroy() {}
+
+// Sleeps only if the count is still zero. May return spuriously, the caller checks the count again.
+void Event::Private::park() {
+    syscall(SYS_futex, &count, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
+}
+
+void Event::Private::wake() {
+    syscall(SYS_futex, &count, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
 }
 
 #elif NV_OS_USE_PTHREAD
 
-struct Event::Private {
-    pthread_cond_t pt_cond;
-    pthread_mutex_t pt_mutex;
-    int count;
-    int wait_count;
-};
+void Event::Private::init() {
+    pthread_mutex_init(&pt_mutex, NULL);
+    pthread_cond_init(&pt_cond, NULL);
+}
+
+void Event::Private::destroy() {
+    pthread_cond_destroy(&pt_cond);
+    pthread_mutex_destroy(&pt_mutex);
+}
+
+// May return spuriously, the caller checks the count again.
+void Event::Private::park() {
+    pthread_mutex_lock(&pt_mutex);
+    if (loadAcquire(&count) == 0) {
+        pthread_cond_wait(&pt_cond, &pt_mutex);
+    }
+    pthread_mutex_unlock(&pt_mutex);
+}
+
+void Event::Private::wake() {
+    // Taking the lock makes sure the waiter is either inside pthread_cond_wait or has not checked the count yet.
+    pthread_mutex_lock(&pt_mutex);
+    pthread_cond_signal(&pt_cond);
+    pthread_mutex_unlock(&pt_mutex);
+}
+
+#endif // NV_OS_UNIX
+
 
 Event::Event() : m(new Private) {
-    m->count=0;
-    m->wait_count=0;
-    pthread_mutex_init(&m->pt_mutex, NULL);
-    pthread_cond_init(&m->pt_cond, NULL);
+    m->count = 0;
+    m->parked = 0;
+    m->spinCount = 0;
+    m->spinBudget = 0;
+    m->init();
 }
 
 Event::~Event() {
-    pthread_cond_destroy(&m->pt_cond);
-    pthread_mutex_destroy(&m->pt_mutex);
+    m->destroy();
+}
+
+void Event::setSpinCount(uint count) {
+    m->spinCount = count;
+    m->spinBudget = count;
 }
 
 void Event::post() {
-    pthread_mutex_lock(&m->pt_mutex);
+    // The increment is a full barrier, so either we see the parked waiter, or the waiter sees the new count.
+    atomicIncrement(&m->count);
 
-    m->count++;
-    
-    //ACS: move this after the unlock?
-    if(m->wait_count>0) {
-        pthread_cond_signal(&m->pt_cond);
+    if (loadAcquire(&m->parked) != 0) {
+        m->wake();
     }
-    
-    pthread_mutex_unlock(&m->pt_mutex);
 }
 
 void Event::wait() {
-    pthread_mutex_lock(&m->pt_mutex);
-    
-    while(m->count==0) {
-        m->wait_count++;
-        pthread_cond_wait(&m->pt_cond, &m->pt_mutex);
-        m->wait_count--;
+    // Spin for a while before parking the thread.
+    const uint spinBudget = m->spinBudget;
+    for (uint i = 0; i < spinBudget; i++) {
+        if (m->tryConsume()) {
+            // Spinning paid off, restore the budget.
+            m->spinBudget = m->spinCount;
+            return;
+        }
+        Thread::spinWait(1);
     }
-    m->count--;
-    
-    pthread_mutex_unlock(&m->pt_mutex);
-}
 
-#endif // NV_OS_UNIX
+    atomicIncrement(&m->parked);
+
+    while (!m->tryConsume()) {
+        m->park();
+    }
+
+    atomicDecrement(&m->parked);
+
+    // Spinning did not pay off, spin less next time, but keep probing so that the budget can recover.
+    m->spinBudget = max(spinBudget / 2, min(m->spinCount, 16U));
+}
 
 
 /*static*/ void Event::post(Event * events, uint count) {
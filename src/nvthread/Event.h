@@ -11,6 +11,8 @@
 namespace nv
 {
     // This is intended to be used by a single waiter thread.
+    // The waiter spins for a while before parking the thread, this avoids the cost of the kernel transitions when the
+    // event is posted shortly after the wait starts.
     class NVTHREAD_CLASS Event
     {
         NV_FORBID_COPY(Event);
@@ -21,6 +23,9 @@ namespace nv
         void post();
         void wait();    // Wait resets the event.
 
+        // Number of spin iterations before parking the thread, the actual budget adapts to recent waits. Defaults to 0.
+        void setSpinCount(uint count);
+
         static void post(Event * events, uint count);
         static void wait(Event * events, uint count);
 
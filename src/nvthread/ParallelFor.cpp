@@ -1,61 +1,133 @@
 // This code is in the public domain -- Ignacio Castao <castano@gmail.com>
 
 #include "ParallelFor.h"
+#include "TaskScheduler.h"
 #include "Thread.h"
 #include "Atomic.h"
-#include "ThreadPool.h"
 
-#include "nvcore/Utils.h" // toI32
+#include "nvcore/Utils.h" // toI32, min, max
 
 using namespace nv;
 
 #define ENABLE_PARALLEL_FOR 1
 
-static void worker(void * arg, int tid) {
+static void worker(void * arg, int tid, uint begin, uint end) {
     ParallelFor * owner = (ParallelFor *)arg;
 
-    while(true) {
-        uint new_idx = atomicFetchAndAdd(&owner->idx, owner->step);
-        if (new_idx >= owner->count) {
-            break;
-        }
-
-        const uint count = min(owner->count, new_idx + owner->step);
-        for (uint i = new_idx; i < count; i++) {
-            owner->task(owner->context, /*tid, */i);
-        }
+    for (uint i = begin; i < end; i++) {
+        owner->task(owner->context, tid, i);
     }
 }
 
 
-ParallelFor::ParallelFor(ForTask * task, void * context) : task(task), context(context) {
+ParallelFor::ParallelFor(ForTask * task, void * context, TaskScheduler * scheduler/*= NULL*/) : task(task), context(context), scheduler(scheduler) {
 #if ENABLE_PARALLEL_FOR
-    pool = ThreadPool::acquire();
+    if (this->scheduler == NULL) {
+        this->scheduler = TaskScheduler::instance();
+    }
 #endif
 }
 
 ParallelFor::~ParallelFor() {
+}
+
+void ParallelFor::run(uint count, uint step/*= 1*/) {
 #if ENABLE_PARALLEL_FOR
-    ThreadPool::release(pool);
+    // The scheduler splits the range in chunks of 'step' items that are distributed among the worker threads.
+    // Tasks may call run recursively, the waiting thread executes pending tasks.
+    scheduler->run(worker, this, count, step);
+#else
+    for (int i = 0; i < toI32(count); i++) {
+        task(context, 0, i);
+    }
 #endif
 }
 
-void ParallelFor::run(uint count, uint step/*= 1*/) {
+uint ParallelFor::threadCount() const {
 #if ENABLE_PARALLEL_FOR
-    storeRelease(&this->count, count);
-    storeRelease(&this->step, step);
+    return scheduler->threadCount();
+#else
+    return 1;
+#endif
+}
 
-    // Init atomic counter to zero.
-    storeRelease(&idx, 0);
 
-    // Start threads.
-    pool->run(worker, this);
+ParallelOutputStream::ParallelOutputStream(uint chunkCount, uint chunkSize, uint slotCount, WriteFunc * write, void * context) :
+    m_chunkCount(chunkCount), m_chunkSize(chunkSize), m_slotCount(max(1U, min(slotCount, chunkCount))), m_write(write), m_context(context),
+    m_next(0), m_flushed(0), m_writing(0)
+{
+    m_buffer = new uint8[m_slotCount * m_chunkSize];
+    m_slotSize = new uint[m_slotCount];
+    m_slotDone = new uint[m_slotCount];
+    for (uint i = 0; i < m_slotCount; i++) {
+        m_slotSize[i] = 0;
+        m_slotDone[i] = 0;
+    }
+}
 
-    nvDebugCheck(idx >= count);
-#else
-    for (int i = 0; i < toI32(count); i++) {
-        task(context, i);
+ParallelOutputStream::~ParallelOutputStream() {
+    nvDebugCheck(m_flushed == m_chunkCount);
+
+    delete [] m_buffer;
+    delete [] m_slotSize;
+    delete [] m_slotDone;
+}
+
+uint8 * ParallelOutputStream::begin(uint * chunk) {
+    const uint idx = atomicIncrement(&m_next) - 1;
+    nvCheck(idx < m_chunkCount);
+
+    // Wait until the previous chunk of the slot has been written. The chunk that holds the slot has been claimed
+    // earlier by a task that is already running, so this never waits for a task that has not started.
+    for (uint i = 0; idx >= loadAcquire(&m_flushed) + m_slotCount; i++) {
+        if (i < 64) Thread::spinWait(16);
+        else Thread::yield();
     }
-#endif
+
+    *chunk = idx;
+    return m_buffer + (idx % m_slotCount) * m_chunkSize;
 }
 
+void ParallelOutputStream::end(uint chunk, uint size) {
+    nvDebugCheck(size <= m_chunkSize);
+
+    const uint slot = chunk % m_slotCount;
+    m_slotSize[slot] = size;
+    storeRelease(&m_slotDone[slot], chunk + 1);
+
+    flush();
+}
+
+void ParallelOutputStream::flush() {
+    while (true) {
+        // If another thread is writing, it will pick up our chunk.
+        if (!atomicCompareAndSwap(&m_writing, 0, 1)) {
+            return;
+        }
+
+        uint next = loadAcquire(&m_flushed);
+        while (next < m_chunkCount && loadAcquire(&m_slotDone[next % m_slotCount]) == next + 1) {
+            // Write consecutive chunks that are ready and contiguous in the ring at once.
+            const uint first = next % m_slotCount;
+            uint size = 0;
+            uint slot = first;
+            do {
+                size += m_slotSize[slot];
+                next++;
+                slot = next % m_slotCount;
+            } while (slot != 0 && m_slotSize[slot - 1] == m_chunkSize && next < m_chunkCount && loadAcquire(&m_slotDone[slot]) == next + 1);
+
+            m_write(m_context, m_buffer + first * m_chunkSize, size);
+
+            // Release the slots.
+            storeRelease(&m_flushed, next);
+        }
+
+        // Use a full barrier, a chunk may have been completed after the check, but before releasing the writer flag.
+        atomicCompareAndSwap(&m_writing, 1, 0);
+
+        if (next == m_chunkCount || loadAcquire(&m_slotDone[next % m_slotCount]) != next + 1) {
+            return;
+        }
+    }
+}
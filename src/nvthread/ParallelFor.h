@@ -9,26 +9,26 @@
 
 namespace nv
 {
-    class Thread;
-    class ThreadPool;
+    class TaskScheduler;
 
-    typedef void ForTask(void * context, /*int tid,*/ int idx); // @@ It would be nice to have the thread index as an argument here.
+    // The thread index is in the range [0, threadCount). Tasks that run at the same time in different worker threads always
+    // have different indices, but all threads that are not workers of the scheduler use index 0.
+    typedef void ForTask(void * context, int tid, int idx);
 
     struct ParallelFor {
-        ParallelFor(ForTask * task, void * context);
+        // Runs the tasks in the given scheduler, or in the shared instance if none.
+        ParallelFor(ForTask * task, void * context, TaskScheduler * scheduler = NULL);
         ~ParallelFor();
 
         void run(uint count, uint step = 1);
 
+        // Number of thread indices passed to the task.
+        uint threadCount() const;
+
         // Invariant:
         ForTask * task;
         void * context;
-        ThreadPool * pool;
-
-        // State:
-        uint count;
-        uint step;
-        /*atomic<uint>*/ uint idx;
+        TaskScheduler * scheduler;
     };
 
 
@@ -45,9 +45,9 @@ namespace nv
     template <typename F>
     void parallel_for(uint count, uint step, F f) {
         // Transform lambda into function pointer.
-        auto lambda = [](void* context, /*int tid, */int idx) {
+        auto lambda = [](void* context, int /*tid*/, int idx) {
             F & f = *reinterpret_cast<F *>(context);
-            f(/*tid, */idx);
+            f(idx);
         };
 
         ParallelFor pf(lambda, &f);
@@ -76,7 +76,7 @@ namespace nv
     template <typename F, typename T>
     void parallel_for_each(Array<T> & array, uint step, F f) {
         // Transform lambda into function pointer.
-        auto lambda = [](void* context, int idx) {
+        auto lambda = [](void* context, int tid, int idx) {
             F & f = *reinterpret_cast<F *>(context);
             f(array[idx]);
         };
@@ -90,91 +90,46 @@ namespace nv
 #endif // NV_CC_CPP11
 
 
-/*
-
-#include "nvthread/Mutex.h"
-#include "nvcore/Array.inl"
-
-    template <typename T>
-    struct ParallelOutputStream {
-#if 0
-        // In its most basic implementation the parallel stream is simply a single array protected by a mutex.
-        Parallel_Output_Stream(uint producer_count) {}
-
-        void reset() { final_array.clear(); }
-        void append(uint producer_id, const T & t) { Lock(mutex); final_array.append(t); }
-        nv::Array<T> & finalize() { return final_array; }
-        
-        nv::Mutex mutex;
-        nv::Array<T> final_array;
-
-#elif 0
-        // Another simple implementation is to have N arrays that are merged at the end.
-        ParallelOutputStream(uint producer_count) : producer_count(producer_count) {
-            partial_array = new Array<T>[producer_count];
-        }
+    // Ordered output stream of chunks that are produced in parallel.
+    // Tasks claim the chunks in order and write them to a ring of slots, completed chunks are passed to the write function
+    // in order as soon as all the previous chunks are complete, while later chunks are still being produced. The ring
+    // bounds the memory in use: a task that runs too far ahead waits until the slot of its chunk has been written.
+    // The write function may be called from any of the producer threads, but calls never overlap.
+    class ParallelOutputStream {
+        NV_FORBID_COPY(ParallelOutputStream);
+    public:
 
-        void reset() {
-            for (int i = 0; i < producer_count; i++) {
-                partial_array[i].clear();
-            }
-        }
+        typedef void WriteFunc(void * context, const void * data, uint size);
 
-        void append(uint producer_id, const T & t) { 
-            nvCheck(producer_id < producer_count);
-            partial_array[producer_id].append(t);
-        }
+        ParallelOutputStream(uint chunkCount, uint chunkSize, uint slotCount, WriteFunc * write, void * context);
+        ~ParallelOutputStream();
 
-        nv::Array<T> & finalize() {
-            for (int i = 1; i < producer_count; i++) {
-                partial_array->append(partial_array[i]);
-                partial_array[i].clear();
-            }
-            return *partial_array;
-        }
+        // Claim the next chunk, returns a buffer of chunkSize bytes for its output.
+        uint8 * begin(uint * chunk);
 
-        uint producer_count;
-        nv::Array<T> * partial_array;
-#else
-        ParallelOutputStream(uint producer_count) : producer_count(producer_count) {
-            partial_array = new PartialArray[producer_count];
-        }
+        // Complete the chunk and write all the chunks that are ready.
+        void end(uint chunk, uint size);
 
-        // But a more sophisticated implementation keeps N short arrays that are merged as they get full. This preserves partial order.
-        struct PartialArray {          // Make sure this is aligned to cache lines. We want producers to access their respective arrays without conflicts.
-            uint count;
-            T data[32];                 // Pick size to minimize wasted space considering cache line alignment?
-        };
+    private:
 
-        const uint producer_count;
-        PartialArray * partial_array;
+        void flush();
 
-        // @@ Make sure mutex and partial_array are not in the same cache line!
+        const uint m_chunkCount;
+        const uint m_chunkSize;
+        const uint m_slotCount;
 
-        nv::Mutex mutex;
-        nv::Array<T> final_array;
+        WriteFunc * m_write;
+        void * m_context;
 
-        void append(uint producer_id, const T & t) {
-            if (partial_array[producer_id].count == 32) {
-                partial_array[producer_id].count = 0;
-                Lock(mutex);
-                final_array.append(partial_array[producer_id].data, 32);
-            }
+        uint8 * m_buffer;
+        uint * m_slotSize;
+        uint * m_slotDone;      // Index of the chunk completed in the slot plus one.
 
-            partial_array[producer_id].data[partial_array[producer_id].count++] = t;
-        }
-        nv::Array<T> & finalize() {
-            for (int i = 0; i < producer_count; i++) {
-                final_array.append(partial_array[producer_id].data, partial_array[producer_id].count);
-            }
-            return final_array;
-        }
-#endif
+        uint m_next;            // Next chunk to claim.
+        uint m_flushed;         // Number of chunks written.
+        uint m_writing;         // Set while a thread is writing chunks.
     };
 
-*/
-
-
 } // nv namespace
 
 
@@ -0,0 +1,335 @@
+// This code is in the public domain -- castano@gmail.com
+
+#include "TaskScheduler.h"
+#include "ThreadPool.h"
+#include "Mutex.h"
+#include "Event.h"
+#include "Thread.h"
+#include "Atomic.h"
+
+#include "nvcore/Ptr.h" // AutoPtr
+#include "nvcore/ScratchArena.h"
+#include "nvcore/Utils.h" // max
+
+using namespace nv;
+
+// Number of tasks that each queue can hold. Ranges are split only when the local queue is empty, so the queues rarely
+// hold more than a few tasks per nesting level. If a queue is full the task is executed immediately.
+#define TASK_QUEUE_SIZE 256
+
+// Number of times a thread polls the queues before parking.
+#define TASK_SPIN_COUNT 64
+
+
+static Mutex s_scheduler_mutex("task scheduler");
+static AutoPtr<TaskScheduler> s_scheduler;
+
+// Scheduler and thread index of the current thread, only valid in worker threads.
+static NV_THREAD_LOCAL TaskScheduler * s_currentScheduler = NULL;
+static NV_THREAD_LOCAL uint s_currentIndex = 0;
+
+
+struct TaskScheduler::Task {
+    RangeTask * func;
+    void * context;
+    TaskGroup * group;
+    uint begin;
+    uint end;
+    uint grain;
+};
+
+// Spin lock protected double ended queue. The owner pushes and pops tasks at the bottom, thieves steal from the top.
+struct TaskScheduler::TaskQueue {
+    TaskQueue() : lock(0), top(0), bottom(0) {}
+
+    void acquire() {
+        while (!atomicCompareAndSwap(&lock, 0, 1)) {
+            while (loadAcquire(&lock) != 0) {}
+        }
+    }
+    void release() {
+        storeRelease(&lock, 0);
+    }
+
+    bool isEmpty() const {
+        return loadAcquire(&top) == loadAcquire(&bottom);
+    }
+
+    uint lock;
+    uint top;
+    uint bottom;
+    Task tasks[TASK_QUEUE_SIZE];
+};
+
+
+/*static*/ void TaskScheduler::setup(uint workerCount, const uint * cpuSet/*= NULL*/, uint cpuCount/*= 0*/) {
+    Lock<Mutex> lock(s_scheduler_mutex);
+
+    s_scheduler = new TaskScheduler(workerCount, cpuSet, cpuCount);
+}
+
+/*static*/ TaskScheduler * TaskScheduler::instance() {
+    Lock<Mutex> lock(s_scheduler_mutex);
+
+    if (s_scheduler == NULL) {
+        s_scheduler = new TaskScheduler;
+    }
+
+    return s_scheduler.ptr();
+}
+
+
+TaskScheduler::TaskScheduler(uint workerCount/*= processorCount() - 1*/, const uint * cpuSet/*= NULL*/, uint cpuCount/*= 0*/) : m_workerCount(workerCount), m_sleepingCount(0), m_quit(0)
+{
+    // Guard against processorCount() returning 0.
+    if (m_workerCount == ~0U) m_workerCount = 0;
+
+    m_queues = new TaskQueue[m_workerCount + 1];
+    m_wakeEvents = new Event[m_workerCount + 1];
+    m_sleeping = new uint[m_workerCount + 1];
+    for (uint i = 0; i <= m_workerCount; i++) {
+        m_sleeping[i] = 0;
+    }
+
+    // The pool reserves index 0 for the calling thread, but we only start the workers, so that they get indices 1 to workerCount.
+    m_pool = NULL;
+    if (m_workerCount != 0) {
+        m_pool = new ThreadPool(m_workerCount + 1, /*useThreadAffinity=*/false, /*useCallingThread=*/true, ThreadPool::DefaultSpinCount, cpuSet, cpuCount);
+        m_pool->start(workerFunc, this);
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    // Request workers to exit and wake up the ones that are parked.
+    storeRelease(&m_quit, 1);
+
+    for (uint i = 1; i <= m_workerCount; i++) {
+        if (atomicCompareAndSwap(&m_sleeping[i], 1, 0)) {
+            atomicDecrement(&m_sleepingCount);
+            m_wakeEvents[i].post();
+        }
+    }
+
+    // Wait for the workers to finish and terminate the threads.
+    delete m_pool;
+
+    delete [] m_queues;
+    delete [] m_wakeEvents;
+    delete [] m_sleeping;
+}
+
+
+void TaskScheduler::spawn(TaskGroup * group, RangeTask * func, void * context, uint begin, uint end, uint grain/*= 1*/)
+{
+    if (begin >= end) return;
+
+    Task task;
+    task.func = func;
+    task.context = context;
+    task.group = group;
+    task.begin = begin;
+    task.end = end;
+    task.grain = max(grain, 1U);
+
+    atomicIncrement(&group->pending);
+
+    uint idx = threadIndex();
+    if (!push(idx, task)) {
+        execute(idx, task);
+    }
+}
+
+void TaskScheduler::wait(TaskGroup * group)
+{
+    uint idx = threadIndex();
+    uint spin = 0;
+
+    while (loadAcquire(&group->pending) != 0) {
+        Task task;
+        if (pop(idx, &task) || steal(idx, &task)) {
+            execute(idx, task);
+            spin = 0;
+        }
+        else if (++spin > TASK_SPIN_COUNT) {
+            // The remaining tasks are being executed by other threads.
+            Thread::yield();
+        }
+    }
+}
+
+void TaskScheduler::run(RangeTask * func, void * context, uint count, uint grain/*= 1*/)
+{
+    TaskGroup group;
+    spawn(&group, func, context, 0, count, grain);
+    wait(&group);
+}
+
+
+/*static*/ void TaskScheduler::workerFunc(void * arg, int id)
+{
+    TaskScheduler * scheduler = (TaskScheduler *)arg;
+    uint idx = uint(id);
+
+    s_currentScheduler = scheduler;
+    s_currentIndex = idx;
+
+    while (true) {
+        Task task;
+        if (scheduler->pop(idx, &task) || scheduler->steal(idx, &task)) {
+            scheduler->execute(idx, task);
+            continue;
+        }
+
+        if (loadAcquire(&scheduler->m_quit)) {
+            break;
+        }
+
+        scheduler->idle(idx);
+    }
+
+    s_currentScheduler = NULL;
+
+    ScratchArena::releaseCurrent();
+}
+
+uint TaskScheduler::threadIndex() const
+{
+    // Threads that do not belong to this scheduler share the first queue.
+    return (s_currentScheduler == this) ? s_currentIndex : 0;
+}
+
+bool TaskScheduler::push(uint idx, const Task & task)
+{
+    TaskQueue & queue = m_queues[idx];
+
+    queue.acquire();
+    if (queue.bottom - queue.top == TASK_QUEUE_SIZE) {
+        queue.release();
+        return false;
+    }
+    queue.tasks[queue.bottom % TASK_QUEUE_SIZE] = task;
+    storeRelease(&queue.bottom, queue.bottom + 1);
+    queue.release();
+
+    // Wake up a parked worker to steal the new task.
+    if (loadAcquire(&m_sleepingCount) != 0) {
+        wakeOne();
+    }
+
+    return true;
+}
+
+bool TaskScheduler::pop(uint idx, Task * task)
+{
+    TaskQueue & queue = m_queues[idx];
+    if (queue.isEmpty()) return false;
+
+    queue.acquire();
+    if (queue.bottom == queue.top) {
+        queue.release();
+        return false;
+    }
+    storeRelease(&queue.bottom, queue.bottom - 1);
+    *task = queue.tasks[queue.bottom % TASK_QUEUE_SIZE];
+    queue.release();
+
+    return true;
+}
+
+bool TaskScheduler::steal(uint idx, Task * task)
+{
+    const uint queueCount = m_workerCount + 1;
+
+    for (uint i = 1; i < queueCount; i++) {
+        TaskQueue & queue = m_queues[(idx + i) % queueCount];
+        if (queue.isEmpty()) continue;
+
+        queue.acquire();
+        if (queue.bottom != queue.top) {
+            *task = queue.tasks[queue.top % TASK_QUEUE_SIZE];
+            storeRelease(&queue.top, queue.top + 1);
+            queue.release();
+            return true;
+        }
+        queue.release();
+    }
+
+    return false;
+}
+
+bool TaskScheduler::hasWork()
+{
+    // Inspect the queues while holding their locks, so that a push that completed before this check is always seen.
+    for (uint i = 0; i < m_workerCount + 1; i++) {
+        TaskQueue & queue = m_queues[i];
+        queue.acquire();
+        bool empty = (queue.bottom == queue.top);
+        queue.release();
+        if (!empty) return true;
+    }
+    return false;
+}
+
+void TaskScheduler::execute(uint idx, Task & task)
+{
+    TaskQueue & queue = m_queues[idx];
+
+    while (task.begin < task.end) {
+        uint count = task.end - task.begin;
+
+        // Lazy binary splitting: while the local queue is empty, give away the upper half of the range.
+        if (count > task.grain && queue.isEmpty()) {
+            uint half = (count / 2 + task.grain - 1) / task.grain * task.grain;
+
+            Task upper = task;
+            upper.begin = task.end - min(half, count - task.grain);
+
+            atomicIncrement(&task.group->pending);
+            if (push(idx, upper)) {
+                task.end = upper.begin;
+                continue;
+            }
+            atomicDecrement(&task.group->pending);
+        }
+
+        uint end = min(task.begin + task.grain, task.end);
+        task.func(task.context, int(idx), task.begin, end);
+        task.begin = end;
+    }
+
+    // Do not touch the group after this point, the waiting thread may release it.
+    atomicDecrement(&task.group->pending);
+}
+
+void TaskScheduler::idle(uint idx)
+{
+    for (uint i = 0; i < TASK_SPIN_COUNT; i++) {
+        if (!m_queues[i % (m_workerCount + 1)].isEmpty()) return;
+    }
+
+    // Announce we are going to sleep before checking the queues for the last time. Any push that happens after the
+    // check will see the sleeping count and wake us up.
+    atomicCompareAndSwap(&m_sleeping[idx], 0, 1);
+    atomicIncrement(&m_sleepingCount);
+
+    if (!hasWork() && !loadAcquire(&m_quit)) {
+        m_wakeEvents[idx].wait();
+    }
+
+    // If nobody claimed the wake up, withdraw it ourselves.
+    if (atomicCompareAndSwap(&m_sleeping[idx], 1, 0)) {
+        atomicDecrement(&m_sleepingCount);
+    }
+}
+
+void TaskScheduler::wakeOne()
+{
+    for (uint i = 1; i <= m_workerCount; i++) {
+        if (loadAcquire(&m_sleeping[i]) && atomicCompareAndSwap(&m_sleeping[i], 1, 0)) {
+            atomicDecrement(&m_sleepingCount);
+            m_wakeEvents[i].post();
+            return;
+        }
+    }
+}
@@ -0,0 +1,90 @@
+// This code is in the public domain -- castano@gmail.com
+
+#pragma once
+#ifndef NV_THREAD_TASKSCHEDULER_H
+#define NV_THREAD_TASKSCHEDULER_H
+
+#include "nvthread.h"
+
+// Work-stealing task scheduler.
+// Each worker thread owns a task queue. Workers push and pop tasks at the bottom of their own queue and steal from the
+// top of the queues of other workers when they run out of work. Tasks describe a range of items [begin, end) that is
+// split lazily: whenever the local queue runs dry, the thread executing a range pushes half of it back, so that idle
+// workers can steal it. Tasks can be spawned from inside other tasks, and threads that wait for a group of tasks keep
+// executing pending tasks instead of blocking, so nested parallel loops do not deadlock.
+// Threads that are not workers of the scheduler (for example, the main thread) share an additional queue.
+// Tasks receive the index of the thread that executes them: worker threads have indices 1 to workerCount, all other
+// threads use index 0, like the calling thread of the ThreadPool.
+// Besides the shared instance, schedulers can be created explicitly, so that independent clients do not compete for the
+// same workers. The workers of a scheduler can be restricted to a set of logical processors.
+
+namespace nv {
+
+    class ThreadPool;
+    class Event;
+
+    typedef void RangeTask(void * context, int tid, uint begin, uint end);
+
+    // Tracks the number of outstanding tasks.
+    struct TaskGroup {
+        TaskGroup() : pending(0) {}
+        uint pending;
+    };
+
+    class TaskScheduler {
+        NV_FORBID_COPY(TaskScheduler);
+    public:
+
+        static void setup(uint workerCount, const uint * cpuSet = NULL, uint cpuCount = 0);
+        static TaskScheduler * instance();
+
+        TaskScheduler(uint workerCount = processorCount() - 1, const uint * cpuSet = NULL, uint cpuCount = 0);
+        ~TaskScheduler();
+
+        // Schedule the range [begin, end) for execution in chunks of at most 'grain' items.
+        void spawn(TaskGroup * group, RangeTask * task, void * context, uint begin, uint end, uint grain = 1);
+
+        // Execute pending tasks until all the tasks of the group have completed.
+        void wait(TaskGroup * group);
+
+        // Spawn and wait.
+        void run(RangeTask * task, void * context, uint count, uint grain = 1);
+
+        uint workerCount() const { return m_workerCount; }
+
+        // Number of distinct thread indices passed to the tasks.
+        uint threadCount() const { return m_workerCount + 1; }
+
+        // Index of the calling thread in this scheduler.
+        uint threadIndex() const;
+
+    private:
+
+        struct Task;
+        struct TaskQueue;
+
+        static void workerFunc(void * arg, int id);
+
+        bool push(uint idx, const Task & task);
+        bool pop(uint idx, Task * task);
+        bool steal(uint idx, Task * task);
+        bool hasWork();
+
+        void execute(uint idx, Task & task);
+        void idle(uint idx);
+        void wakeOne();
+
+        uint m_workerCount;
+        TaskQueue * m_queues;       // One queue per thread index, the first one is shared by all threads that are not workers.
+
+        ThreadPool * m_pool;
+        Event * m_wakeEvents;
+        uint * m_sleeping;          // Per thread flag set while the worker is parked.
+        uint m_sleepingCount;
+        uint m_quit;
+    };
+
+} // namespace nv
+
+
+#endif // NV_THREAD_TASKSCHEDULER_H
@@ -160,7 +160,18 @@ bool Thread::isRunning () const
 
 /*static*/ void Thread::spinWait(uint count)
 {
-    for (uint i = 0; i < count; i++) {}
+    for (uint i = 0; i < count; i++) {
+        // Let the processor know we are spinning, this saves power and frees resources for the sibling hyperthread.
+#if NV_CC_MSVC
+        YieldProcessor();
+#elif NV_CC_GNUC && (NV_CPU_X86 || NV_CPU_X86_64)
+        __builtin_ia32_pause();
+#elif NV_CC_GNUC && (NV_CPU_ARM || NV_CPU_AARCH64)
+        __asm__ __volatile__ ("yield");
+#else
+        nvCompilerReadBarrier();
+#endif
+    }
 }
 
 /*static*/ void Thread::yield()
@@ -29,12 +29,12 @@ Mutex s_pool_mutex("thread pool");
 AutoPtr<ThreadPool> s_pool;
 
 
-/*static*/ void ThreadPool::setup(uint workerCount, bool useThreadAffinity, bool useCallingThread) {
+/*static*/ void ThreadPool::setup(uint workerCount, bool useThreadAffinity, bool useCallingThread, uint spinCount/*= DefaultSpinCount*/) {
 #if PROTECT_THREAD_POOL 
     Lock<Mutex> lock(s_pool_mutex);
 #endif
 
-    s_pool = new ThreadPool(workerCount, useThreadAffinity, useCallingThread);
+    s_pool = new ThreadPool(workerCount, useThreadAffinity, useCallingThread, spinCount);
 }
 
 /*static*/ ThreadPool * ThreadPool::acquire()
@@ -44,8 +44,7 @@ AutoPtr<ThreadPool> s_pool;
 #endif
 
     if (s_pool == NULL) {
-        ThreadPool * p = new ThreadPool;
-        nvDebugCheck(s_pool == p);
+        s_pool = new ThreadPool;
     }
 
     return s_pool.ptr();
@@ -67,19 +66,24 @@ AutoPtr<ThreadPool> s_pool;
 
 
 /*static*/ void ThreadPool::workerFunc(void * arg) {
-    uint i = U32((uintptr_t)arg); // This is OK, because workerCount should always be much smaller than 2^32
+    WorkerContext * context = (WorkerContext *)arg;
+    ThreadPool * pool = context->pool;
+    uint i = context->index;
 
     //ThreadPool::threadId = i;
 
-    if (s_pool->useThreadAffinity) {
-        lockThreadToProcessor(s_pool->useCallingThread + i);
+    if (pool->cpuCount != 0) {
+        lockThreadToProcessorSet(pool->cpuSet, pool->cpuCount);
+    }
+    else if (pool->useThreadAffinity) {
+        lockThreadToProcessor(pool->useCallingThread + i);
     }
 
     while(true) 
     {
-        s_pool->startEvents[i].wait();
+        pool->startEvents[i].wait();
 
-        ThreadTask * func = loadAcquirePointer(&s_pool->func);
+        ThreadTask * func = loadAcquirePointer(&pool->func);
 
         if (func == NULL) {
             return;
@@ -91,32 +95,48 @@ AutoPtr<ThreadPool> s_pool;
 #elif NV_USE_TELEMETRY
             tmZoneFiltered(tmContext, 20, TMZF_NONE, "worker");
 #endif
-            func(s_pool->arg, s_pool->useCallingThread + i);
+            func(pool->arg, pool->useCallingThread + i);
         }
 
-        s_pool->finishEvents[i].post();
+        pool->finishEvents[i].post();
     }
 }
 
 
-ThreadPool::ThreadPool(uint workerCount/*=processorCount()*/, bool useThreadAffinity/*=true*/, bool useCallingThread/*=false*/)
+ThreadPool::ThreadPool(uint workerCount/*=processorCount()*/, bool useThreadAffinity/*=true*/, bool useCallingThread/*=false*/, uint spinCount/*=DefaultSpinCount*/, const uint * cpuSet/*=NULL*/, uint cpuCount/*=0*/)
 {
-    s_pool = this;  // Worker threads need this to be initialized before they start.
-
     this->useThreadAffinity = useThreadAffinity;
     this->workerCount = workerCount;
     this->useCallingThread = useCallingThread;
 
+    this->cpuCount = (cpuSet != NULL) ? cpuCount : 0;
+    this->cpuSet = NULL;
+    if (this->cpuCount != 0) {
+        this->cpuSet = new uint[cpuCount];
+        for (uint i = 0; i < cpuCount; i++) {
+            this->cpuSet[i] = cpuSet[i];
+        }
+    }
+
     uint threadCount = workerCount - useCallingThread;
 
     workers = new Thread[threadCount];
+    contexts = new WorkerContext[threadCount];
 
     startEvents = new Event[threadCount];
     finishEvents = new Event[threadCount];
 
+    // Spinning only pays off when the other threads can run at the same time.
+    if (processorCount() <= 1) spinCount = 0;
+
+    for (uint i = 0; i < threadCount; i++) {
+        startEvents[i].setSpinCount(spinCount);
+        finishEvents[i].setSpinCount(spinCount);
+    }
+
     nvCompilerWriteBarrier(); // @@ Use a memory fence?
 
-    if (useCallingThread && useThreadAffinity) {
+    if (useCallingThread && useThreadAffinity && this->cpuCount == 0) {
         lockThreadToProcessor(0);   // Calling thread always locked to processor 0.
     }
 
@@ -124,7 +144,9 @@ ThreadPool::ThreadPool(uint workerCount/*=processorCount()*/, bool useThreadAffi
     for (uint i = 0; i < threadCount; i++) {
         name.format("worker %d", i);
         workers[i].setName(name.release());     // @Leak
-        workers[i].start(workerFunc, (void *)(uintptr_t)i);
+        contexts[i].pool = this;
+        contexts[i].index = i;
+        workers[i].start(workerFunc, &contexts[i]);
     }
 
     allIdle = true;
@@ -139,8 +161,10 @@ ThreadPool::~ThreadPool()
     Thread::wait(workers, workerCount - useCallingThread);
 
     delete [] workers;
+    delete [] contexts;
     delete [] startEvents;
     delete [] finishEvents;
+    delete [] cpuSet;
 }
 
 void ThreadPool::run(ThreadTask * func, void * arg)
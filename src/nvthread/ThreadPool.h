@@ -15,6 +15,10 @@
 // When the thread pool starts, the main thread continues running, but the common use case is to inmmediately wait for the termination events of the worker threads.
 // @@ The start and wait methods could probably be merged.
 // It may be running the thread function on the invoking thread to avoid thread switches.
+// Waits spin for a while before parking the threads, so that back to back runs do not have to go through the kernel.
+// The spin count is the number of spin iterations of each wait, use 0 to always park the threads.
+// The workers can be restricted to a set of logical processors, in that case each worker may run on any processor of the
+// set and the thread affinity flag is ignored.
 
 namespace nv {
 
@@ -27,12 +31,14 @@ namespace nv {
         NV_FORBID_COPY(ThreadPool);
     public:
 
-        static void setup(uint workerCount, bool useThreadAffinity, bool useCallingThread);
+        enum { DefaultSpinCount = 4096 };
+
+        static void setup(uint workerCount, bool useThreadAffinity, bool useCallingThread, uint spinCount = DefaultSpinCount);
 
         static ThreadPool * acquire();
         static void release(ThreadPool *);
 
-        ThreadPool(uint workerCount = processorCount(), bool useThreadAffinity = true, bool useCallingThread = false);
+        ThreadPool(uint workerCount = processorCount(), bool useThreadAffinity = true, bool useCallingThread = false, uint spinCount = DefaultSpinCount, const uint * cpuSet = NULL, uint cpuCount = 0);
         ~ThreadPool();
 
         void run(ThreadTask * func, void * arg);
@@ -46,11 +52,20 @@ namespace nv {
 
         static void workerFunc(void * arg);
 
+        struct WorkerContext {
+            ThreadPool * pool;
+            uint index;
+        };
+
         bool useThreadAffinity;
         bool useCallingThread;
         uint workerCount;
 
+        uint * cpuSet;
+        uint cpuCount;
+
         Thread * workers;
+        WorkerContext * contexts;
         Event * startEvents;
         Event * finishEvents;
 
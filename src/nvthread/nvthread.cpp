@@ -12,6 +12,10 @@
 #include <sys/sysctl.h>
 #endif
 #include <unistd.h>
+#if NV_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
 #elif NV_OS_DARWIN
 #import <stdio.h>
 #import <string.h>
@@ -191,6 +195,40 @@ void nv::unlockThreadToProcessor() {
 #endif
 }
 
+void nv::lockThreadToProcessorSet(const uint * cpuSet, uint cpuCount) {
+#if NV_OS_WIN32
+    DWORD_PTR pam, sam;
+    GetProcessAffinityMask(GetCurrentProcess(), &pam, &sam);
+
+    // @@ Processor groups are not supported, only the first 64 processors can be selected.
+    DWORD_PTR tam = 0;
+    for (uint i = 0; i < cpuCount; i++) {
+        if (cpuSet[i] < sizeof(DWORD_PTR) * 8) {
+            tam |= DWORD_PTR(1) << cpuSet[i];
+        }
+    }
+    tam &= pam;
+
+    if (tam != 0) {
+        SetThreadAffinityMask(GetCurrentThread(), tam);
+    }
+#elif NV_OS_LINUX
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (uint i = 0; i < cpuCount; i++) {
+        if (cpuSet[i] < CPU_SETSIZE) {
+            CPU_SET(cpuSet[i], &set);
+        }
+    }
+
+    if (CPU_COUNT(&set) != 0) {
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#else
+    // @@ NOP
+#endif
+}
+
 uint nv::logicalProcessorCount() {
     return processorCount();
 }
@@ -93,6 +93,10 @@ namespace nv
     void lockThreadToProcessor(int idx);
     void unlockThreadToProcessor();
 
+    // Restricts the current thread to the given set of logical processors, for example, the processors of a NUMA node.
+    // Unlike lockThreadToProcessor, the processor numbers are system wide and not relative to the process affinity.
+    void lockThreadToProcessorSet(const uint * cpuSet, uint cpuCount);
+
     uint threadId();
 
 } // nv namespace
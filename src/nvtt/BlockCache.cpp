@@ -0,0 +1,118 @@
+// This code is in the public domain -- castano@gmail.com
+
+#include "BlockCache.h"
+#include "CompressionOptions.h"
+
+#include "nvthread/Atomic.h"
+
+#include "nvcore/Hash.h"
+#include "nvcore/Memory.h"
+#include "nvcore/Utils.h" // isPowerOfTwo
+#include "nvcore/Array.inl"
+
+#include <string.h> // memcmp, memcpy, memset
+
+using namespace nv;
+using namespace nvtt;
+
+
+BlockCache::BlockCache(uint entryCount/*= 8192*/) : m_settingsMutex("BlockCache"), m_lookupCount(0), m_hitCount(0)
+{
+    nvCheck(isPowerOfTwo(entryCount));
+
+    m_entries = (Entry *)aligned_malloc(sizeof(Entry) * entryCount, 64);
+    memset(m_entries, 0, sizeof(Entry) * entryCount);
+    m_mask = entryCount - 1;
+}
+
+BlockCache::~BlockCache()
+{
+    aligned_free(m_entries);
+}
+
+uint BlockCache::settingsId(AlphaMode alphaMode, const CompressionOptions::Private & compressionOptions)
+{
+    Settings s;
+    s.alphaMode = alphaMode;
+    s.format = compressionOptions.format;
+    s.quality = compressionOptions.quality;
+    s.pixelType = compressionOptions.pixelType;
+    for (uint i = 0; i < 4; i++) s.colorWeight[i] = compressionOptions.colorWeight.component[i];
+    s.rgbmThreshold = compressionOptions.rgbmThreshold;
+    const bool adaptive = compressionOptions.isAdaptiveQuality();
+    s.fastQuality = adaptive ? compressionOptions.fastQuality : Quality_Highest;
+    s.adaptiveThreshold[0] = adaptive ? compressionOptions.adaptiveErrorThreshold : 0.0f;
+    s.adaptiveThreshold[1] = adaptive ? compressionOptions.adaptiveVarianceThreshold : 0.0f;
+    s.decoder = adaptive ? compressionOptions.decoder : Decoder_D3D10;
+    s.binaryAlpha = compressionOptions.binaryAlpha;
+    s.externalCompressor = compressionOptions.externalCompressorHash();
+
+    Lock<Mutex> lock(m_settingsMutex);
+
+    for (uint i = 0; i < m_settings.count(); i++) {
+        const Settings & t = m_settings[i];
+        if (t.alphaMode == s.alphaMode && t.format == s.format && t.quality == s.quality && t.pixelType == s.pixelType &&
+            memcmp(t.colorWeight, s.colorWeight, sizeof(s.colorWeight)) == 0 && t.rgbmThreshold == s.rgbmThreshold &&
+            t.fastQuality == s.fastQuality && memcmp(t.adaptiveThreshold, s.adaptiveThreshold, sizeof(s.adaptiveThreshold)) == 0 &&
+            t.decoder == s.decoder && t.binaryAlpha == s.binaryAlpha && t.externalCompressor == s.externalCompressor)
+        {
+            return i;
+        }
+    }
+
+    m_settings.push_back(s);
+    return m_settings.count() - 1;
+}
+
+bool BlockCache::find(uint settings, const void * key, uint keySize, void * output, uint blockSize)
+{
+    nvDebugCheck(keySize <= MaxKeySize && blockSize <= MaxBlockSize);
+
+    const uint hash = sdbmWordHash(key, keySize, settings + 5381);
+    Entry & entry = m_entries[(hash ^ (hash >> 16)) & m_mask];
+
+    // Don't wait for the entry, the block is compressed instead.
+    if (!atomicCompareAndSwap(&entry.lock, 0, 1)) {
+        return false;
+    }
+
+    bool found = entry.settings == settings + 1 && entry.hash == hash && entry.keySize == keySize && memcmp(entry.key, key, keySize) == 0;
+    if (found) {
+        memcpy(output, entry.block, blockSize);
+    }
+
+    storeRelease(&entry.lock, 0);
+    return found;
+}
+
+void BlockCache::insert(uint settings, const void * key, uint keySize, const void * block, uint blockSize)
+{
+    nvDebugCheck(keySize <= MaxKeySize && blockSize <= MaxBlockSize);
+
+    const uint hash = sdbmWordHash(key, keySize, settings + 5381);
+    Entry & entry = m_entries[(hash ^ (hash >> 16)) & m_mask];
+
+    if (!atomicCompareAndSwap(&entry.lock, 0, 1)) {
+        return;
+    }
+
+    entry.settings = settings + 1;
+    entry.hash = hash;
+    entry.keySize = keySize;
+    memcpy(entry.key, key, keySize);
+    memcpy(entry.block, block, blockSize);
+
+    storeRelease(&entry.lock, 0);
+}
+
+void BlockCache::addStatistics(uint lookupCount, uint hitCount)
+{
+    atomicAdd(&m_lookupCount, lookupCount);
+    atomicAdd(&m_hitCount, hitCount);
+}
+
+void BlockCache::statistics(uint * lookupCount, uint * hitCount) const
+{
+    if (lookupCount != NULL) *lookupCount = loadAcquire(&m_lookupCount);
+    if (hitCount != NULL) *hitCount = loadAcquire(&m_hitCount);
+}
@@ -0,0 +1,78 @@
+// This code is in the public domain -- castano@gmail.com
+
+#pragma once
+#ifndef NVTT_BLOCKCACHE_H
+#define NVTT_BLOCKCACHE_H
+
+#include "nvtt.h"
+
+#include "nvthread/Mutex.h"
+
+#include "nvcore/Array.h"
+
+namespace nv
+{
+    // Cache of compressed blocks shared by the compression tasks, so that identical input blocks are only compressed once.
+    // Blocks are looked up by the raw bytes of the input block and the id of the compression settings. The table has a
+    // fixed number of entries and a new block replaces the one in its entry. Entries are locked with a spin lock, but the
+    // lookups never wait: a locked entry is treated as a miss.
+    class BlockCache
+    {
+        NV_FORBID_COPY(BlockCache);
+    public:
+        enum {
+            MaxKeySize = 320,   // sizeof(FloatColorBlock)
+            MaxBlockSize = 16,
+        };
+
+        BlockCache(uint entryCount = 8192);
+        ~BlockCache();
+
+        // Id of the settings that affect the encoding of the blocks. Blocks are only reused with the same settings.
+        uint settingsId(nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions);
+
+        // Copies the compressed block of the given input block to output and returns true if it's in the cache.
+        bool find(uint settings, const void * key, uint keySize, void * output, uint blockSize);
+        void insert(uint settings, const void * key, uint keySize, const void * block, uint blockSize);
+
+        // The tasks count their lookups and hits locally and add them here once they are done.
+        void addStatistics(uint lookupCount, uint hitCount);
+        void statistics(uint * lookupCount, uint * hitCount) const;
+
+    private:
+        struct Entry {
+            uint lock;
+            uint hash;
+            uint settings;      // settings id + 1, 0 if empty.
+            uint keySize;
+            uint8 key[MaxKeySize];
+            uint8 block[MaxBlockSize];
+        };
+
+        struct Settings {
+            nvtt::AlphaMode alphaMode;
+            nvtt::Format format;
+            nvtt::Quality quality;
+            nvtt::PixelType pixelType;
+            float colorWeight[4];
+            float rgbmThreshold;
+            nvtt::Quality fastQuality;      // Quality_Highest if adaptive quality is disabled.
+            float adaptiveThreshold[2];
+            nvtt::Decoder decoder;          // The adaptive quality measures the error with this decoder.
+            bool binaryAlpha;
+            uint externalCompressor;        // Hash of the name, Array moves its elements with memcpy.
+        };
+
+        Entry * m_entries;
+        uint m_mask;
+
+        Mutex m_settingsMutex;
+        Array<Settings> m_settings;
+
+        uint m_lookupCount;
+        uint m_hitCount;
+    };
+
+} // nv namespace
+
+#endif // NVTT_BLOCKCACHE_H
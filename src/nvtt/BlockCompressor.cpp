@@ -23,6 +23,7 @@
 // OTHER DEALINGS IN THE SOFTWARE.
 
 #include "BlockCompressor.h"
+#include "BlockCache.h"
 #include "OutputOptions.h"
 #include "TaskDispatcher.h"
 #include "CompressionOptions.h"
@@ -33,7 +34,10 @@
 
 #include "nvmath/Vector.inl"
 
+#include "nvthread/ParallelFor.h" // ParallelOutputStream
+
 #include "nvcore/Memory.h"
+#include "nvcore/ScratchArena.h"
 #include "nvcore/Array.inl"
 
 #include <new> // placement new
@@ -51,26 +55,113 @@ struct CompressorContext
     const CompressionOptions::Private * compressionOptions;
 
     uint bw, bh, bs;
-    uint8 * mem;
+    ParallelOutputStream * stream;
     CompressorInterface * compressor;
+
+    BlockCache * cache;     // NULL if disabled.
+    uint cacheSettings;
+
+    const CompressionOptions::Private * fastOptions;    // NULL unless adaptive quality is enabled.
 };
 
+static void initBlockCache(CompressorContext * context, BlockCache * cache, AlphaMode alphaMode, const CompressionOptions::Private & compressionOptions)
+{
+    context->cache = cache;
+    context->cacheSettings = (cache != NULL) ? cache->settingsId(alphaMode, compressionOptions) : 0;
+}
 
-// Each task compresses one block.
-void ColorBlockCompressorTask(void * data, int i)
+static void writeBands(void * context, const void * data, uint size)
+{
+    const OutputOptions::Private * outputOptions = (const OutputOptions::Private *)context;
+    outputOptions->writeData(data, size);
+}
+
+// Number of bands buffered by the output stream, enough to keep all the threads busy while the bands are written in order.
+static uint bandSlotCount(TaskDispatcher * dispatcher)
+{
+    int threadCount = dispatcher->threadCount();
+    if (threadCount <= 0) threadCount = nv::processorCount();
+    return max(8U, 4U * uint(threadCount));
+}
+
+
+// Each task compresses a number of bands of 4 pixel rows. The bands are claimed in order from the output stream, which
+// writes them as soon as the previous bands are complete. The rows of the band are converted to 8 bit colors first, so
+// that the source image is read sequentially, and then every block of the band is compressed.
+void ColorBlockCompressorTask(void * data, int /*tid*/, int begin, int end)
 {
     CompressorContext * d = (CompressorContext *) data;
 
-    uint x = i % d->bw;
-    uint y = i / d->bw;
+    const uint w = d->w;
+    const uint h = d->h;
+    const uint srcPlane = w * h;
+
+    ScratchScope scratch;
+    Color32 * rows = scratch.allocate<Color32>(4 * w);
 
-    //for (uint x = 0; x < d->bw; x++)
+    uint lookupCount = 0;
+    uint hitCount = 0;
+
+    for (int i = begin; i < end; i++)
     {
-        ColorBlock rgba;
-        rgba.init(d->w, d->h, d->data, 4*x, 4*y);
+        uint block_y;
+        uint8 * band = d->stream->begin(&block_y);
+
+        const uint y = block_y * 4;
+        const uint band_h = min(h - y, 4U);
+
+        // Convert the rows of the band.
+        for (uint i = 0; i < band_h; i++) {
+            const float * src = d->data + (y + i) * w;
+            Color32 * row = rows + i * w;
+
+            for (uint x = 0; x < w; x++) {
+                row[x].r = uint8(255 * clamp(src[x + 0 * srcPlane], 0.0f, 1.0f));
+                row[x].g = uint8(255 * clamp(src[x + 1 * srcPlane], 0.0f, 1.0f));
+                row[x].b = uint8(255 * clamp(src[x + 2 * srcPlane], 0.0f, 1.0f));
+                row[x].a = uint8(255 * clamp(src[x + 3 * srcPlane], 0.0f, 1.0f));
+            }
+        }
+
+        for (uint block_x = 0; block_x < d->bw; block_x++)
+        {
+            const uint x = block_x * 4;
+            const uint block_w = min(w - x, 4U);
+
+            // Blocks that are smaller than 4x4 are handled by repeating the pixels, same as ColorBlock::init.
+            ColorBlock rgba;
+            for (uint i = 0; i < 4; i++) {
+                const Color32 * row = rows + (i % band_h) * w + x;
+                for (uint e = 0; e < 4; e++) {
+                    rgba.color(e, i) = row[e % block_w];
+                }
+            }
+
+            uint8 * ptr = band + block_x * d->bs;
+
+            // Compressors may modify the block, the key is copied before compressing it.
+            ColorBlock key;
+            if (d->cache != NULL) {
+                lookupCount++;
+                if (d->cache->find(d->cacheSettings, &rgba, sizeof(ColorBlock), ptr, d->bs)) {
+                    hitCount++;
+                    continue;
+                }
+                key = rgba;
+            }
+
+            ((ColorBlockCompressor *) d->compressor)->compressBlock(rgba, d->alphaMode, *d->compressionOptions, ptr);
+
+            if (d->cache != NULL) {
+                d->cache->insert(d->cacheSettings, &key, sizeof(ColorBlock), ptr, d->bs);
+            }
+        }
+
+        d->stream->end(block_y, d->bw * d->bs);
+    }
 
-        uint8 * ptr = d->mem + (y * d->bw + x) * d->bs;
-        ((ColorBlockCompressor *) d->compressor)->compressBlock(rgba, d->alphaMode, *d->compressionOptions, ptr);
+    if (d->cache != NULL) {
+        d->cache->addStatistics(lookupCount, hitCount);
     }
 }
 
@@ -91,6 +182,8 @@ void ColorBlockCompressor::compress(AlphaMode alphaMode, uint w, uint h, uint d,
     context.bh = (h + 3) / 4;
 
     context.compressor = this;
+    initBlockCache(&context, blockCache, alphaMode, compressionOptions);
+    context.fastOptions = NULL;
 
     SequentialTaskDispatcher sequential;
 
@@ -101,68 +194,378 @@ void ColorBlockCompressor::compress(AlphaMode alphaMode, uint w, uint h, uint d,
     dispatcher = &sequential;
 #endif
 
-    const uint count = context.bw * context.bh;
-    const uint size = context.bs * count;
-    context.mem = new uint8[size];
+    // Compressed bands are written in order while the following ones are being compressed.
+    ParallelOutputStream stream(context.bh, context.bw * context.bs, bandSlotCount(dispatcher), writeBands, (void *)&outputOptions);
+    context.stream = &stream;
 
-    dispatcher->dispatch(ColorBlockCompressorTask, &context, count);
+    // Tasks process whole bands, convert the preferred block grain to a number of bands.
+    const uint grain = max(1U, grainSize() / context.bw);
+
+    dispatcher->dispatchRange(ColorBlockCompressorTask, &context, context.bh, grain);
+}
 
-    outputOptions.writeData(context.mem, size);
 
-    delete [] context.mem;
+// Block in the staging buffer of a band.
+struct FloatColorBlock
+{
+    Vector4 colors[16];
+    float weights[16];
+};
+
+// Column of the image that pads column x of a partial block, the pixels of the block are repeated like in ColorBlock::init.
+static NV_FORCEINLINE uint paddingColumn(uint w, uint x)
+{
+    const uint block_x = x & ~3U;
+    return block_x + (x - block_x) % (w - block_x);
 }
 
-// Each task compresses one block.
-void FloatColorCompressorTask(void * data, int i)
+// Copies a band to structure-of-arrays planes, see FloatColorCompressor::compressBlocks. Partial blocks are padded by
+// repeating their pixels, so that encoders that ignore the weights still see the colors of the block. The padding has
+// zero weight.
+template <bool transparency>
+static void copyBandToPlanes(const CompressorContext * d, uint y, float * colors, float * weights)
 {
-    CompressorContext * d = (CompressorContext *) data;
+    const uint w = d->w;
+    const uint h = d->h;
+    const uint stride = d->bw;
+    const uint band_h = min(h - y, 4U);
+
+    for (uint c = 0; c < 4; c++) {
+        const float * src = d->data + w * h * d->d * c;
+
+        for (uint i = 0; i < 4; i++) {
+            const float * row = src + (y + i % band_h) * w;
+            uint x = 0;
+            for (; x < w; x++) {
+                colors[(c * 16 + 4 * i + (x % 4)) * stride + x / 4] = row[x];
+            }
+            for (; x < d->bw * 4; x++) {
+                colors[(c * 16 + 4 * i + (x % 4)) * stride + x / 4] = row[paddingColumn(w, x)];
+            }
+        }
+    }
+
+    const float * a = d->data + w * h * d->d * 3;
+
+    for (uint i = 0; i < 4; i++) {
+        uint x = 0;
+        if (i < band_h) {
+            const float * row = a + (y + i) * w;
+            for (; x < w; x++) {
+                weights[(4 * i + (x % 4)) * stride + x / 4] = transparency ? saturate(row[x]) : 1.0f;
+            }
+        }
+        for (; x < d->bw * 4; x++) {
+            weights[(4 * i + (x % 4)) * stride + x / 4] = 0.0f;
+        }
+    }
+}
 
-    // Copy image to block.
-    const uint block_x = (i % d->bw);
-    const uint block_y = (i / d->bw);
+// Copies block b of the structure-of-arrays planes to a block.
+static void copyBlockFromPlanes(const float * colors, const float * weights, uint stride, uint b, FloatColorBlock * block)
+{
+    for (uint i = 0; i < 16; i++) {
+        block->colors[i].x = colors[(0 * 16 + i) * stride + b];
+        block->colors[i].y = colors[(1 * 16 + i) * stride + b];
+        block->colors[i].z = colors[(2 * 16 + i) * stride + b];
+        block->colors[i].w = colors[(3 * 16 + i) * stride + b];
+        block->weights[i] = weights[i * stride + b];
+    }
+}
 
-    const uint src_x_offset = block_x * 4;
-    const uint src_y_offset = block_y * 4;
+// Copies a band to the staging buffer of blocks. Partial blocks are padded by repeating their pixels with zero weight,
+// like in copyBandToPlanes.
+template <bool transparency>
+static void copyBandToBlocks(const CompressorContext * d, uint y, FloatColorBlock * blocks)
+{
+    const uint w = d->w;
+    const uint h = d->h;
+    const uint band_h = min(h - y, 4U);
+
+    const float * r = d->data + w * h * d->d * 0;
+    const float * g = d->data + w * h * d->d * 1;
+    const float * b = d->data + w * h * d->d * 2;
+    const float * a = d->data + w * h * d->d * 3;
+
+    for (uint i = 0; i < 4; i++) {
+        const uint src_offset = (y + i % band_h) * w;
+        const bool padding = (i >= band_h);
+
+        uint x = 0;
+        for (; x < w; x++) {
+            FloatColorBlock & block = blocks[x / 4];
+            const uint dst_idx = 4 * i + (x % 4);
+            const uint src_idx = src_offset + x;
+            block.colors[dst_idx].x = r[src_idx];
+            block.colors[dst_idx].y = g[src_idx];
+            block.colors[dst_idx].z = b[src_idx];
+            block.colors[dst_idx].w = a[src_idx];
+            block.weights[dst_idx] = padding ? 0.0f : (transparency ? saturate(a[src_idx]) : 1.0f);
+        }
+        for (; x < d->bw * 4; x++) {
+            FloatColorBlock & block = blocks[x / 4];
+            const uint dst_idx = 4 * i + (x % 4);
+            const uint src_idx = src_offset + paddingColumn(w, x);
+            block.colors[dst_idx].x = r[src_idx];
+            block.colors[dst_idx].y = g[src_idx];
+            block.colors[dst_idx].z = b[src_idx];
+            block.colors[dst_idx].w = a[src_idx];
+            block.weights[dst_idx] = 0.0f;
+        }
+    }
+}
 
-    const float * r = (const float *)d->data + d->w * d->h * d->d * 0;
-    const float * g = (const float *)d->data + d->w * d->h * d->d * 1;
-    const float * b = (const float *)d->data + d->w * d->h * d->d * 2;
-    const float * a = (const float *)d->data + d->w * d->h * d->d * 3;
+// Returns true if all the pixels of the block have the same color, or if they are all transparent in transparency mode.
+// The color of transparent pixels doesn't matter, those blocks are returned as transparent black. Pixels with zero weight
+// pad partial blocks when the alpha is not transparency, and they are skipped. In transparency mode the padding can't be
+// told apart from transparent pixels, but it repeats the pixels of the block and doesn't change the result.
+template <bool transparency>
+static bool isSingleColorBlock(const FloatColorBlock & block, Vector4 * color)
+{
+    if (transparency) {
+        bool transparent = true;
+        for (uint i = 0; i < 16 && transparent; i++) {
+            transparent = (block.weights[i] == 0.0f);
+        }
+        if (transparent) {
+            *color = Vector4(0);
+            return true;
+        }
+    }
 
-    Vector4 colors[16];
-    float weights[16];
+    // The first pixel is never padding.
+    for (uint i = 1; i < 16; i++) {
+        if (!transparency && block.weights[i] == 0.0f) continue;
+        if (block.colors[i] != block.colors[0]) return false;
+    }
+
+    *color = block.colors[0];
+    return true;
+}
+
+float nv::evaluateBlockError(const Vector4 colors[16], const float weights[16], const Vector4 & colorWeights, const ColorBlock & decoded)
+{
+    float error = 0.0f;
+    for (uint i = 0; i < 16; i++) {
+        const Vector4 c = 255.0f * saturate(colors[i]);
+        const Color32 p = decoded.color(i);
+        const float dr = c.x - p.r;
+        const float dg = c.y - p.g;
+        const float db = c.z - p.b;
+        const float da = c.w - p.a;
+        error += weights[i] * (colorWeights.x * dr * dr + colorWeights.y * dg * dg + colorWeights.z * db * db) + colorWeights.w * da * da;
+    }
+    return error / 16.0f;
+}
+
+// Variance of the block, in 8 bit units, weighted like evaluateBlockError.
+static float blockVariance(const FloatColorBlock & block, const Vector4 & colorWeights)
+{
+    Vector4 mean(0.0f);
+    for (uint i = 0; i < 16; i++) {
+        mean += 255.0f * saturate(block.colors[i]);
+    }
+    mean *= 1.0f / 16.0f;
+
+    float variance = 0.0f;
+    for (uint i = 0; i < 16; i++) {
+        const Vector4 c = 255.0f * saturate(block.colors[i]) - mean;
+        variance += block.weights[i] * (colorWeights.x * c.x * c.x + colorWeights.y * c.y * c.y + colorWeights.z * c.z * c.z) + colorWeights.w * c.w * c.w;
+    }
+    return variance / 16.0f;
+}
+
+// Calls the block compressor of T directly, so that it's inlined in the band task specialized for T. The generic band
+// task calls it through the vtable.
+template <typename T>
+struct BlockKernel
+{
+    static NV_FORCEINLINE void compressBlock(FloatColorCompressor * compressor, Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
+    {
+        static_cast<T *>(compressor)->T::compressBlock(colors, weights, compressionOptions, output);
+    }
+};
+
+template <>
+struct BlockKernel<FloatColorCompressor>
+{
+    static NV_FORCEINLINE void compressBlock(FloatColorCompressor * compressor, Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
+    {
+        compressor->compressBlock(colors, weights, compressionOptions, output);
+    }
+};
+
+// Compresses a block compressed at the fast quality of the adaptive quality again at the full quality, if its error is
+// above the threshold. The error threshold is raised in proportion to the standard deviation of the block, errors are
+// less visible in noisy blocks. The full quality search does not always find a better block, the output is replaced only
+// if the error is lower.
+template <typename T>
+static void refineBlock(const CompressorContext * d, FloatColorCompressor * compressor, const FloatColorBlock & block, uint8 * output)
+{
+    const CompressionOptions::Private & compressionOptions = *d->compressionOptions;
+
+    float threshold = compressionOptions.adaptiveErrorThreshold;
+    if (compressionOptions.adaptiveVarianceThreshold > 0.0f) {
+        threshold += compressionOptions.adaptiveVarianceThreshold * sqrtf(blockVariance(block, compressionOptions.colorWeight));
+    }
+
+    const float fastError = compressor->evaluateError(block.colors, block.weights, compressionOptions, output);
+    if (fastError <= threshold * threshold) {
+        return;
+    }
+
+    // Compressors may modify the block, the error is evaluated with the original.
+    FloatColorBlock full = block;
+    uint8 fullOutput[BlockCache::MaxBlockSize];
+    nvDebugCheck(d->bs <= BlockCache::MaxBlockSize);
+    BlockKernel<T>::compressBlock(compressor, full.colors, full.weights, compressionOptions, fullOutput);
+
+    if (compressor->evaluateError(block.colors, block.weights, compressionOptions, fullOutput) < fastError) {
+        memcpy(output, fullOutput, d->bs);
+    }
+}
 
-    const uint block_w = min(d->w - block_x * 4, 4U);
-    const uint block_h = min(d->h - block_y * 4, 4U);
-
-    uint x, y;
-    for (y = 0; y < block_h; y++) {
-        for (x = 0; x < block_w; x++) {
-            uint dst_idx = 4 * y + x;
-            uint src_idx = (y + src_y_offset) * d->w + (x + src_x_offset);
-            colors[dst_idx].x = r[src_idx];
-            colors[dst_idx].y = g[src_idx];
-            colors[dst_idx].z = b[src_idx];
-            colors[dst_idx].w = a[src_idx];
-            weights[dst_idx] = (d->alphaMode == AlphaMode_Transparency) ? saturate(a[src_idx]) : 1.0f;
+// Compresses a block of the band. Single color blocks skip the search when the compressor has a direct encoding for them,
+// that is faster than a cache lookup. The cache is keyed on the colors and the weights of the block, copied before
+// compressing it because compressors may modify the block.
+template <typename T, bool transparency>
+static NV_FORCEINLINE void compressBlock(const CompressorContext * d, FloatColorCompressor * compressor, FloatColorBlock * block, uint8 * output, uint * lookupCount, uint * hitCount)
+{
+    Vector4 color;
+    if (isSingleColorBlock<transparency>(*block, &color) && compressor->compressSingleColor(color, *d->compressionOptions, output)) {
+        return;
+    }
+
+    FloatColorBlock key;
+    if (d->cache != NULL) {
+        (*lookupCount)++;
+        if (d->cache->find(d->cacheSettings, block, sizeof(FloatColorBlock), output, d->bs)) {
+            (*hitCount)++;
+            return;
         }
-        for (; x < 4; x++) {
-            uint dst_idx = 4 * y + x;
-            colors[dst_idx] = Vector4(0);
-            weights[dst_idx] = 0.0f;
+        key = *block;
+    }
+
+    if (d->fastOptions != NULL) {
+        // Compressors may modify the block, the error is evaluated with the original.
+        FloatColorBlock fast = *block;
+        BlockKernel<T>::compressBlock(compressor, fast.colors, fast.weights, *d->fastOptions, output);
+
+        refineBlock<T>(d, compressor, *block, output);
+    }
+    else {
+        BlockKernel<T>::compressBlock(compressor, block->colors, block->weights, *d->compressionOptions, output);
+    }
+
+    if (d->cache != NULL) {
+        d->cache->insert(d->cacheSettings, &key, sizeof(FloatColorBlock), output, d->bs);
+    }
+}
+
+// Each task compresses a number of bands of 4 pixel rows, claimed in order from the output stream. The planar channels
+// of the band are interleaved into a staging buffer of blocks reading the source rows sequentially, and then every
+// block of the band is compressed. Compressors that encode whole bands get the band in planar layout instead. With
+// adaptive quality the bands are compressed at the fast quality, and then the blocks above the error threshold again.
+// The task is specialized for the compressor type and the alpha mode, see FloatColorCompressor::bandTask.
+template <typename T, bool transparency>
+static void FloatColorCompressorTask(void * data, int /*tid*/, int begin, int end)
+{
+    CompressorContext * d = (CompressorContext *) data;
+    FloatColorCompressor * compressor = (FloatColorCompressor *)d->compressor;
+
+    // Rate-distortion optimization needs the blocks one at a time.
+    const bool rdo = d->compressionOptions->rdoLambda > 0.0f;
+
+    const CompressionOptions::Private & bandOptions = (d->fastOptions != NULL) ? *d->fastOptions : *d->compressionOptions;
+
+    if (compressor->compressesBands(bandOptions) && !rdo) {
+        ScratchScope scratch;
+        float * colors = scratch.allocate<float>(4 * 16 * d->bw, 64);
+        float * weights = scratch.allocate<float>(16 * d->bw, 64);
+
+        for (int i = begin; i < end; i++)
+        {
+            uint block_y;
+            uint8 * band = d->stream->begin(&block_y);
+
+            copyBandToPlanes<transparency>(d, block_y * 4, colors, weights);
+            compressor->compressBlocks(d->bw, colors, weights, d->bw, bandOptions, band);
+
+            if (d->fastOptions != NULL) {
+                for (uint b = 0; b < d->bw; b++) {
+                    FloatColorBlock block;
+                    copyBlockFromPlanes(colors, weights, d->bw, b, &block);
+
+                    refineBlock<T>(d, compressor, block, band + b * d->bs);
+                }
+            }
+
+            d->stream->end(block_y, d->bw * d->bs);
         }
+        return;
     }
-    for (; y < 4; y++) {
-        for (x = 0; x < 4; x++) {
-            uint dst_idx = 4 * y + x;
-            colors[dst_idx] = Vector4(0);
-            weights[dst_idx] = 0.0f;
+
+    // Aligned for the SIMD loads of the block compressors.
+    ScratchScope scratch;
+    FloatColorBlock * blocks = scratch.allocate<FloatColorBlock>(d->bw, 64);
+
+    uint lookupCount = 0;
+    uint hitCount = 0;
+
+    for (int i = begin; i < end; i++)
+    {
+        uint block_y;
+        uint8 * band = d->stream->begin(&block_y);
+
+        copyBandToBlocks<transparency>(d, block_y * 4, blocks);
+
+        // Compress blocks.
+        for (uint block_x = 0; block_x < d->bw; block_x++) {
+            uint8 * output = band + block_x * d->bs;
+
+            compressBlock<T, transparency>(d, compressor, &blocks[block_x], output, &lookupCount, &hitCount);
+
+            // The block may be replaced by one that reuses the previous blocks of the band.
+            if (rdo) {
+                compressor->optimizeRate(blocks[block_x].colors, blocks[block_x].weights, band, block_x, *d->compressionOptions, output);
+            }
         }
+
+        d->stream->end(block_y, d->bw * d->bs);
+    }
+
+    if (d->cache != NULL) {
+        d->cache->addStatistics(lookupCount, hitCount);
+    }
+}
+
+template <typename T>
+static nvtt::RangeTask * selectBandTask(AlphaMode alphaMode)
+{
+    if (alphaMode == AlphaMode_Transparency) return FloatColorCompressorTask<T, true>;
+    return FloatColorCompressorTask<T, false>;
+}
+
+nvtt::RangeTask * FloatColorCompressor::bandTask(AlphaMode alphaMode) const
+{
+    return selectBandTask<FloatColorCompressor>(alphaMode);
+}
+
+uint FloatColorCompressor::grainSize(const CompressionOptions::Private & compressionOptions) const
+{
+    // Cheap compressors amortize the dispatch overhead over more blocks.
+    return (compressionOptions.quality == Quality_Fastest) ? 64 : 16;
+}
+
+void FloatColorCompressor::compressBlocks(uint count, const float * colors, const float * weights, uint stride, const CompressionOptions::Private & compressionOptions, void * output)
+{
+    const uint bs = blockSize(compressionOptions);
+
+    for (uint b = 0; b < count; b++) {
+        FloatColorBlock block;
+        copyBlockFromPlanes(colors, weights, stride, b, &block);
+        compressBlock(block.colors, block.weights, compressionOptions, (uint8 *)output + b * bs);
     }
-    
-    // Compress block.
-    uint8 * output = d->mem + (block_y * d->bw + block_x) * d->bs;
-    ((FloatColorCompressor *)d->compressor)->compressBlock(colors, weights, *d->compressionOptions, output);
 }
 
 
@@ -183,6 +586,12 @@ void FloatColorCompressor::compress(AlphaMode alphaMode, uint w, uint h, uint d,
     context.bh = (h + 3) / 4;
 
     context.compressor = this;
+    initBlockCache(&context, blockCache, alphaMode, compressionOptions);
+
+    // Options of the first pass of the adaptive quality.
+    CompressionOptions::Private fastOptions = compressionOptions;
+    fastOptions.quality = compressionOptions.fastQuality;
+    context.fastOptions = (compressionOptions.isAdaptiveQuality() && evaluatesError()) ? &fastOptions : NULL;
 
     SequentialTaskDispatcher sequential;
 
@@ -193,20 +602,20 @@ void FloatColorCompressor::compress(AlphaMode alphaMode, uint w, uint h, uint d,
     dispatcher = &sequential;
 #endif
 
-    const uint count = context.bw * context.bh;
-    const uint size = context.bs * count;
-    context.mem = new uint8[size];
+    // Compressed bands are written in order while the following ones are being compressed.
+    ParallelOutputStream stream(context.bh, context.bw * context.bs, bandSlotCount(dispatcher), writeBands, (void *)&outputOptions);
+    context.stream = &stream;
 
-    dispatcher->dispatch(FloatColorCompressorTask, &context, count);
+    // Tasks process whole bands, convert the preferred block grain to a number of bands.
+    const uint grain = max(1U, grainSize(compressionOptions) / context.bw);
 
-    outputOptions.writeData(context.mem, size);
-
-    delete [] context.mem;
+    dispatcher->dispatchRange(bandTask(alphaMode), &context, context.bh, grain);
 }
 
 
 // BC1
 #include "icbc.h"
+#include "CompressorRDO.h"
 
 inline icbc::Quality qualityLevel(const CompressionOptions::Private & compressionOptions) {
     if (compressionOptions.quality == Quality_Fastest) 
@@ -216,61 +625,263 @@ inline icbc::Quality qualityLevel(const CompressionOptions::Private & compressio
     return icbc::Quality_Default;
 }
 
+nvtt::RangeTask * CompressorDXT1::bandTask(AlphaMode alphaMode) const
+{
+    return selectBandTask<CompressorDXT1>(alphaMode);
+}
+
 void CompressorDXT1::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
 {
     bool allowTransparentBlack = !compressionOptions.binaryAlpha;
     icbc::compress_dxt1(qualityLevel(compressionOptions), (float*)colors, weights, compressionOptions.colorWeight.component, allowTransparentBlack, allowTransparentBlack, output);
 }
 
+// The fast level is vectorized across the blocks of the band.
+bool CompressorDXT1::compressesBands(const CompressionOptions::Private & compressionOptions) const
+{
+    return qualityLevel(compressionOptions) == icbc::Quality_Fast;
+}
+
+void CompressorDXT1::compressBlocks(uint count, const float * colors, const float * weights, uint stride, const CompressionOptions::Private & compressionOptions, void * output)
+{
+    bool allowTransparentBlack = !compressionOptions.binaryAlpha;
+    icbc::compress_dxt1_batch(qualityLevel(compressionOptions), int(count), colors, weights, int(stride), compressionOptions.colorWeight.component, allowTransparentBlack, allowTransparentBlack, output);
+}
+
+void CompressorDXT1::optimizeRate(const Vector4 colors[16], const float weights[16], const void * previous, uint previousCount, const CompressionOptions::Private & compressionOptions, void * output)
+{
+    bool allowTransparentBlack = !compressionOptions.binaryAlpha;
+    bool d3d9 = (compressionOptions.decoder == Decoder_D3D9);
+    rdo_bc1(colors, weights, compressionOptions.colorWeight.xyz(), allowTransparentBlack, d3d9, compressionOptions.rdoLambda, (const BlockDXT1 *)previous, previousCount, (BlockDXT1 *)output);
+}
+
+float CompressorDXT1::evaluateError(const Vector4 colors[16], const float weights[16], const CompressionOptions::Private & compressionOptions, const void * block) const
+{
+    ColorBlock decoded;
+    ((const BlockDXT1 *)block)->decodeBlock(&decoded, compressionOptions.decoder == Decoder_D3D9);
+
+    // The alpha of BC1 is not compressed.
+    return evaluateBlockError(colors, weights, Vector4(compressionOptions.colorWeight.xyz(), 0.0f), decoded);
+}
+
 
 // @@ BC1a
 
-// @@ BC2
+// BC2, BC3
+#include "OptimalCompressDXT.h"
+#include "QuickCompressDXT.h"
+
+// Quantizes a channel of the block the same way as the ColorBlock compressors.
+static void initAlphaBlock(const Vector4 colors[16], uint channel, AlphaBlock4x4 * block)
+{
+    for (uint i = 0; i < 16; i++) {
+        block->alpha[i] = uint8(255 * clamp(colors[i].component[channel], 0.0f, 1.0f));
+        block->weights[i] = 1.0f;
+    }
+}
+
+nvtt::RangeTask * CompressorDXT3::bandTask(AlphaMode alphaMode) const
+{
+    return selectBandTask<CompressorDXT3>(alphaMode);
+}
+
+void CompressorDXT3::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
+{
+    BlockDXT3 * block = new(output) BlockDXT3;
+
+    // Compress explicit alpha.
+    AlphaBlock4x4 alpha;
+    initAlphaBlock(colors, 3, &alpha);
+    OptimalCompress::compressDXT3A(alpha, &block->alpha);
+
+    // Compress color. The color block of BC2 and BC3 is always decoded in four color mode.
+    icbc::compress_dxt1(qualityLevel(compressionOptions), (float*)colors, weights, compressionOptions.colorWeight.component, /*three_color_mode=*/false, /*three_color_black=*/false, &block->color);
+}
+
+float CompressorDXT3::evaluateError(const Vector4 colors[16], const float weights[16], const CompressionOptions::Private & compressionOptions, const void * block) const
+{
+    ColorBlock decoded;
+    ((const BlockDXT3 *)block)->decodeBlock(&decoded, compressionOptions.decoder == Decoder_D3D9);
+    return evaluateBlockError(colors, weights, compressionOptions.colorWeight, decoded);
+}
+
+nvtt::RangeTask * CompressorDXT5::bandTask(AlphaMode alphaMode) const
+{
+    return selectBandTask<CompressorDXT5>(alphaMode);
+}
+
+void CompressorDXT5::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
+{
+    BlockDXT5 * block = new(output) BlockDXT5;
+
+    // Compress alpha.
+    AlphaBlock4x4 alpha;
+    initAlphaBlock(colors, 3, &alpha);
+
+    if (compressionOptions.quality == Quality_Highest)
+    {
+        OptimalCompress::compressDXT5A(alpha, &block->alpha);
+    }
+    else
+    {
+        QuickCompress::compressDXT5A(alpha, &block->alpha);
+    }
+
+    // Compress color.
+    icbc::compress_dxt1(qualityLevel(compressionOptions), (float*)colors, weights, compressionOptions.colorWeight.component, /*three_color_mode=*/false, /*three_color_black=*/false, &block->color);
+}
+
+void CompressorDXT5::optimizeRate(const Vector4 colors[16], const float weights[16], const void * previous, uint previousCount, const CompressionOptions::Private & compressionOptions, void * output)
+{
+    bool d3d9 = (compressionOptions.decoder == Decoder_D3D9);
+    rdo_bc3(colors, weights, compressionOptions.colorWeight, d3d9, compressionOptions.rdoLambda, (const BlockDXT5 *)previous, previousCount, (BlockDXT5 *)output);
+}
+
+float CompressorDXT5::evaluateError(const Vector4 colors[16], const float weights[16], const CompressionOptions::Private & compressionOptions, const void * block) const
+{
+    ColorBlock decoded;
+    ((const BlockDXT5 *)block)->decodeBlock(&decoded, compressionOptions.decoder == Decoder_D3D9);
+    return evaluateBlockError(colors, weights, compressionOptions.colorWeight, decoded);
+}
+
+nvtt::RangeTask * CompressorDXT5n::bandTask(AlphaMode alphaMode) const
+{
+    return selectBandTask<CompressorDXT5n>(alphaMode);
+}
+
+void CompressorDXT5n::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
+{
+    BlockDXT5 * block = new(output) BlockDXT5;
+
+    // Compress Y.
+    if (compressionOptions.quality == Quality_Highest)
+    {
+        ColorBlock rgba;
+        for (uint i = 0; i < 16; i++) {
+            rgba.color(i) = Color32(0, uint8(255 * clamp(colors[i].y, 0.0f, 1.0f)), 0);
+        }
+        OptimalCompress::compressDXT1G(rgba, &block->color);
+    }
+    else
+    {
+        // Only the green channel is measured, red and blue are constant.
+        Vector4 tile[16];
+        for (uint i = 0; i < 16; i++) {
+            tile[i] = Vector4(1.0f, colors[i].y, 0.0f, colors[i].w);
+        }
+
+        const float color_weights[3] = { 0.0f, 1.0f, 0.0f };
+        icbc::compress_dxt1(qualityLevel(compressionOptions), (float*)tile, weights, color_weights, /*three_color_mode=*/false, /*three_color_black=*/false, &block->color);
+    }
 
-// @@ BC3
+    // Compress X.
+    AlphaBlock4x4 alpha;
+    initAlphaBlock(colors, 0, &alpha);
+
+    if (compressionOptions.quality == Quality_Highest)
+    {
+        OptimalCompress::compressDXT5A(alpha, &block->alpha);
+    }
+    else
+    {
+        QuickCompress::compressDXT5A(alpha, &block->alpha);
+    }
+}
 
 
 // BC3_RGBM
 #include "CompressorDXT5_RGBM.h"
 
+nvtt::RangeTask * CompressorBC3_RGBM::bandTask(AlphaMode alphaMode) const
+{
+    return selectBandTask<CompressorBC3_RGBM>(alphaMode);
+}
+
 void CompressorBC3_RGBM::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
 {
     compress_dxt5_rgbm(colors, weights, compressionOptions.rgbmThreshold, (BlockDXT5 *)output);
 }
 
+// The fastest quality compresses the RGB part of the band with the fast BC1 level.
+bool CompressorBC3_RGBM::compressesBands(const CompressionOptions::Private & compressionOptions) const
+{
+    return compressionOptions.quality == Quality_Fastest;
+}
+
+void CompressorBC3_RGBM::compressBlocks(uint count, const float * colors, const float * weights, uint stride, const CompressionOptions::Private & compressionOptions, void * output)
+{
+    compress_dxt5_rgbm(count, colors, weights, stride, compressionOptions.rgbmThreshold, icbc::Quality_Fast, (BlockDXT5 *)output);
+}
+
 
 // ETC
 #include "CompressorETC.h"
 
+nvtt::RangeTask * CompressorETC1::bandTask(AlphaMode alphaMode) const
+{
+    return selectBandTask<CompressorETC1>(alphaMode);
+}
+
 void CompressorETC1::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
 {
-    compress_etc1(colors, weights, compressionOptions.colorWeight.xyz(), output);
+    compress_etc1(colors, weights, compressionOptions.colorWeight.xyz(), compressionOptions.quality, output);
+}
+bool CompressorETC1::compressSingleColor(const Vector4 & color, const CompressionOptions::Private & compressionOptions, void * output)
+{
+    compress_etc1_single_color(color, compressionOptions.colorWeight.xyz(), output);
+    return true;
 }
+nvtt::RangeTask * CompressorETC2_R::bandTask(AlphaMode alphaMode) const
+{
+    return selectBandTask<CompressorETC2_R>(alphaMode);
+}
+
 void CompressorETC2_R::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
 {
-    // @@ Change radius based on quality.
-    compress_eac(colors, weights, /*input_channel=*/1, /*search_radius=*/1, /*use_11bit_mode=*/true, output);
+    compress_eac(colors, weights, /*input_channel=*/1, eac_search_radius(compressionOptions.quality), /*use_11bit_mode=*/true, output);
 }
+nvtt::RangeTask * CompressorETC2_RG::bandTask(AlphaMode alphaMode) const
+{
+    return selectBandTask<CompressorETC2_RG>(alphaMode);
+}
+
 void CompressorETC2_RG::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
 {
-    //compress_eac_rg(colors, weights, 1, 2, output);
+    compress_eac_rg(colors, weights, eac_search_radius(compressionOptions.quality), output);
+}
+nvtt::RangeTask * CompressorETC2_RGB::bandTask(AlphaMode alphaMode) const
+{
+    return selectBandTask<CompressorETC2_RGB>(alphaMode);
 }
+
 void CompressorETC2_RGB::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
 {
-    // @@ Tweak quality options.
-    compress_etc2(colors, weights, compressionOptions.colorWeight.xyz(), output);
+    compress_etc2(colors, weights, compressionOptions.colorWeight.xyz(), compressionOptions.quality, output);
+}
+bool CompressorETC2_RGB::compressSingleColor(const Vector4 & color, const CompressionOptions::Private & compressionOptions, void * output)
+{
+    compress_etc2_single_color(color, compressionOptions.colorWeight.xyz(), output);
+    return true;
+}
+nvtt::RangeTask * CompressorETC2_RGBA::bandTask(AlphaMode alphaMode) const
+{
+    return selectBandTask<CompressorETC2_RGBA>(alphaMode);
 }
+
 void CompressorETC2_RGBA::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
 {
-    // @@ Tweak quality options.
-    // @@ Change radius based on quality.
-    compress_etc2_eac(colors, weights, compressionOptions.colorWeight.xyz(), output);
+    compress_etc2_eac(colors, weights, compressionOptions.colorWeight.xyz(), compressionOptions.quality, output);
 }
-/*void CompressorETC2_RG::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
+bool CompressorETC2_RGBA::compressSingleColor(const Vector4 & color, const CompressionOptions::Private & compressionOptions, void * output)
 {
-    // @@ Change radius based on quality.
-    compress_eac_rg(colors, weights, compressionOptions.colorWeight.xyz(), output);
-}*/
+    compress_etc2_eac_single_color(color, compressionOptions.colorWeight.xyz(), output);
+    return true;
+}
+nvtt::RangeTask * CompressorETC2_RGBM::bandTask(AlphaMode alphaMode) const
+{
+    return selectBandTask<CompressorETC2_RGBM>(alphaMode);
+}
+
 void CompressorETC2_RGBM::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
 {
     compress_etc2_rgbm(colors, weights, compressionOptions.rgbmThreshold, output);
@@ -434,10 +1045,10 @@ void EtcLibCompressor::compress(AlphaMode alphaMode, uint w, uint h, uint d, con
 #if defined(HAVE_RGETC)
 #include "rg_etc1.h"
 
-NV_AT_STARTUP(rg_etc1::pack_etc1_block_init()); // @@ Do this in context init.
-
 void RgEtcCompressor::compressBlock(ColorBlock & rgba, AlphaMode alphaMode, const CompressionOptions::Private & compressionOptions, void * output)
 {
+    init_rg_etc();
+
     rg_etc1::etc1_pack_params pack_params;
 
     pack_params.m_quality = rg_etc1::cMediumQuality;
@@ -511,6 +1122,72 @@ void EtcIntelCompressor::compress(nvtt::AlphaMode alphaMode, uint w, uint h, uin
 
 #endif
 
+#if defined(HAVE_CMP_CORE)
+#include "CMP_Core.h"
+
+#include "nvmath/Half.h"
+#include "nvmath/ftoi.h"
+
+void CmpCompressorBC6::compress(AlphaMode alphaMode, uint w, uint h, uint d, const float * data, TaskDispatcher * dispatcher, const CompressionOptions::Private & compressionOptions, const OutputOptions::Private & outputOptions)
+{
+    // Above 0.8 CMP refines the endpoints of every partition, which is very slow for a small gain. Only do that at the highest quality.
+    float quality = 0.5f;
+    if (compressionOptions.quality == Quality_Fastest) quality = 0.1f;
+    else if (compressionOptions.quality == Quality_Highest) quality = 1.0f;
+
+    CreateOptionsBC6(&options);
+    SetQualityBC6(options, quality);
+
+    FloatColorCompressor::compress(alphaMode, w, h, d, data, dispatcher, compressionOptions, outputOptions);
+
+    DestroyOptionsBC6(options);
+    options = NULL;
+}
+
+void CmpCompressorBC6::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
+{
+    // CMP only encodes unsigned BC6, negative values are clamped.
+    uint16 rgb[16 * 3];
+    for (uint i = 0; i < 16; i++) {
+        rgb[3 * i + 0] = to_half(max(colors[i].x, 0.0f));
+        rgb[3 * i + 1] = to_half(max(colors[i].y, 0.0f));
+        rgb[3 * i + 2] = to_half(max(colors[i].z, 0.0f));
+    }
+
+    CompressBlockBC6(rgb, 4 * 3, (unsigned char *)output, options);
+}
+
+void CmpCompressorBC7::compress(AlphaMode alphaMode, uint w, uint h, uint d, const float * data, TaskDispatcher * dispatcher, const CompressionOptions::Private & compressionOptions, const OutputOptions::Private & outputOptions)
+{
+    float quality = 0.5f;
+    if (compressionOptions.quality == Quality_Fastest) quality = 0.1f;
+    else if (compressionOptions.quality == Quality_Production) quality = 0.8f;
+    else if (compressionOptions.quality == Quality_Highest) quality = 1.0f;
+
+    CreateOptionsBC7(&options);
+    SetQualityBC7(options, quality);
+
+    FloatColorCompressor::compress(alphaMode, w, h, d, data, dispatcher, compressionOptions, outputOptions);
+
+    DestroyOptionsBC7(options);
+    options = NULL;
+}
+
+void CmpCompressorBC7::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
+{
+    uint8 rgba[16 * 4];
+    for (uint i = 0; i < 16; i++) {
+        rgba[4 * i + 0] = uint8(ftoi_round(255.0f * saturate(colors[i].x)));
+        rgba[4 * i + 1] = uint8(ftoi_round(255.0f * saturate(colors[i].y)));
+        rgba[4 * i + 2] = uint8(ftoi_round(255.0f * saturate(colors[i].z)));
+        rgba[4 * i + 3] = uint8(ftoi_round(255.0f * saturate(colors[i].w)));
+    }
+
+    CompressBlockBC7(rgba, 4 * 4, (unsigned char *)output, options);
+}
+
+#endif
+
 #if defined(HAVE_PVRTEXTOOL)
 
 #include <PVRTextureUtilities.h> // for CPVRTexture, CPVRTextureHeader, PixelType, Transcode
@@ -8,20 +8,67 @@ namespace nv
     struct ColorBlock;
     class Vector4;
 
+    // Weighted squared error of a decoded block, in 8 bit units, averaged over the 16 pixels. The color error of each
+    // pixel is scaled by its weight, the alpha error is not.
+    float evaluateBlockError(const Vector4 colors[16], const float weights[16], const Vector4 & colorWeights, const ColorBlock & decoded);
+
     struct ColorBlockCompressor : public CompressorInterface
     {
+        ColorBlockCompressor() : blockCache(NULL) {}
+
         virtual void compress(nvtt::AlphaMode alphaMode, uint w, uint h, uint d, const float * rgba, nvtt::TaskDispatcher * dispatcher, const nvtt::CompressionOptions::Private & compressionOptions, const nvtt::OutputOptions::Private & outputOptions);
 
         virtual void compressBlock(ColorBlock & rgba, nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions, void * output) = 0;
         virtual uint blockSize() const = 0;
+
+        // Preferred number of blocks compressed by each task.
+        virtual uint grainSize() const { return 16; }
+
+        virtual void setBlockCache(BlockCache * cache) { blockCache = cache; }
+        BlockCache * blockCache;
     };
 
     struct FloatColorCompressor : public CompressorInterface
     {
+        FloatColorCompressor() : blockCache(NULL) {}
+
         virtual void compress(nvtt::AlphaMode alphaMode, uint w, uint h, uint d, const float * rgba, nvtt::TaskDispatcher * dispatcher, const nvtt::CompressionOptions::Private & compressionOptions, const nvtt::OutputOptions::Private & outputOptions);
 
         virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output) = 0;
         virtual uint blockSize(const nvtt::CompressionOptions::Private & compressionOptions) const = 0;
+
+        // Blocks in which all the pixels have the same color, and fully transparent blocks in transparency mode, are
+        // passed here first as a single color. Transparent blocks are passed as transparent black. Compressors with a
+        // direct encoding for them write the block and return true, otherwise the block goes through compressBlock.
+        virtual bool compressSingleColor(const Vector4 & color, const nvtt::CompressionOptions::Private & compressionOptions, void * output) { return false; }
+
+        // Preferred number of blocks compressed by each task.
+        virtual uint grainSize(const nvtt::CompressionOptions::Private & compressionOptions) const;
+
+        // Task that compresses the bands of a level, selected once per level. The compressors defined in BlockCompressor.cpp
+        // return a task specialized for their type and the alpha mode, which calls their compressBlock directly so that it
+        // can be inlined in the loop over the blocks.
+        virtual nvtt::RangeTask * bandTask(nvtt::AlphaMode alphaMode) const;
+
+        // Compressors that encode many blocks at once return true, and then receive whole bands of blocks through
+        // compressBlocks instead of compressBlock. The blocks are in structure-of-arrays layout: texel i of block b is at
+        // index i * stride + b of each plane, and colors holds the r, g, b and a planes, each 16 * stride floats.
+        virtual bool compressesBands(const nvtt::CompressionOptions::Private & compressionOptions) const { return false; }
+        virtual void compressBlocks(uint count, const float * colors, const float * weights, uint stride, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+
+        // Rate-distortion optimization, see CompressionOptions::setRateDistortionLambda. Called after each block is
+        // compressed with the blocks that precede it in the band, which may be reused to replace the block in output.
+        // Bands are compressed one block at a time when it's enabled.
+        virtual void optimizeRate(const Vector4 colors[16], const float weights[16], const void * previous, uint previousCount, const nvtt::CompressionOptions::Private & compressionOptions, void * output) {}
+
+        // Adaptive quality, see CompressionOptions::setAdaptiveQuality. Compressors that can evaluate the error of their
+        // blocks return true, and then evaluateError returns the error of the block as in evaluateBlockError.
+        virtual bool evaluatesError() const { return false; }
+        virtual float evaluateError(const Vector4 colors[16], const float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, const void * block) const { return 0.0f; }
+
+        // Bands are not looked up in the cache, only the blocks compressed one at a time.
+        virtual void setBlockCache(BlockCache * cache) { blockCache = cache; }
+        BlockCache * blockCache;
     };
 
 
@@ -29,14 +76,59 @@ namespace nv
     struct CompressorDXT1 : public FloatColorCompressor
     {
         virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual nvtt::RangeTask * bandTask(nvtt::AlphaMode alphaMode) const;
         virtual uint blockSize(const nvtt::CompressionOptions::Private &) const { return 8; }
+
+        virtual bool compressesBands(const nvtt::CompressionOptions::Private & compressionOptions) const;
+        virtual void compressBlocks(uint count, const float * colors, const float * weights, uint stride, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+
+        virtual void optimizeRate(const Vector4 colors[16], const float weights[16], const void * previous, uint previousCount, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+
+        virtual bool evaluatesError() const { return true; }
+        virtual float evaluateError(const Vector4 colors[16], const float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, const void * block) const;
+    };
+
+    // BC2
+    struct CompressorDXT3 : public FloatColorCompressor
+    {
+        virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual nvtt::RangeTask * bandTask(nvtt::AlphaMode alphaMode) const;
+        virtual uint blockSize(const nvtt::CompressionOptions::Private &) const { return 16; }
+
+        virtual bool evaluatesError() const { return true; }
+        virtual float evaluateError(const Vector4 colors[16], const float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, const void * block) const;
+    };
+
+    // BC3
+    struct CompressorDXT5 : public FloatColorCompressor
+    {
+        virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual nvtt::RangeTask * bandTask(nvtt::AlphaMode alphaMode) const;
+        virtual uint blockSize(const nvtt::CompressionOptions::Private &) const { return 16; }
+
+        virtual void optimizeRate(const Vector4 colors[16], const float weights[16], const void * previous, uint previousCount, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+
+        virtual bool evaluatesError() const { return true; }
+        virtual float evaluateError(const Vector4 colors[16], const float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, const void * block) const;
+    };
+
+    // BC3n
+    struct CompressorDXT5n : public FloatColorCompressor
+    {
+        virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual nvtt::RangeTask * bandTask(nvtt::AlphaMode alphaMode) const;
+        virtual uint blockSize(const nvtt::CompressionOptions::Private &) const { return 16; }
     };
 
     // BC3
     struct CompressorBC3_RGBM : public FloatColorCompressor
     {
         virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual nvtt::RangeTask * bandTask(nvtt::AlphaMode alphaMode) const;
         virtual uint blockSize(const nvtt::CompressionOptions::Private &) const { return 16; }
+
+        virtual bool compressesBands(const nvtt::CompressionOptions::Private & compressionOptions) const;
+        virtual void compressBlocks(uint count, const float * colors, const float * weights, uint stride, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
     };
 
 
@@ -44,31 +136,40 @@ namespace nv
     struct CompressorETC1 : public FloatColorCompressor
     {
         virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual nvtt::RangeTask * bandTask(nvtt::AlphaMode alphaMode) const;
+        virtual bool compressSingleColor(const Vector4 & color, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
         virtual uint blockSize(const nvtt::CompressionOptions::Private &) const { return 8; }
     };
     struct CompressorETC2_R : public FloatColorCompressor
     {
         virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual nvtt::RangeTask * bandTask(nvtt::AlphaMode alphaMode) const;
         virtual uint blockSize(const nvtt::CompressionOptions::Private & ) const { return 8; }
     };
     struct CompressorETC2_RG : public FloatColorCompressor
     {
         virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual nvtt::RangeTask * bandTask(nvtt::AlphaMode alphaMode) const;
         virtual uint blockSize(const nvtt::CompressionOptions::Private & ) const { return 16; }
     };
     struct CompressorETC2_RGB : public FloatColorCompressor
     {
         virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual nvtt::RangeTask * bandTask(nvtt::AlphaMode alphaMode) const;
+        virtual bool compressSingleColor(const Vector4 & color, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
         virtual uint blockSize(const nvtt::CompressionOptions::Private & ) const { return 8; }
     };
     struct CompressorETC2_RGBA : public FloatColorCompressor
     {
         virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual nvtt::RangeTask * bandTask(nvtt::AlphaMode alphaMode) const;
+        virtual bool compressSingleColor(const Vector4 & color, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
         virtual uint blockSize(const nvtt::CompressionOptions::Private & ) const { return 16; }
     };
     struct CompressorETC2_RGBM : public FloatColorCompressor
     {
         virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual nvtt::RangeTask * bandTask(nvtt::AlphaMode alphaMode) const;
         virtual uint blockSize(const nvtt::CompressionOptions::Private &) const { return 16; }
     };
     
@@ -147,6 +248,31 @@ namespace nv
     };
 #endif
 
+#if defined(HAVE_CMP_CORE)
+    // BC6 and BC7 using AMD's Compressonator kernels. The options are created once per surface and shared by all blocks.
+    struct CmpCompressorBC6 : public FloatColorCompressor
+    {
+        CmpCompressorBC6() : options(NULL) {}
+
+        virtual void compress(nvtt::AlphaMode alphaMode, uint w, uint h, uint d, const float * rgba, nvtt::TaskDispatcher * dispatcher, const nvtt::CompressionOptions::Private & compressionOptions, const nvtt::OutputOptions::Private & outputOptions);
+        virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual uint blockSize(const nvtt::CompressionOptions::Private &) const { return 16; }
+
+        void * options;
+    };
+
+    struct CmpCompressorBC7 : public FloatColorCompressor
+    {
+        CmpCompressorBC7() : options(NULL) {}
+
+        virtual void compress(nvtt::AlphaMode alphaMode, uint w, uint h, uint d, const float * rgba, nvtt::TaskDispatcher * dispatcher, const nvtt::CompressionOptions::Private & compressionOptions, const nvtt::OutputOptions::Private & outputOptions);
+        virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual uint blockSize(const nvtt::CompressionOptions::Private &) const { return 16; }
+
+        void * options;
+    };
+#endif
+
 #if defined(HAVE_PVRTEXTOOL)
     struct CompressorPVR : public CompressorInterface
     {
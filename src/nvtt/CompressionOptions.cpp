@@ -51,6 +51,10 @@ void CompressionOptions::reset()
     m.quality = Quality_Normal;
     m.colorWeight.set(1.0f, 1.0f, 1.0f, 1.0f);
     m.rgbmThreshold = 0.15f;
+    m.rdoLambda = 0.0f;
+    m.fastQuality = Quality_Fastest;
+    m.adaptiveErrorThreshold = -1.0f;
+    m.adaptiveVarianceThreshold = 0.0f;
     
     m.bitcount = 32;
     m.bmask = 0x000000FF;
@@ -108,6 +112,20 @@ void CompressionOptions::setRGBMThreshold(float min_m)
     m.rgbmThreshold = min_m;
 }
 
+/// Set the lambda of the rate-distortion optimization, 0 disables it.
+void CompressionOptions::setRateDistortionLambda(float lambda)
+{
+    m.rdoLambda = max(lambda, 0.0f);
+}
+
+/// Set the fast quality and the error thresholds of the adaptive quality, a negative error threshold disables it.
+void CompressionOptions::setAdaptiveQuality(Quality fastQuality, float errorThreshold, float varianceThreshold/*=0.0f*/)
+{
+    m.fastQuality = fastQuality;
+    m.adaptiveErrorThreshold = errorThreshold;
+    m.adaptiveVarianceThreshold = max(varianceThreshold, 0.0f);
+}
+
 
 /// Set color mask to describe the RGB/RGBA format.
 void CompressionOptions::setPixelFormat(uint bitCount, uint rmask, uint gmask, uint bmask, uint amask)
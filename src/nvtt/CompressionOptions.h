@@ -40,6 +40,17 @@ namespace nvtt
 
         nv::Vector4 colorWeight;
         float rgbmThreshold;
+        float rdoLambda;
+
+        // Adaptive quality, disabled if the error threshold is negative.
+        Quality fastQuality;
+        float adaptiveErrorThreshold;
+        float adaptiveVarianceThreshold;
+
+        bool isAdaptiveQuality() const
+        {
+            return adaptiveErrorThreshold >= 0.0f && fastQuality < quality;
+        }
         
         // Pixel format description.
         uint bitcount;
@@ -57,6 +68,12 @@ namespace nvtt
 
         nv::String externalCompressor;
 
+        // Hash of the external compressor name, 0 if none is set.
+        uint externalCompressorHash() const
+        {
+            return externalCompressor.isNull() ? 0 : externalCompressor.hash();
+        }
+
         // Quantization.
         bool enableColorDithering;
         bool enableAlphaDithering;
@@ -30,11 +30,15 @@
 
 namespace nv
 {
+    class BlockCache;
 
     struct CompressorInterface
     {
         virtual ~CompressorInterface() {}
         virtual void compress(nvtt::AlphaMode alphaMode, uint w, uint h, uint d, const float * rgba, nvtt::TaskDispatcher * dispatcher, const nvtt::CompressionOptions::Private & compressionOptions, const nvtt::OutputOptions::Private & outputOptions) = 0;
+
+        // Compressors that encode the blocks independently reuse the blocks of identical input blocks stored in the cache.
+        virtual void setBlockCache(BlockCache * cache) {}
     };
 
 } // nv namespace
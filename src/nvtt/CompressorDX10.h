@@ -36,12 +36,14 @@ namespace nv
 	{
 		virtual void compressBlock(ColorBlock & rgba, nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
 		virtual uint blockSize() const { return 8; }
+		virtual uint grainSize() const { return 64; }
 	};
 
 	struct FastCompressorBC5 : public ColorBlockCompressor
 	{
 		virtual void compressBlock(ColorBlock & rgba, nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
 		virtual uint blockSize() const { return 16; }
+		virtual uint grainSize() const { return 64; }
 	};
 
 
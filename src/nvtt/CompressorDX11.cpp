@@ -26,7 +26,9 @@
 
 #include "nvtt.h"
 #include "CompressionOptions.h"
+#include "CompressorRDO.h"
 #include "nvimage/ColorBlock.h"
+#include "nvimage/BlockDXT.h"
 #include "nvmath/Half.h"
 #include "nvmath/Vector.inl"
 
@@ -39,20 +41,43 @@ using namespace nv;
 using namespace nvtt;
 
 
-void CompressorBC6::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
+static ZOH::Format zohFormat(const CompressionOptions::Private & compressionOptions)
 {
-    // !!!UNDONE: support channel weights
-    // !!!UNDONE: set flags once, not per block (this is especially sketchy since block compression is multithreaded...)
-
     if (compressionOptions.pixelType == PixelType_UnsignedFloat ||
         compressionOptions.pixelType == PixelType_UnsignedNorm ||
         compressionOptions.pixelType == PixelType_UnsignedInt)
     {
-        ZOH::Utils::FORMAT = ZOH::UNSIGNED_F16;
+        return ZOH::UNSIGNED_F16;
+    }
+    return ZOH::SIGNED_F16;
+}
+
+void CompressorBC6::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
+{
+    // !!!UNDONE: support channel weights
+
+    // The options are passed down with the tile, so that blocks of different formats can be compressed concurrently.
+    ZOH::Options zohOptions;
+    zohOptions.format = zohFormat(compressionOptions);
+
+    // The quality level sets how many two-region shapes of the rough pass are refined. Refining the one-region modes
+    // is the most expensive step, so the fastest setting skips them.
+    if (compressionOptions.quality == Quality_Fastest)
+    {
+        zohOptions.one_region = false;
+        zohOptions.refine_count = 1;
+    }
+    else if (compressionOptions.quality == Quality_Normal)
+    {
+        zohOptions.refine_count = 1;
+    }
+    else if (compressionOptions.quality == Quality_Production)
+    {
+        zohOptions.refine_count = 4;
     }
-    else
+    else // Quality_Highest
     {
-        ZOH::Utils::FORMAT = ZOH::SIGNED_F16;
+        zohOptions.refine_count = 32;
     }
 
     // Convert NVTT's tile struct to ZOH's, and convert float to half.
@@ -67,26 +92,63 @@ void CompressorBC6::compressBlock(Vector4 colors[16], float weights[16], const C
             uint16 rHalf = to_half(color.x);
             uint16 gHalf = to_half(color.y);
             uint16 bHalf = to_half(color.z);
-            zohTile.data[y][x].x = ZOH::Tile::half2float(rHalf);
-            zohTile.data[y][x].y = ZOH::Tile::half2float(gHalf);
-            zohTile.data[y][x].z = ZOH::Tile::half2float(bHalf);
+            zohTile.data[y][x].x = ZOH::Tile::half2float(rHalf, zohOptions.format);
+            zohTile.data[y][x].y = ZOH::Tile::half2float(gHalf, zohOptions.format);
+            zohTile.data[y][x].z = ZOH::Tile::half2float(bHalf, zohOptions.format);
             zohTile.importance_map[y][x] = weights[4*y+x];
         }
     }
 
-    ZOH::compress(zohTile, (char *)output);
+    ZOH::compress(zohTile, zohOptions, (char *)output);
+}
+
+bool CompressorBC6::compressSingleColor(const Vector4 & color, const CompressionOptions::Private & compressionOptions, void * output)
+{
+    ZOH::Options zohOptions;
+    zohOptions.format = zohFormat(compressionOptions);
+
+    // Same conversion as the tiles of compressBlock.
+    Vector3 zohColor;
+    zohColor.x = ZOH::Tile::half2float(to_half(color.x), zohOptions.format);
+    zohColor.y = ZOH::Tile::half2float(to_half(color.y), zohOptions.format);
+    zohColor.z = ZOH::Tile::half2float(to_half(color.z), zohOptions.format);
+
+    ZOH::compress_single_color(zohColor, zohOptions, (char *)output);
+    return true;
 }
 
 void CompressorBC7::compressBlock(Vector4 colors[16], float weights[16], const CompressionOptions::Private & compressionOptions, void * output)
 {
     // !!!UNDONE: support channel weights
-    // !!!UNDONE: set flags once, not per block (this is especially sketchy since block compression is multithreaded...)
 
-    AVPCL::mode_rgb = false;
-    AVPCL::flag_premult = false; //(alphaMode == AlphaMode_Premultiplied);
-    AVPCL::flag_nonuniform = false;
-    AVPCL::flag_nonuniform_ati = false;
-    
+    AVPCL::Options avpclOptions;
+    avpclOptions.mode_rgb = false;
+    avpclOptions.flag_premult = false; //(alphaMode == AlphaMode_Premultiplied);
+    avpclOptions.flag_nonuniform = false;
+    avpclOptions.flag_nonuniform_ati = false;
+
+    // Opaque tiles are detected by AVPCL::compress. The quality level sets how many shapes of the partitioned modes are
+    // refined and which modes are skipped.
+    if (compressionOptions.quality == Quality_Fastest)
+    {
+        avpclOptions.shape_divisor = 64;
+        avpclOptions.flat_range = 8.0f;
+        avpclOptions.opaque_rotations = false;
+    }
+    else if (compressionOptions.quality == Quality_Normal)
+    {
+        avpclOptions.shape_divisor = 16;
+        avpclOptions.opaque_rotations = false;
+    }
+    else if (compressionOptions.quality == Quality_Production)
+    {
+        avpclOptions.shape_divisor = 4;
+    }
+    else // Quality_Highest
+    {
+        avpclOptions.shape_divisor = 2;
+    }
+
     // Convert NVTT's tile struct to AVPCL's.
     AVPCL::Tile avpclTile(4, 4);
     memset(avpclTile.data, 0, sizeof(avpclTile.data));
@@ -98,5 +160,23 @@ void CompressorBC7::compressBlock(Vector4 colors[16], float weights[16], const C
         }
     }
 
-    AVPCL::compress(avpclTile, (char *)output);
+    AVPCL::compress(avpclTile, avpclOptions, (char *)output);
+}
+
+bool CompressorBC7::compressSingleColor(const Vector4 & color, const CompressionOptions::Private & compressionOptions, void * output)
+{
+    AVPCL::compress_single_color(color * 255.0f, (char *)output);
+    return true;
+}
+
+void CompressorBC7::optimizeRate(const Vector4 colors[16], const float weights[16], const void * previous, uint previousCount, const CompressionOptions::Private & compressionOptions, void * output)
+{
+    rdo_bc7(colors, weights, compressionOptions.colorWeight, compressionOptions.rdoLambda, (const BlockBC7 *)previous, previousCount, (BlockBC7 *)output);
+}
+
+float CompressorBC7::evaluateError(const Vector4 colors[16], const float weights[16], const CompressionOptions::Private & compressionOptions, const void * block) const
+{
+    ColorBlock decoded;
+    ((const BlockBC7 *)block)->decodeBlock(&decoded);
+    return evaluateBlockError(colors, weights, compressionOptions.colorWeight, decoded);
 }
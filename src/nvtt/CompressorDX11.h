@@ -31,13 +31,20 @@ namespace nv
     struct CompressorBC6 : public FloatColorCompressor
     {
         virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual bool compressSingleColor(const Vector4 & color, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
         virtual uint blockSize(const nvtt::CompressionOptions::Private & ) const { return 16; }
+        virtual uint grainSize(const nvtt::CompressionOptions::Private & ) const { return 1; }
     };
 
     struct CompressorBC7 : public FloatColorCompressor
     {
         virtual void compressBlock(Vector4 colors[16], float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual bool compressSingleColor(const Vector4 & color, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual void optimizeRate(const Vector4 colors[16], const float weights[16], const void * previous, uint previousCount, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
+        virtual bool evaluatesError() const { return true; }
+        virtual float evaluateError(const Vector4 colors[16], const float weights[16], const nvtt::CompressionOptions::Private & compressionOptions, const void * block) const;
         virtual uint blockSize(const nvtt::CompressionOptions::Private & ) const { return 16; }
+        virtual uint grainSize(const nvtt::CompressionOptions::Private & ) const { return 1; }
     };
 	
 } // nv namespace
@@ -116,110 +116,6 @@ void CompressorDXT1_Luma::compressBlock(ColorBlock & rgba, nvtt::AlphaMode alpha
     OptimalCompress::compressDXT1_Luma(rgba, block);
 }
 
-void CompressorDXT3::compressBlock(ColorBlock & rgba, nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions, void * output)
-{
-    BlockDXT3 * block = new(output) BlockDXT3;
-
-    // Compress explicit alpha.
-    OptimalCompress::compressDXT3A(rgba, &block->alpha);
-
-    // Compress color.
-    if (rgba.isSingleColor())
-    {
-        OptimalCompress::compressDXT1(rgba.color(0), &block->color);
-    }
-    else
-    {
-        nvsquish::WeightedClusterFit fit;
-        fit.SetMetric(compressionOptions.colorWeight.x, compressionOptions.colorWeight.y, compressionOptions.colorWeight.z);
-
-        int flags = 0;
-        if (alphaMode == nvtt::AlphaMode_Transparency) flags |= nvsquish::kWeightColourByAlpha;
-
-        nvsquish::ColourSet colours((uint8 *)rgba.colors(), flags);
-        fit.SetColourSet(&colours, 0);
-        fit.Compress(&block->color);
-    }
-}
-
-void CompressorDXT5::compressBlock(ColorBlock & rgba, nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions, void * output)
-{
-    BlockDXT5 * block = new(output) BlockDXT5;
-
-    // Compress alpha.
-    if (compressionOptions.quality == Quality_Highest)
-    {
-        OptimalCompress::compressDXT5A(rgba, &block->alpha);
-    }
-    else
-    {
-        QuickCompress::compressDXT5A(rgba, &block->alpha);
-    }
-
-    // Compress color.
-    if (rgba.isSingleColor())
-    {
-        OptimalCompress::compressDXT1(rgba.color(0), &block->color);
-    }
-    else
-    {
-        nvsquish::WeightedClusterFit fit;
-        fit.SetMetric(compressionOptions.colorWeight.x, compressionOptions.colorWeight.y, compressionOptions.colorWeight.z);
-
-        int flags = 0;
-        if (alphaMode == nvtt::AlphaMode_Transparency) flags |= nvsquish::kWeightColourByAlpha;
-
-        nvsquish::ColourSet colours((uint8 *)rgba.colors(), flags);
-        fit.SetColourSet(&colours, 0);
-        fit.Compress(&block->color);
-    }
-}
-
-
-void CompressorDXT5n::compressBlock(ColorBlock & rgba, nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions, void * output)
-{
-    BlockDXT5 * block = new(output) BlockDXT5;
-
-    // Compress Y.
-    if (compressionOptions.quality == Quality_Highest)
-    {
-        OptimalCompress::compressDXT1G(rgba, &block->color);
-    }
-    else
-    {
-        if (rgba.isSingleColor(Color32(0, 0xFF, 0, 0))) // Mask all but green channel.
-        {
-                OptimalCompress::compressDXT1G(rgba.color(0).g, &block->color);
-        }
-        else
-        {
-            ColorBlock tile = rgba;
-            tile.swizzle(4, 1, 5, 3); // leave alpha in alpha channel.
-
-            nvsquish::WeightedClusterFit fit;
-            fit.SetMetric(0, 1, 0);
-
-            int flags = 0;
-            if (alphaMode == nvtt::AlphaMode_Transparency) flags |= nvsquish::kWeightColourByAlpha;
-
-            nvsquish::ColourSet colours((uint8 *)tile.colors(), flags);
-            fit.SetColourSet(&colours, 0);
-            fit.Compress(&block->color);
-        }
-    }
-
-    rgba.swizzle(4, 1, 5, 0); // 1, G, 0, R
-
-    // Compress X.
-    if (compressionOptions.quality == Quality_Highest)
-    {
-        OptimalCompress::compressDXT5A(rgba, &block->alpha);
-    }
-    else
-    {
-        QuickCompress::compressDXT5A(rgba, &block->alpha);
-    }
-}
 
 
 
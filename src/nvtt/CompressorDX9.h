@@ -36,24 +36,28 @@ namespace nv
     {
         virtual void compressBlock(ColorBlock & rgba, nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
         virtual uint blockSize() const { return 8; }
+        virtual uint grainSize() const { return 64; }
     };
 
     struct FastCompressorDXT3 : public ColorBlockCompressor
     {
         virtual void compressBlock(ColorBlock & rgba, nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
         virtual uint blockSize() const { return 16; }
+        virtual uint grainSize() const { return 64; }
     };
 
     struct FastCompressorDXT5 : public ColorBlockCompressor
     {
         virtual void compressBlock(ColorBlock & rgba, nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
         virtual uint blockSize() const { return 16; }
+        virtual uint grainSize() const { return 64; }
     };
 
     struct FastCompressorDXT5n : public ColorBlockCompressor
     {
         virtual void compressBlock(ColorBlock & rgba, nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
         virtual uint blockSize() const { return 16; }
+        virtual uint grainSize() const { return 64; }
     };
 
 
@@ -71,23 +75,6 @@ namespace nv
         virtual uint blockSize() const { return 8; }
     };
 
-    struct CompressorDXT3 : public ColorBlockCompressor
-    {
-        virtual void compressBlock(ColorBlock & rgba, nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
-        virtual uint blockSize() const { return 16; }
-    };
-
-    struct CompressorDXT5 : public ColorBlockCompressor
-    {
-        virtual void compressBlock(ColorBlock & rgba, nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
-        virtual uint blockSize() const { return 16; }
-    };
-
-    struct CompressorDXT5n : public ColorBlockCompressor
-    {
-        virtual void compressBlock(ColorBlock & rgba, nvtt::AlphaMode alphaMode, const nvtt::CompressionOptions::Private & compressionOptions, void * output);
-        virtual uint blockSize() const { return 16; }
-    };
 
 
 
@@ -14,6 +14,9 @@
 #include "nvmath/ftoi.h"
 
 #include "nvthread/Atomic.h"
+
+#include "nvcore/ScratchArena.h"
+
 #include <stdio.h>
 
 using namespace nv;
@@ -51,17 +54,8 @@ static void convert_to_rgbm(const Vector4 input_colors[16], const float input_we
 
 //static uint atomic_counter = 0;
 
-float nv::compress_dxt5_rgbm(const Vector4 input_colors[16], const float input_weights[16], float min_m, BlockDXT5 * output) {
-
-    // Convert to RGBM.
-    Vector4 input_colors_rgbm[16]; // @@ Write over input_colors?
-    float rgb_weights[16];
-    convert_to_rgbm(input_colors, input_weights, min_m, input_colors_rgbm, rgb_weights);
-
-    float color_weights[3] = { 1.0f,1.0f,1.0f };
-
-    // Compress RGB.
-    icbc::compress_dxt1(icbc::Quality_Default, (float *)input_colors_rgbm, rgb_weights, color_weights, /*three_color_mode=*/false, /*hq=*/false, &output->color);
+// Compresses the M values of a block whose RGB part has already been compressed.
+static void compress_m(const Vector4 input_colors[16], const float input_weights[16], float min_m, BlockDXT5 * output) {
 
     // Decompress RGB/M block.
     nv::ColorBlock RGB;
@@ -143,10 +137,79 @@ float nv::compress_dxt5_rgbm(const Vector4 input_colors[16], const float input_w
         rgb_weights[i] = input_weights[i] * m;
     }
 #endif
+}
+
+float nv::compress_dxt5_rgbm(const Vector4 input_colors[16], const float input_weights[16], float min_m, BlockDXT5 * output) {
+
+    // Convert to RGBM.
+    Vector4 input_colors_rgbm[16]; // @@ Write over input_colors?
+    float rgb_weights[16];
+    convert_to_rgbm(input_colors, input_weights, min_m, input_colors_rgbm, rgb_weights);
+
+    float color_weights[3] = { 1.0f,1.0f,1.0f };
+
+    // Compress RGB.
+    icbc::compress_dxt1(icbc::Quality_Default, (float *)input_colors_rgbm, rgb_weights, color_weights, /*three_color_mode=*/false, /*hq=*/false, &output->color);
+
+    compress_m(input_colors, input_weights, min_m, output);
 
     return 0; // @@ 
 }
 
+void nv::compress_dxt5_rgbm(uint count, const float * colors, const float * weights, uint stride, float min_m, icbc::Quality level, BlockDXT5 * output) {
+
+    ScratchScope scratch;
+    float * rgbm_colors = scratch.allocate<float>(3 * 16 * stride);
+    float * rgb_weights = scratch.allocate<float>(16 * stride);
+    float * weight_sums = scratch.allocate<float>(count);
+    BlockDXT1 * color_blocks = scratch.allocate<BlockDXT1>(count);
+
+    // Convert to RGBM, same as convert_to_rgbm.
+    for (uint b = 0; b < count; b++) weight_sums[b] = 0;
+
+    for (uint i = 0; i < 16; i++) {
+        for (uint b = 0; b < count; b++) {
+            float R = saturate(colors[(0 * 16 + i) * stride + b]);
+            float G = saturate(colors[(1 * 16 + i) * stride + b]);
+            float B = saturate(colors[(2 * 16 + i) * stride + b]);
+
+            float M = max(max(R, G), max(B, min_m));
+            rgbm_colors[(0 * 16 + i) * stride + b] = R / M;
+            rgbm_colors[(1 * 16 + i) * stride + b] = G / M;
+            rgbm_colors[(2 * 16 + i) * stride + b] = B / M;
+
+            rgb_weights[i * stride + b] = weights[i * stride + b] * M;
+            weight_sums[b] += weights[i * stride + b];
+        }
+    }
+
+    for (uint b = 0; b < count; b++) {
+        if (weight_sums[b] == 0) {
+            for (uint i = 0; i < 16; i++) rgb_weights[i * stride + b] = 1;
+        }
+    }
+
+    float color_weights[3] = { 1.0f,1.0f,1.0f };
+
+    // Compress RGB.
+    icbc::compress_dxt1_batch(level, int(count), rgbm_colors, rgb_weights, int(stride), color_weights, /*three_color_mode=*/false, /*three_color_black=*/false, color_blocks);
+
+    for (uint b = 0; b < count; b++) {
+        Vector4 input_colors[16];
+        float input_weights[16];
+        for (uint i = 0; i < 16; i++) {
+            input_colors[i].x = colors[(0 * 16 + i) * stride + b];
+            input_colors[i].y = colors[(1 * 16 + i) * stride + b];
+            input_colors[i].z = colors[(2 * 16 + i) * stride + b];
+            input_colors[i].w = colors[(3 * 16 + i) * stride + b];
+            input_weights[i] = weights[i * stride + b];
+        }
+
+        output[b].color = color_blocks[b];
+        compress_m(input_colors, input_weights, min_m, output + b);
+    }
+}
+
 
 float nv::compress_etc2_rgbm(Vector4 input_colors[16], float input_weights[16], float min_m, void * output) {
     
@@ -159,7 +222,7 @@ float nv::compress_etc2_rgbm(Vector4 input_colors[16], float input_weights[16],
     void * eac_output = output;
     
     // Compress RGB.
-    compress_etc2(rgbm_colors, rgb_weights, Vector3(1), etc_output);
+    compress_etc2(rgbm_colors, rgb_weights, Vector3(1), /*quality=*/1, etc_output);
     
     // Decompress RGB/M block.
     decompress_etc(etc_output, rgbm_colors);
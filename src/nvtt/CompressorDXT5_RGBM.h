@@ -1,9 +1,16 @@
 
+#include "nvcore/nvcore.h"
+#include "icbc.h"
+
 namespace nv {
 
     struct BlockDXT5;
     class Vector4;
 
     float compress_dxt5_rgbm(const Vector4 input_colors[16], const float input_weights[16], float min_m, BlockDXT5 * output);
+
+    // Compresses a band of blocks in structure-of-arrays layout, see FloatColorCompressor::compressBlocks. The RGB part of
+    // all the blocks is compressed at once with the given BC1 quality level.
+    void compress_dxt5_rgbm(uint count, const float * colors, const float * weights, uint stride, float min_m, icbc::Quality level, BlockDXT5 * output);
     float compress_etc2_rgbm(Vector4 input_colors[16], float input_weights[16], float min_m, void * output);
 }
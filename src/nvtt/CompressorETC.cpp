@@ -6,6 +6,10 @@
 #include "nvmath/Color.inl"
 #include "nvcore/Utils.h"    // clamp
 
+#if NV_USE_SSE >= 2
+#include <emmintrin.h>
+#endif
+
 //#define HAVE_RGETC 0
 //#define HAVE_ETCPACK 0 // Only enable in OSX for debugging.
 
@@ -167,15 +171,12 @@ static const uint8 etc_selector_scramble[] = { 3, 2, 0, 1 };
 static const uint8 etc_selector_unscramble[] = { 2, 3, 1, 0 };
 
 
-static float midpoints4[16];
-NV_AT_STARTUP(
-    for (int i = 0; i < 15; i++) {
-        float f0 = float(((i+0) << 4) | ((i+0) >> 4)) / 255.0f;
-        float f1 = float(((i+1) << 4) | ((i+1) >> 4)) / 255.0f;
-        midpoints4[i] = (f0 + f1) * 0.5f;
-    }
-    midpoints4[15] = 1.0f;
-);
+// Rounding thresholds of the 4 bit values, (16 * i + 8) / 255, half way between 16 * i and 16 * (i + 1).
+// The last one is 1.
+static const float midpoints4[16] = {
+    0.0313725509f, 0.0941176564f, 0.156862751f, 0.21960786f, 0.282352954f, 0.345098048f, 0.407843143f, 0.470588267f,
+    0.533333361f, 0.596078455f, 0.65882355f, 0.721568644f, 0.784313738f, 0.847058833f, 0.909803927f, 1.0f
+};
 
 static const float midpoints5[32] = {
     0.015686f, 0.047059f, 0.078431f, 0.111765f, 0.145098f, 0.176471f, 0.207843f, 0.241176f, 0.274510f, 0.305882f, 0.337255f, 0.370588f, 0.403922f, 0.435294f, 0.466667f, 0.5f,
@@ -185,6 +186,92 @@ static const float midpoints5[32] = {
 //static const float midpoints6[64];
 //static const float midpoints7[128];
 
+// Base color components of single color blocks, see compress_etc1_single_color. For the 444 and 555 base colors of
+// individual and differential blocks, each intensity table and each selector, the base value whose expansion plus the
+// intensity modifier is closest to each 8 bit value.
+static uint8 etc_single_color_base[2][8][4][256];
+
+static int etc_single_color_value(int diff, int table, int selector, int base) {
+    int value = diff ? (base << 3) | (base >> 2) : (base << 4) | base;
+    return clamp(value + etc_intensity_modifiers[table][selector], 0, 255);
+}
+
+static void init_etc_single_color_table() {
+    for (int diff = 0; diff < 2; diff++) {
+        const int base_count = diff ? 32 : 16;
+        for (int t = 0; t < 8; t++) {
+            for (int s = 0; s < 4; s++) {
+                for (int v = 0; v < 256; v++) {
+                    int best_error = 256;
+                    for (int base = 0; base < base_count; base++) {
+                        int error = abs(etc_single_color_value(diff, t, s, base) - v);
+                        if (error < best_error) {
+                            best_error = error;
+                            etc_single_color_base[diff][t][s][v] = U8(base);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Planar encoding of a single color channel, see compress_etc2_single_color. The origin, horizontal and vertical values
+// are not necessarily equal, the gradients dither the block to approximate values between the quantized ones.
+struct ETC_PlanarChannel {
+    uint8 o, h, v;
+    uint16 error;   // Sum of the squared errors of the 16 pixels.
+};
+
+// For 6 and 7 bit channels, the planar encoding of each 8 bit value with the lowest error.
+static ETC_PlanarChannel etc_planar_single_color[2][256];
+
+static void init_etc_planar_single_color_table() {
+    for (int p = 0; p < 2; p++) {
+        const int bits = 6 + p;
+        const int max_q = (1 << bits) - 1;
+
+        for (int value = 0; value < 256; value++) {
+            const int center = (value * max_q + 127) / 255;
+            ETC_PlanarChannel & best = etc_planar_single_color[p][value];
+            int best_error = 1 << 30;
+
+            // Search a small neighborhood of the nearest quantized value.
+            for (int o = max(center - 3, 0); o <= min(center + 3, max_q); o++) {
+                for (int h = max(center - 3, 0); h <= min(center + 3, max_q); h++) {
+                    for (int v = max(center - 3, 0); v <= min(center + 3, max_q); v++) {
+                        const int eo = (o << (8 - bits)) | (o >> (2 * bits - 8));
+                        const int eh = (h << (8 - bits)) | (h >> (2 * bits - 8));
+                        const int ev = (v << (8 - bits)) | (v >> (2 * bits - 8));
+
+                        int error = 0;
+                        for (int y = 0; y < 4; y++) {
+                            for (int x = 0; x < 4; x++) {
+                                int c = clamp((4 * eo + x * (eh - eo) + y * (ev - eo) + 2) >> 2, 0, 255);
+                                error += (c - value) * (c - value);
+                            }
+                        }
+
+                        if (error < best_error) {
+                            best_error = error;
+                            best.o = U8(o);
+                            best.h = U8(h);
+                            best.v = U8(v);
+                            best.error = U16(error);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// The single color tables are built the first time a single color block is compressed, not at startup.
+static void init_etc_single_color_tables() {
+    static const bool initialized = (init_etc_single_color_table(), init_etc_planar_single_color_table(), true);
+    (void)initialized;
+}
+
 
 
 // ETC2 Modes:
@@ -238,6 +325,11 @@ struct ETC_Solution {
 struct ETC_Options {
     //bool fast_flip_mode_selection = false;
     bool use_rg_etc = true;
+    int rg_etc_quality = 1;             // 0 = low, 1 = medium, 2 = high
+    bool evaluate_tables = false;       // range fit evaluates all intensity tables for its base colors, instead of picking one from the luminance range
+    bool use_table_search = true;       // search all intensity tables for the base colors of both modes and flips, instead of the range fit
+    int color_search_radius = 0;        // [0-1] quantization steps the base colors are moved around the average
+    bool color_search_channels = false; // move the channels independently, instead of only along the luminance axis
     bool enable_etc2 = true;
     bool use_planar = true;
     bool use_t_mode = true;
@@ -1180,9 +1272,41 @@ static void decode_etc2_h(const ETC_Data & data, Vector4 output_colors[16]) {
     }
 }
 
+#if NV_USE_SSE >= 2
+// Decodes a channel of the 4 pixels in row y of a planar block, given the bit expanded origin, horizontal and vertical
+// values of the channel.
+static NV_FORCEINLINE __m128 decode_etc2_planar_channel(int o, int h, int v, int y) {
+    const int dh = h - o;
+    const __m128i x_dh = _mm_setr_epi32(0, dh, 2 * dh, 3 * dh);
+    const __m128i c = _mm_srai_epi32(_mm_add_epi32(x_dh, _mm_set1_epi32(4 * o + y * (v - o) + 2)), 2);
+    const __m128 f = _mm_div_ps(_mm_cvtepi32_ps(c), _mm_set1_ps(255.0f));
+    return _mm_min_ps(_mm_max_ps(f, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+// Decodes the 4 pixels in row y of a planar block, with the channels in 3 vectors.
+static NV_FORCEINLINE void decode_etc2_planar_row(const ETC_Data & data, int y, __m128 * r, __m128 * g, __m128 * b) {
+    *r = decode_etc2_planar_channel(bitexpand(data.planar.ro, 6, 8), bitexpand(data.planar.rh, 6, 8), bitexpand(data.planar.rv, 6, 8), y);
+    *g = decode_etc2_planar_channel(bitexpand(data.planar.go, 7, 8), bitexpand(data.planar.gh, 7, 8), bitexpand(data.planar.gv, 7, 8), y);
+    *b = decode_etc2_planar_channel(bitexpand(data.planar.bo, 6, 8), bitexpand(data.planar.bh, 6, 8), bitexpand(data.planar.bv, 6, 8), y);
+}
+#endif
+
 static void decode_etc2_planar(const ETC_Data & data, Vector4 output_colors[16]) {
     assert(data.mode == ETC_Data::Mode_Planar);
 
+#if NV_USE_SSE >= 2
+    // The 4 pixels of a row are decoded in the lanes of a vector.
+    for (int y = 0; y < 4; y++) {
+        __m128 r, g, b;
+        decode_etc2_planar_row(data, y, &r, &g, &b);
+        __m128 a = _mm_set1_ps(1.0f);
+        _MM_TRANSPOSE4_PS(r, g, b, a);
+        _mm_storeu_ps(output_colors[4 * y + 0].component, r);
+        _mm_storeu_ps(output_colors[4 * y + 1].component, g);
+        _mm_storeu_ps(output_colors[4 * y + 2].component, b);
+        _mm_storeu_ps(output_colors[4 * y + 3].component, a);
+    }
+#else
     int ro, go, bo; // origin color
     int rh, gh, bh; // horizontal color
     int rv, gv, bv; // vertical color
@@ -1200,7 +1324,6 @@ static void decode_etc2_planar(const ETC_Data & data, Vector4 output_colors[16])
     gv = bitexpand(data.planar.gv, 7, 8);
     bv = bitexpand(data.planar.bv, 6, 8);
 
-
     for (int y = 0; y < 4; y++) {
         for (int x = 0; x < 4; x++) {
             int r = (4 * ro + x * (rh - ro) + y * (rv - ro) + 2) >> 2;
@@ -1214,6 +1337,7 @@ static void decode_etc2_planar(const ETC_Data & data, Vector4 output_colors[16])
             output_colors[idx].w = 1;
         }
     }
+#endif
 }
 
 static void decode_etc2(const ETC_Data & data, Vector4 colors[16]) {
@@ -1285,15 +1409,66 @@ static float evaluate_mse(const Vector3 & p, const Vector3 & c, const Vector3 &
     return dot(d, d);
 }
 
+#if NV_USE_SSE >= 2
+// Loads the RGB channels of 4 colors to the lanes of 3 vectors.
+static NV_FORCEINLINE void load_rgb4(const Vector4 colors[4], __m128 * r, __m128 * g, __m128 * b) {
+    __m128 c0 = _mm_loadu_ps(colors[0].component);
+    __m128 c1 = _mm_loadu_ps(colors[1].component);
+    __m128 c2 = _mm_loadu_ps(colors[2].component);
+    __m128 c3 = _mm_loadu_ps(colors[3].component);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    *r = c0;
+    *g = c1;
+    *b = c2;
+}
+
+// Same as evaluate_mse for 4 pairs of colors, the operations are done in the same order to get the same result.
+static NV_FORCEINLINE __m128 evaluate_mse4(__m128 pr, __m128 pg, __m128 pb, __m128 cr, __m128 cg, __m128 cb, __m128 wr, __m128 wg, __m128 wb) {
+    const __m128 dr = _mm_mul_ps(_mm_sub_ps(pr, cr), wr);
+    const __m128 dg = _mm_mul_ps(_mm_sub_ps(pg, cg), wg);
+    const __m128 db = _mm_mul_ps(_mm_sub_ps(pb, cb), wb);
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+}
+#endif
+
 static float evaluate_rgb_mse(const Vector4 input_colors[16], const float input_weights[16], const ETC_Options & options, const ETC_Data & data) {
+    float error = 0;
+#if NV_USE_SSE >= 2
+    // The errors of 4 pixels are evaluated at once, and then added in order like in the scalar code. Planar blocks are
+    // decoded directly to the lanes of the vectors.
+    const __m128 wr = _mm_set1_ps(options.color_weights.x);
+    const __m128 wg = _mm_set1_ps(options.color_weights.y);
+    const __m128 wb = _mm_set1_ps(options.color_weights.z);
+
+    Vector4 colors[16];
+    if (data.mode != ETC_Data::Mode_Planar) {
+        decode_etc2(data, colors);
+    }
+
+    float errors[16];
+    for (int i = 0; i < 16; i += 4) {
+        __m128 pr, pg, pb, cr, cg, cb;
+        load_rgb4(input_colors + i, &pr, &pg, &pb);
+        if (data.mode == ETC_Data::Mode_Planar) {
+            decode_etc2_planar_row(data, i / 4, &cr, &cg, &cb);
+        }
+        else {
+            load_rgb4(colors + i, &cr, &cg, &cb);
+        }
+        _mm_storeu_ps(errors + i, evaluate_mse4(pr, pg, pb, cr, cg, cb, wr, wg, wb));
+    }
+    for (int i = 0; i < 16; i++) {
+        error += input_weights[i] * errors[i];
+    }
+#else
     // Decode data and compare?
     Vector4 colors[16];
     decode_etc2(data, colors);
 
-    float error = 0;
     for (int i = 0; i < 16; i++) {
         error += input_weights[i] * evaluate_mse(input_colors[i].xyz(), colors[i].xyz(), options.color_weights);
     }
+#endif
     return error;
 }
 
@@ -1306,6 +1481,45 @@ static int select_table_index(const Vector3 & base_color, const Vector4 input_co
     int xb = partition ? 2 : 0;
     int xe = partition ? 4 : 2;
 
+#if NV_USE_SSE >= 2
+    // The 8 pixels of the sub block and then the 8 tables are evaluated in two vectors.
+    const __m128 third = _mm_set1_ps(1.0f / 3);
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 base_lum = _mm_set1_ps(dot(base_color, Vector3(1.0f/3)));
+
+    __m128 max_delta = _mm_set1_ps(max_lum_delta);
+    for (int y = 0; y < 4; y += 2) {
+        Vector4 colors[4];
+        for (int i = 0; i < 4; i++) {
+            const int x = xb + (i & 1);
+            const int yy = y + (i >> 1);
+            colors[i] = input_colors[flip ? x*4 + yy : yy*4 + x];
+        }
+
+        __m128 r, g, b;
+        load_rgb4(colors, &r, &g, &b);
+        const __m128 lum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, third), _mm_mul_ps(g, third)), _mm_mul_ps(b, third));
+        max_delta = _mm_max_ps(max_delta, _mm_and_ps(_mm_sub_ps(base_lum, lum), abs_mask));
+    }
+    max_delta = _mm_max_ps(max_delta, _mm_shuffle_ps(max_delta, max_delta, _MM_SHUFFLE(2, 3, 0, 1)));
+    max_delta = _mm_max_ps(max_delta, _mm_shuffle_ps(max_delta, max_delta, _MM_SHUFFLE(1, 0, 3, 2)));
+    max_lum_delta = _mm_cvtss_f32(max_delta);
+
+    const __m128 range = _mm_set1_ps(255 * max_lum_delta);
+    const __m128 e0 = _mm_and_ps(_mm_sub_ps(_mm_setr_ps(float(etc_intensity_range[0]), float(etc_intensity_range[1]), float(etc_intensity_range[2]), float(etc_intensity_range[3])), range), abs_mask);
+    const __m128 e1 = _mm_and_ps(_mm_sub_ps(_mm_setr_ps(float(etc_intensity_range[4]), float(etc_intensity_range[5]), float(etc_intensity_range[6]), float(etc_intensity_range[7])), range), abs_mask);
+
+    // Pick the first table with the lowest error.
+    __m128 e = _mm_min_ps(e0, e1);
+    e = _mm_min_ps(e, _mm_shuffle_ps(e, e, _MM_SHUFFLE(2, 3, 0, 1)));
+    e = _mm_min_ps(e, _mm_shuffle_ps(e, e, _MM_SHUFFLE(1, 0, 3, 2)));
+
+    const int mask = _mm_movemask_ps(_mm_cmpeq_ps(e0, e)) | (_mm_movemask_ps(_mm_cmpeq_ps(e1, e)) << 4);
+    int best_range = 0;
+    while ((mask & (1 << best_range)) == 0) best_range++;
+
+    return best_range;
+#else
     for (int y = 0; y < 4; y++) {
         for (int x = xb; x < xe; x++) {
             int idx = flip ? x*4 + y : y*4 + x;
@@ -1326,6 +1540,7 @@ static int select_table_index(const Vector3 & base_color, const Vector4 input_co
     }
 
     return best_range;
+#endif
 }
 
 static float update_selectors(const Vector4 input_colors[16], const float input_weights[16], ETC_Data & data, const ETC_Options & options) {
@@ -1345,10 +1560,38 @@ static float update_selectors(const Vector4 input_colors[16], const float input_
 
     float total_error = 0;
 
+#if NV_USE_SSE >= 2
+    // The 4 colors of the sub block palettes in the lanes of a vector.
+    const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+    __m128 pr[2], pg[2], pb[2];
+    for (int p = 0; p < 2; p++) {
+        pr[p] = _mm_mul_ps(_mm_setr_ps(palette[p][0].r, palette[p][1].r, palette[p][2].r, palette[p][3].r), scale);
+        pg[p] = _mm_mul_ps(_mm_setr_ps(palette[p][0].g, palette[p][1].g, palette[p][2].g, palette[p][3].g), scale);
+        pb[p] = _mm_mul_ps(_mm_setr_ps(palette[p][0].b, palette[p][1].b, palette[p][2].b, palette[p][3].b), scale);
+    }
+
+    const __m128 wr = _mm_set1_ps(options.color_weights.x);
+    const __m128 wg = _mm_set1_ps(options.color_weights.y);
+    const __m128 wb = _mm_set1_ps(options.color_weights.z);
+#endif
+
     for (int y = 0; y < 4; y++) {
         for (int x = 0; x < 4; x++) {
             int i = y*4 + x;
 
+#if NV_USE_SSE >= 2
+            // Evaluate the 4 selectors at once, then pick the first one with the lowest error.
+            const int sub_block = get_partition(data, x, y);
+            const __m128 e4 = evaluate_mse4(pr[sub_block], pg[sub_block], pb[sub_block], _mm_set1_ps(input_colors[i].x), _mm_set1_ps(input_colors[i].y), _mm_set1_ps(input_colors[i].z), wr, wg, wb);
+
+            __m128 e = _mm_min_ps(e4, _mm_shuffle_ps(e4, e4, _MM_SHUFFLE(2, 3, 0, 1)));
+            e = _mm_min_ps(e, _mm_shuffle_ps(e, e, _MM_SHUFFLE(1, 0, 3, 2)));
+            const float best_error = _mm_cvtss_f32(e);
+
+            const int mask = _mm_movemask_ps(_mm_cmpeq_ps(e4, e));
+            int best_p = 0;
+            while ((mask & (1 << best_p)) == 0) best_p++;
+#else
             float best_error = NV_FLOAT_MAX;
             int best_p = 0;
 
@@ -1359,6 +1602,7 @@ static float update_selectors(const Vector4 input_colors[16], const float input_
                     best_p = p;
                 }
             }
+#endif
 
             int s = x*4 + y;
             data.selector[s] = U8(best_p);
@@ -1613,6 +1857,81 @@ static void compress_etc1_test(const Vector4 input_colors[16], const float input
     }
 }*/
 
+// Error of the best intensity table for the sub block colors and the given base color, in 8 bit units. All 8 tables are
+// evaluated, with the 4 selectors of a table in the lanes of a vector when SSE is available.
+static float select_table_index_exhaustive(int r, int g, int b, const Vector3 colors[8], const float weights[8], const Vector3 & color_weights, int * best_table) {
+
+    // evaluate_mse scales the differences by the color weights.
+    const Vector3 w = color_weights * color_weights;
+
+    float best_error = NV_FLOAT_MAX;
+    int best_t = 0;
+
+#if NV_USE_SSE >= 2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(255.0f);
+    const __m128 wr = _mm_set1_ps(w.x);
+    const __m128 wg = _mm_set1_ps(w.y);
+    const __m128 wb = _mm_set1_ps(w.z);
+
+    for (int t = 0; t < 8; t++) {
+        const int * intensity_table = etc_intensity_modifiers[t];
+        const __m128 y = _mm_setr_ps(float(intensity_table[0]), float(intensity_table[1]), float(intensity_table[2]), float(intensity_table[3]));
+
+        // Palette of the 4 selectors.
+        const __m128 pr = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_set1_ps(float(r)), y), zero), one);
+        const __m128 pg = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_set1_ps(float(g)), y), zero), one);
+        const __m128 pb = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_set1_ps(float(b)), y), zero), one);
+
+        float error = 0;
+        for (int i = 0; i < 8 && error < best_error; i++) {
+            const __m128 dr = _mm_sub_ps(pr, _mm_set1_ps(colors[i].x));
+            const __m128 dg = _mm_sub_ps(pg, _mm_set1_ps(colors[i].y));
+            const __m128 db = _mm_sub_ps(pb, _mm_set1_ps(colors[i].z));
+            __m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(dr, dr), wr), _mm_mul_ps(_mm_mul_ps(dg, dg), wg)), _mm_mul_ps(_mm_mul_ps(db, db), wb));
+
+            // Error of the best selector.
+            e = _mm_min_ps(e, _mm_shuffle_ps(e, e, _MM_SHUFFLE(2, 3, 0, 1)));
+            e = _mm_min_ps(e, _mm_shuffle_ps(e, e, _MM_SHUFFLE(1, 0, 3, 2)));
+            error += _mm_cvtss_f32(e) * weights[i];
+        }
+
+        if (error < best_error) {
+            best_error = error;
+            best_t = t;
+        }
+    }
+#else
+    for (int t = 0; t < 8; t++) {
+        const int * intensity_table = etc_intensity_modifiers[t];
+
+        Vector3 palette[4];
+        for (int p = 0; p < 4; p++) {
+            const int y = intensity_table[p];
+            palette[p] = Vector3(float(clamp(r + y, 0, 255)), float(clamp(g + y, 0, 255)), float(clamp(b + y, 0, 255)));
+        }
+
+        float error = 0;
+        for (int i = 0; i < 8 && error < best_error; i++) {
+            float e = NV_FLOAT_MAX;
+            for (int p = 0; p < 4; p++) {
+                Vector3 d = palette[p] - colors[i];
+                e = min(e, dot(d * d, w));
+            }
+            error += e * weights[i];
+        }
+
+        if (error < best_error) {
+            best_error = error;
+            best_t = t;
+        }
+    }
+#endif
+
+    *best_table = best_t;
+    return best_error;
+}
+
 static void compress_etc1_range_fit(const Vector4 input_colors[16], const float input_weights[16], const ETC_Options & options, ETC_Solution * result) {
 
     float best_error = NV_FLOAT_MAX;
@@ -1667,8 +1986,25 @@ static void compress_etc1_range_fit(const Vector4 input_colors[16], const float
     result->data.mode = ETC_Data::Mode_ETC1;
     result->data.etc.flip = best_flip;
     result->data.etc.diff = best_diff;
-    result->data.etc.table0 = select_table_index(best_vc0, input_colors, input_weights, best_flip, /*partition=*/0);
-    result->data.etc.table1 = select_table_index(best_vc1, input_colors, input_weights, best_flip, /*partition=*/1);
+    if (options.evaluate_tables) {
+        // Pick the table with the lowest error for the base color of each sub block.
+        int table[2];
+        for (int p = 0; p < 2; p++) {
+            Vector3 colors[8];
+            float weights[8];
+            partition_input_block(input_colors, input_weights, best_flip, p, colors, weights);
+            for (int i = 0; i < 8; i++) colors[i] *= 255.0f;
+
+            const Vector3 base = (p == 0 ? best_vc0 : best_vc1) * 255.0f;
+            select_table_index_exhaustive(ftoi_round(base.x), ftoi_round(base.y), ftoi_round(base.z), colors, weights, options.color_weights, &table[p]);
+        }
+        result->data.etc.table0 = U8(table[0]);
+        result->data.etc.table1 = U8(table[1]);
+    }
+    else {
+        result->data.etc.table0 = select_table_index(best_vc0, input_colors, input_weights, best_flip, /*partition=*/0);
+        result->data.etc.table1 = select_table_index(best_vc1, input_colors, input_weights, best_flip, /*partition=*/1);
+    }
     result->data.etc.color0 = best_c0;
     result->data.etc.color1 = best_c1;
 
@@ -1677,14 +2013,165 @@ static void compress_etc1_range_fit(const Vector4 input_colors[16], const float
     result->error = evaluate_rgb_mse(input_colors, input_weights, options, result->data);
 }
 
+struct ETC_BaseColor {
+    int r, g, b;        // 4 or 5 bits
+    int table;
+    float error;
+};
+
+// Evaluates the base colors around the quantized average color of a sub block, and returns the number of candidates.
+static int search_base_colors(const Vector3 colors[8], const float weights[8], const Vector3 & average, bool diff, const ETC_Options & options, ETC_BaseColor candidates[27]) {
+
+    int r, g, b;
+    if (diff) {
+        uint32 packed = pack_color_555(average);
+        r = (packed >> 10) & 0x1F;
+        g = (packed >> 5) & 0x1F;
+        b = packed & 0x1F;
+    }
+    else {
+        uint32 packed = pack_color_444(average);
+        r = (packed >> 8) & 0xF;
+        g = (packed >> 4) & 0xF;
+        b = packed & 0xF;
+    }
+
+    const int max_value = diff ? 31 : 15;
+    const int radius = options.color_search_radius;
+
+    int count = 0;
+    for (int dr = -radius; dr <= radius; dr++) {
+        for (int dg = -radius; dg <= radius; dg++) {
+            for (int db = -radius; db <= radius; db++) {
+                // Without channel search the color only moves along the luminance axis.
+                if (!options.color_search_channels && (dg != dr || db != dr)) continue;
+
+                ETC_BaseColor & c = candidates[count];
+                c.r = r + dr;
+                c.g = g + dg;
+                c.b = b + db;
+                if (c.r < 0 || c.r > max_value || c.g < 0 || c.g > max_value || c.b < 0 || c.b > max_value) continue;
+
+                int r8, g8, b8;
+                if (diff) {
+                    r8 = (c.r << 3) | (c.r >> 2);
+                    g8 = (c.g << 3) | (c.g >> 2);
+                    b8 = (c.b << 3) | (c.b >> 2);
+                }
+                else {
+                    r8 = (c.r << 4) | c.r;
+                    g8 = (c.g << 4) | c.g;
+                    b8 = (c.b << 4) | c.b;
+                }
+
+                c.error = select_table_index_exhaustive(r8, g8, b8, colors, weights, options.color_weights, &c.table);
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+// Evaluates the intensity tables and the base colors around the average of each sub block in both the individual and
+// the differential modes, and keeps the combination with the lowest error.
+static void compress_etc1_table_search(const Vector4 input_colors[16], const float input_weights[16], const ETC_Options & options, ETC_Solution * result) {
+
+    nvDebugCheck(options.color_search_radius >= 0 && options.color_search_radius <= 1);
+
+    float best_error = NV_FLOAT_MAX;
+
+    for (int flip = 0; flip <= 1; flip++) {
+        Vector3 colors[2][8];
+        float weights[2][8];
+        Vector3 average[2];
+        for (int p = 0; p < 2; p++) {
+            partition_input_block(input_colors, input_weights, !!flip, p, colors[p], weights[p]);
+            for (int i = 0; i < 8; i++) colors[p][i] *= 255.0f;
+            average[p] = get_partition_color_average(input_colors, input_weights, !!flip, p);
+        }
+
+        ETC_BaseColor candidates[2][27];
+        int count[2];
+
+        // Individual mode, the sub blocks are independent.
+        for (int p = 0; p < 2; p++) {
+            count[p] = search_base_colors(colors[p], weights[p], average[p], /*diff=*/false, options, candidates[p]);
+        }
+
+        int best0 = 0, best1 = 0;
+        for (int i = 1; i < count[0]; i++) if (candidates[0][i].error < candidates[0][best0].error) best0 = i;
+        for (int i = 1; i < count[1]; i++) if (candidates[1][i].error < candidates[1][best1].error) best1 = i;
+
+        float error = candidates[0][best0].error + candidates[1][best1].error;
+        if (error < best_error) {
+            const ETC_BaseColor & c0 = candidates[0][best0];
+            const ETC_BaseColor & c1 = candidates[1][best1];
+
+            best_error = error;
+            result->data.mode = ETC_Data::Mode_ETC1;
+            result->data.etc.flip = !!flip;
+            result->data.etc.diff = false;
+            result->data.etc.color0 = U16((c0.r << 8) | (c0.g << 4) | c0.b);
+            result->data.etc.color1 = U16((c1.r << 8) | (c1.g << 4) | c1.b);
+            result->data.etc.table0 = U8(c0.table);
+            result->data.etc.table1 = U8(c1.table);
+        }
+
+        // Differential mode, the second color has to be within the 3 bit delta of the first.
+        for (int p = 0; p < 2; p++) {
+            count[p] = search_base_colors(colors[p], weights[p], average[p], /*diff=*/true, options, candidates[p]);
+        }
+
+        for (int i = 0; i < count[0]; i++) {
+            const ETC_BaseColor & c0 = candidates[0][i];
+            if (c0.error >= best_error) continue;
+
+            for (int j = 0; j < count[1]; j++) {
+                const ETC_BaseColor & c1 = candidates[1][j];
+
+                const int dr = c1.r - c0.r;
+                const int dg = c1.g - c0.g;
+                const int db = c1.b - c0.b;
+                if (dr < -4 || dr > 3 || dg < -4 || dg > 3 || db < -4 || db > 3) continue;
+
+                error = c0.error + c1.error;
+                if (error < best_error) {
+                    best_error = error;
+                    result->data.mode = ETC_Data::Mode_ETC1;
+                    result->data.etc.flip = !!flip;
+                    result->data.etc.diff = true;
+                    result->data.etc.color0 = U16((c0.r << 10) | (c0.g << 5) | c0.b);
+                    result->data.etc.color1 = U16(((dr & 7) << 6) | ((dg & 7) << 3) | (db & 7));
+                    result->data.etc.table0 = U8(c0.table);
+                    result->data.etc.table1 = U8(c1.table);
+                }
+            }
+        }
+    }
+
+    result->error = update_selectors(input_colors, input_weights, result->data, options);
+
+    result->error = evaluate_rgb_mse(input_colors, input_weights, options, result->data);
+}
+
 #if HAVE_RGETC
 #include "nvimage/ColorBlock.h"
 
+// The tables of rg_etc1 are built the first time a block is compressed with it, not at startup.
+void nv::init_rg_etc() {
+    static const bool initialized = (rg_etc1::pack_etc1_block_init(), true);
+    (void)initialized;
+}
+
 void compress_etc1_rg(const Vector4 input_colors[16], const float input_weights[16], const ETC_Options & options, ETC_Solution * result) {
 
+    init_rg_etc();
+
     rg_etc1::etc1_pack_params pack_params;
-    //pack_params.m_quality = rg_etc1::cLowQuality;
-    pack_params.m_quality = rg_etc1::cMediumQuality;  // @@ Select quality based on compression options. 
+    pack_params.m_quality = rg_etc1::cMediumQuality;
+    if (options.rg_etc_quality == 0) pack_params.m_quality = rg_etc1::cLowQuality;
+    else if (options.rg_etc_quality == 2) pack_params.m_quality = rg_etc1::cHighQuality;
 
     ColorBlock rgba;
     for (uint i = 0; i < 16; i++) {
@@ -2000,7 +2487,12 @@ static float compress_etc(Vector4 input_colors[16], float input_weights[16], con
     assert(options.onebit_alpha == false);
     
     ETC_Solution result;
-    compress_etc1_range_fit(input_colors, input_weights, options, &result);
+    if (options.use_table_search) {
+        compress_etc1_table_search(input_colors, input_weights, options, &result);
+    }
+    else {
+        compress_etc1_range_fit(input_colors, input_weights, options, &result);
+    }
 
     if (options.use_rg_etc) {
 #if HAVE_RGETC
@@ -2077,26 +2569,55 @@ float compress_eac_range_search(Vector4 input_colors[16], float input_weights[16
             const int max_multiplier = clamp(range_multiplier + options.search_radius, 1, 15);
         
             for (int multiplier = min_multiplier; multiplier <= max_multiplier; multiplier++) {
-            
+
+                static const uint ALPHA_SELECTOR_BITS = 3;
+                static const uint ALPHA_SELECTORS = 1 << ALPHA_SELECTOR_BITS;
+
+                // Decode the palette once for all pixels.
+                float palette[ALPHA_SELECTORS];
+                for (uint s = 0; s < ALPHA_SELECTORS; s++) {
+                    if (options.use_11bit_mode) {
+                        palette[s] = get_alpha11(base, t, multiplier, s);
+                    }
+                    else {
+                        palette[s] = get_alpha8(base, t, multiplier, s);
+                    }
+                }
+
+#if NV_USE_SSE >= 2
+                const __m128 palette0 = _mm_loadu_ps(palette + 0);
+                const __m128 palette1 = _mm_loadu_ps(palette + 4);
+#endif
+
                 // find best selector for each pixel
                 float block_error = 0;
                 uint best_selector[16];
                 for (uint i = 0; i < 16; i++) {
-                
-                    float best_error_a = NV_FLOAT_MAX;
-                
-                    static const uint ALPHA_SELECTOR_BITS = 3;
-                    static const uint ALPHA_SELECTORS = 1 << ALPHA_SELECTOR_BITS;
+
+                    float best_error_a;
+
+#if NV_USE_SSE >= 2
+                    // Evaluate the 8 selectors at once, then pick the first one with the lowest error.
+                    const __m128 a = _mm_set1_ps(input_colors[i].component[input_channel]);
+                    const __m128 d0 = _mm_sub_ps(palette0, a);
+                    const __m128 d1 = _mm_sub_ps(palette1, a);
+                    const __m128 e0 = _mm_mul_ps(d0, d0);
+                    const __m128 e1 = _mm_mul_ps(d1, d1);
+
+                    __m128 e = _mm_min_ps(e0, e1);
+                    e = _mm_min_ps(e, _mm_shuffle_ps(e, e, _MM_SHUFFLE(2, 3, 0, 1)));
+                    e = _mm_min_ps(e, _mm_shuffle_ps(e, e, _MM_SHUFFLE(1, 0, 3, 2)));
+                    best_error_a = _mm_cvtss_f32(e);
+
+                    const int mask = _mm_movemask_ps(_mm_cmpeq_ps(e0, e)) | (_mm_movemask_ps(_mm_cmpeq_ps(e1, e)) << 4);
+                    uint s = 0;
+                    while ((mask & (1 << s)) == 0) s++;
+                    best_selector[i] = s;
+#else
+                    best_error_a = NV_FLOAT_MAX;
+
                     for (uint s = 0; s < ALPHA_SELECTORS; s++) {
-                        float alpha;
-                        if (options.use_11bit_mode) {
-                            alpha = get_alpha11(base, t, multiplier, s);
-                        }
-                        else {
-                            alpha = get_alpha8(base, t, multiplier, s);
-                        }
-                    
-                        float error_a = alpha - input_colors[i].component[input_channel];
+                        float error_a = palette[s] - input_colors[i].component[input_channel];
                         error_a = error_a * error_a;
                     
                         if (error_a < best_error_a) {
@@ -2104,7 +2625,8 @@ float compress_eac_range_search(Vector4 input_colors[16], float input_weights[16
                             best_selector[i] = s;
                         }
                     }
-                
+#endif
+
                     block_error += best_error_a * input_weights[i];
                     if (block_error > best.error) {
                         break;  // Don't waste more time.
@@ -2220,12 +2742,58 @@ void nv::decompress_etc_eac(const void * input, Vector4 output_colors[16]) {
 #endif
 }
 
-float nv::compress_etc1(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, void * output) {
+void nv::decompress_eac_rg(const void * input, Vector4 output_colors[16]) {
+    const BlockEAC * input_block = (const BlockEAC *)input;
+
+    for (int i = 0; i < 16; i++) {
+        output_colors[i] = Vector4(0, 0, 0, 1);
+    }
+
+    EAC_Data eac;
+    unpack_eac_block(&input_block[0], &eac);
+    decode_eac_11(eac, output_colors, 0);
+
+    unpack_eac_block(&input_block[1], &eac);
+    decode_eac_11(eac, output_colors, 1);
+}
+
+// Search effort of the encoder for each nvtt::Quality level.
+static void set_quality(int quality, ETC_Options * options) {
+    // Fastest: range fit, pick the table from the luminance range of each sub block.
+    options->rg_etc_quality = 0;
+    options->evaluate_tables = false;
+    options->use_table_search = false;
+    options->color_search_radius = 0;
+    options->color_search_channels = false;
+
+    if (quality >= 1) {
+        // Normal: range fit, evaluate all tables for the base color of each sub block.
+        options->rg_etc_quality = 1;
+        options->evaluate_tables = true;
+    }
+    if (quality >= 2) {
+        // Production: search all tables in both modes and flips, moving the base colors along the luminance axis.
+        options->rg_etc_quality = 2;
+        options->use_table_search = true;
+        options->color_search_radius = 1;
+    }
+    if (quality >= 3) {
+        // Highest: move each channel of the base colors.
+        options->color_search_channels = true;
+    }
+}
+
+int nv::eac_search_radius(int quality) {
+    return quality <= 0 ? 0 : (quality == 1 ? 1 : 2);
+}
+
+float nv::compress_etc1(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, int quality, void * output) {
     
     process_input_colors(input_colors);
     
     // @@ Use same options for all blocks?
     ETC_Options options;
+    set_quality(quality, &options);
     options.use_rg_etc = true;
     options.enable_etc2 = false;
     options.use_t_mode = false;
@@ -2236,33 +2804,33 @@ float nv::compress_etc1(Vector4 input_colors[16], float input_weights[16], const
     return compress_etc(input_colors, input_weights, options, output);
 }
 
-float nv::compress_etc2(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, void * output) {
+float nv::compress_etc2(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, int quality, void * output) {
     
     process_input_colors(input_colors);
     process_input_weights(input_weights);
     
     ETC_Options options;
+    set_quality(quality, &options);
     options.use_rg_etc = true;
     options.enable_etc2 = true;
     options.use_t_mode = false; // @@ Not implemented.
     options.use_h_mode = false; // @@ Not implemented.
-    options.use_planar = true;
     options.color_weights = color_weights;
 
     return compress_etc(input_colors, input_weights, options, output);
 }
 
-float nv::compress_etc2_a1(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, void * output) {
+float nv::compress_etc2_a1(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, int quality, void * output) {
     
     process_input_colors(input_colors);
     process_input_weights(input_weights);
     
     ETC_Options options;
+    set_quality(quality, &options);
     options.use_rg_etc = true;
     options.enable_etc2 = true;
     options.use_t_mode = false; // @@ Not implemented.
     options.use_h_mode = false; // @@ Not implemented.
-    options.use_planar = true;
     options.onebit_alpha = true;
     options.color_weights = color_weights;
     
@@ -2283,10 +2851,119 @@ float nv::compress_eac(Vector4 input_colors[16], float input_weights[16], int in
     return compress_eac_range_search(input_colors, input_weights, input_channel, options, output);
 }
 
-float nv::compress_etc2_eac(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, void * output) {
+// Single color blocks use the same base color, intensity table and selector everywhere. The combination with the lowest
+// error is selected using the table of base colors, without any search over the pixels.
+float nv::compress_etc1_single_color(const Vector4 & input_color, const Vector3 & color_weights, void * output) {
+    init_etc_single_color_tables();
+
+    const Vector4 color = saturate(input_color);
+    const int r = ftoi_round(color.x * 255);
+    const int g = ftoi_round(color.y * 255);
+    const int b = ftoi_round(color.z * 255);
+
+    int best_diff = 0, best_table = 0, best_selector = 0;
+    float best_error = NV_FLOAT_MAX;
+
+    for (int diff = 0; diff < 2; diff++) {
+        for (int t = 0; t < 8; t++) {
+            for (int s = 0; s < 4; s++) {
+                const int dr = etc_single_color_value(diff, t, s, etc_single_color_base[diff][t][s][r]) - r;
+                const int dg = etc_single_color_value(diff, t, s, etc_single_color_base[diff][t][s][g]) - g;
+                const int db = etc_single_color_value(diff, t, s, etc_single_color_base[diff][t][s][b]) - b;
+                const float error = color_weights.x * dr * dr + color_weights.y * dg * dg + color_weights.z * db * db;
+
+                if (error < best_error) {
+                    best_error = error;
+                    best_diff = diff;
+                    best_table = t;
+                    best_selector = s;
+                }
+            }
+        }
+    }
+
+    const uint16 base_r = etc_single_color_base[best_diff][best_table][best_selector][r];
+    const uint16 base_g = etc_single_color_base[best_diff][best_table][best_selector][g];
+    const uint16 base_b = etc_single_color_base[best_diff][best_table][best_selector][b];
+
+    // Both sub-blocks have the same base color, the differential ones have a zero delta.
+    ETC_Data data;
+    data.mode = ETC_Data::Mode_ETC1;
+    data.etc.diff = best_diff != 0;
+    data.etc.flip = false;
+    data.etc.table0 = data.etc.table1 = U8(best_table);
+    if (best_diff) {
+        data.etc.color0 = (base_r << 10) | (base_g << 5) | base_b;
+        data.etc.color1 = 0;
+    }
+    else {
+        data.etc.color0 = data.etc.color1 = (base_r << 8) | (base_g << 4) | base_b;
+    }
+    for (int i = 0; i < 16; i++) {
+        data.selector[i] = U8(best_selector);
+    }
+
+    pack_etc2_block(data, (BlockETC *)output);
+
+    return 16 * best_error / (255.0f * 255.0f);
+}
+
+// ETC2 planar blocks can dither a single color with their gradients, that is often closer than any ETC1 block. The
+// channels of planar blocks are independent, the best encoding of each one comes from a table.
+float nv::compress_etc2_single_color(const Vector4 & input_color, const Vector3 & color_weights, void * output) {
+    init_etc_single_color_tables();
+
+    float error = compress_etc1_single_color(input_color, color_weights, output);
+    if (error == 0) return error;
+
+    const Vector4 color = saturate(input_color);
+    const ETC_PlanarChannel & r = etc_planar_single_color[0][ftoi_round(color.x * 255)];
+    const ETC_PlanarChannel & g = etc_planar_single_color[1][ftoi_round(color.y * 255)];
+    const ETC_PlanarChannel & b = etc_planar_single_color[0][ftoi_round(color.z * 255)];
+
+    const float planar_error = (color_weights.x * r.error + color_weights.y * g.error + color_weights.z * b.error) / (255.0f * 255.0f);
+
+    ETC_Data data;
+    data.mode = ETC_Data::Mode_Planar;
+    data.planar.ro = r.o; data.planar.rh = r.h; data.planar.rv = r.v;
+    data.planar.go = g.o; data.planar.gh = g.h; data.planar.gv = g.v;
+    data.planar.bo = b.o; data.planar.bh = b.h; data.planar.bv = b.v;
+
+    if (planar_error < error) {
+        pack_etc2_block(data, (BlockETC *)output);
+        error = planar_error;
+    }
+
+    return error;
+}
+
+float nv::compress_etc2_eac_single_color(const Vector4 & input_color, const Vector3 & color_weights, void * output) {
     BlockETC_EAC * output_block = (BlockETC_EAC *)output;
-    float error = compress_etc2(input_colors, input_weights, color_weights, &output_block->etc);
-    error += compress_eac(input_colors, input_weights, /*input_channel=*/3, /*search_radius=*/1, /*use_11bit_mode=*/false, &output_block->eac);
+    float error = compress_etc2_single_color(input_color, color_weights, &output_block->etc);
+
+    // The range search finds the exact alpha of a single value quickly.
+    Vector4 colors[16];
+    float weights[16];
+    for (int i = 0; i < 16; i++) {
+        colors[i] = input_color;
+        weights[i] = 1.0f;
+    }
+    error += compress_eac(colors, weights, /*input_channel=*/3, /*search_radius=*/1, /*use_11bit_mode=*/false, &output_block->eac);
+    return error;
+}
+
+float nv::compress_etc2_eac(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, int quality, void * output) {
+    BlockETC_EAC * output_block = (BlockETC_EAC *)output;
+    float error = compress_etc2(input_colors, input_weights, color_weights, quality, &output_block->etc);
+    error += compress_eac(input_colors, input_weights, /*input_channel=*/3, eac_search_radius(quality), /*use_11bit_mode=*/false, &output_block->eac);
+    return error;
+}
+
+float nv::compress_eac_rg(Vector4 input_colors[16], float input_weights[16], int search_radius, void * output) {
+    // The channels are independent, the red channel is stored in the first 11 bit EAC block and green in the second.
+    BlockEAC * output_block = (BlockEAC *)output;
+    float error = compress_eac(input_colors, input_weights, /*input_channel=*/0, search_radius, /*use_11bit_mode=*/true, &output_block[0]);
+    error += compress_eac(input_colors, input_weights, /*input_channel=*/1, search_radius, /*use_11bit_mode=*/true, &output_block[1]);
     return error;
 }
 
@@ -8,12 +8,28 @@ namespace nv {
     void decompress_etc(const void * input_block, Vector4 output_colors[16]);
     void decompress_eac(const void * input_block, Vector4 output_colors[16], int output_channel);
     void decompress_etc_eac(const void * input_block, Vector4 output_colors[16]);
+    void decompress_eac_rg(const void * input_block, Vector4 output_colors[16]);
 
-    float compress_etc1(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, void * output);
-    float compress_etc2(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, void * output);
-    float compress_etc2_a1(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, void * output);
+    // The quality is a nvtt::Quality level, it selects the search radius and the modes that are evaluated.
+    float compress_etc1(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, int quality, void * output);
+    float compress_etc2(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, int quality, void * output);
+    float compress_etc2_a1(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, int quality, void * output);
     float compress_eac(Vector4 input_colors[16], float input_weights[16], int input_channel, int search_radius, bool use_11bit_mode, void * output);
-    float compress_etc2_eac(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, void * output);
+    float compress_etc2_eac(Vector4 input_colors[16], float input_weights[16], const Vector3 & color_weights, int quality, void * output);
+    float compress_eac_rg(Vector4 input_colors[16], float input_weights[16], int search_radius, void * output);
+
+    // Optimal encodings of blocks in which all the pixels have the same color. The ETC1 blocks are also valid ETC2 blocks.
+    float compress_etc1_single_color(const Vector4 & color, const Vector3 & color_weights, void * output);
+    float compress_etc2_single_color(const Vector4 & color, const Vector3 & color_weights, void * output);
+    float compress_etc2_eac_single_color(const Vector4 & color, const Vector3 & color_weights, void * output);
+
+    // EAC search radius for the given quality level.
+    int eac_search_radius(int quality);
+
+#if defined(HAVE_RGETC)
+    // Builds the tables of rg_etc1 the first time it's called, it has to be called before packing blocks with rg_etc1.
+    void init_rg_etc();
+#endif
 
 }
 
@@ -0,0 +1,374 @@
+
+#include "CompressorRDO.h"
+
+#include "nvimage/BlockDXT.h"
+#include "nvimage/ColorBlock.h"
+
+#include "nvmath/Vector.inl"
+#include "nvmath/Color.h"
+
+#include <string.h> // memcmp, memcpy
+
+using namespace nv;
+
+// The errors are the sum of the squared errors of the 16 pixels of the block, and lambda is given per pixel.
+#define RDO_LAMBDA_SCALE 16.0f
+
+// Number of previous blocks searched for reusable bytes.
+#define RDO_WINDOW_SIZE 32
+
+// Estimated cost in bits of the fields of a block after LZ compression. A field that is equal to the same field of a
+// previous block is coded as a match, and the match extends almost for free through the following fields that are also
+// equal to those of the same block. The other fields are coded as literals. Matches at other offsets are not detected.
+#define RDO_MATCH_BITS 20.0f
+#define RDO_CONTINUE_BITS 2.0f
+
+namespace {
+
+    struct Field {
+        uint offset;
+        uint size;
+    };
+
+    // Endpoints and indices of each format.
+    static const Field s_bc1_fields[] = { {0, 4}, {4, 4} };
+    static const Field s_bc3_fields[] = { {0, 2}, {2, 6}, {8, 4}, {12, 4} };
+    static const Field s_bc7_fields[] = { {0, 16} };
+
+    // Blocks that precede the optimized block.
+    struct Window {
+        const uint8 * blocks;
+        uint count;
+        uint block_size;
+        const Field * fields;
+        uint field_count;
+    };
+
+    static Window makeWindow(const void * previous, uint previous_count, uint block_size, const Field * fields, uint field_count)
+    {
+        Window window;
+        window.count = min(previous_count, uint(RDO_WINDOW_SIZE));
+        window.blocks = (const uint8 *)previous + (previous_count - window.count) * block_size;
+        window.block_size = block_size;
+        window.fields = fields;
+        window.field_count = field_count;
+        return window;
+    }
+
+    static float estimateBits(const Window & window, const uint8 * block)
+    {
+        float bits = 0.0f;
+        int match = -1;
+
+        for (uint f = 0; f < window.field_count; f++) {
+            const uint offset = window.fields[f].offset;
+            const uint size = window.fields[f].size;
+
+            if (match >= 0 && memcmp(window.blocks + match * window.block_size + offset, block + offset, size) == 0) {
+                bits += RDO_CONTINUE_BITS;
+                continue;
+            }
+
+            // Look for the nearest match, it has the smallest offset.
+            match = -1;
+            for (int i = int(window.count) - 1; i >= 0; i--) {
+                if (memcmp(window.blocks + i * window.block_size + offset, block + offset, size) == 0) {
+                    match = i;
+                    break;
+                }
+            }
+
+            bits += (match >= 0) ? min(RDO_MATCH_BITS, 8.0f * size) : 8.0f * size;
+        }
+
+        return bits;
+    }
+
+
+    // BC1 color blocks.
+
+    inline bool usesIndex3(uint indices)
+    {
+        return (indices & (indices >> 1) & 0x55555555) != 0;
+    }
+
+    inline float colorDistance(const Vector3 & c, Color32 p, const Vector3 & w)
+    {
+        const float dr = c.x - p.r;
+        const float dg = c.y - p.g;
+        const float db = c.z - p.b;
+        return w.x * dr * dr + w.y * dg * dg + w.z * db * db;
+    }
+
+    static float evaluateColorError(const Vector3 src[16], const float weights[16], const Vector3 & color_weights, const Color32 palette[4], uint indices)
+    {
+        float error = 0.0f;
+        for (uint i = 0; i < 16; i++) {
+            error += weights[i] * colorDistance(src[i], palette[(indices >> (2 * i)) & 3], color_weights);
+        }
+        return error;
+    }
+
+    static float selectColorIndices(const Vector3 src[16], const float weights[16], const Vector3 & color_weights, const Color32 palette[4], uint palette_size, uint * indices)
+    {
+        float error = 0.0f;
+        *indices = 0;
+        for (uint i = 0; i < 16; i++) {
+            uint best = 0;
+            float best_distance = colorDistance(src[i], palette[0], color_weights);
+            for (uint p = 1; p < palette_size; p++) {
+                float distance = colorDistance(src[i], palette[p], color_weights);
+                if (distance < best_distance) {
+                    best_distance = distance;
+                    best = p;
+                }
+            }
+            *indices |= best << (2 * i);
+            error += weights[i] * best_distance;
+        }
+        return error;
+    }
+
+    struct ColorMode {
+        bool four_color_only;   // BC2 and BC3 decode the color block in four color mode.
+        bool three_color_mode;  // Three color blocks, with transparent black, are allowed.
+        bool d3d9;
+    };
+
+    inline void evaluateColorPalette(const BlockDXT1 & block, const ColorMode & mode, Color32 palette[4])
+    {
+        if (mode.four_color_only) block.evaluatePalette4(palette, mode.d3d9);
+        else block.evaluatePalette(palette, mode.d3d9);
+    }
+
+    inline bool isValidColorBlock(const BlockDXT1 & block, const ColorMode & mode)
+    {
+        return mode.four_color_only || mode.three_color_mode || block.isFourColorMode() || !usesIndex3(block.indices);
+    }
+
+    // Optimizes the color block at the given offset of block.
+    static void optimizeColorBlock(const Vector3 src[16], const float weights[16], const Vector3 & color_weights, const ColorMode & mode, float lambda, const Window & window, uint offset, uint8 * block)
+    {
+        const BlockDXT1 original = *(const BlockDXT1 *)(block + offset);
+
+        Color32 original_palette[4];
+        evaluateColorPalette(original, mode, original_palette);
+
+        uint8 best[16];
+        memcpy(best, block, window.block_size);
+        float best_cost = evaluateColorError(src, weights, color_weights, original_palette, original.indices) + lambda * estimateBits(window, block);
+
+        uint8 candidate[16];
+        memcpy(candidate, block, window.block_size);
+        BlockDXT1 & color = *(BlockDXT1 *)(candidate + offset);
+
+        for (uint i = 0; i < window.count; i++) {
+            const BlockDXT1 & previous = *(const BlockDXT1 *)(window.blocks + i * window.block_size + offset);
+
+            Color32 palette[4];
+            evaluateColorPalette(previous, mode, palette);
+
+            for (uint c = 0; c < 3; c++) {
+                float error;
+                if (c == 0) {
+                    // The whole color block.
+                    color = previous;
+                    error = evaluateColorError(src, weights, color_weights, palette, color.indices);
+                }
+                else if (c == 1) {
+                    // The endpoints, with the best indices for them.
+                    const uint palette_size = (mode.four_color_only || mode.three_color_mode || previous.isFourColorMode()) ? 4 : 3;
+                    color = previous;
+                    error = selectColorIndices(src, weights, color_weights, palette, palette_size, &color.indices);
+                }
+                else {
+                    // The indices, with the original endpoints.
+                    color = original;
+                    color.indices = previous.indices;
+                    error = evaluateColorError(src, weights, color_weights, original_palette, color.indices);
+                }
+
+                // The bits are only estimated when the error leaves room for a lower cost.
+                if (!isValidColorBlock(color, mode) || error >= best_cost) continue;
+
+                const float cost = error + lambda * estimateBits(window, candidate);
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    memcpy(best, candidate, window.block_size);
+                }
+            }
+        }
+
+        memcpy(block, best, window.block_size);
+    }
+
+
+    // BC3 alpha blocks.
+
+    static float evaluateAlphaError(const float src[16], float alpha_weight, const AlphaBlockDXT5 & block, bool d3d9)
+    {
+        uint8 palette[8];
+        block.evaluatePalette(palette, d3d9);
+
+        float error = 0.0f;
+        for (uint i = 0; i < 16; i++) {
+            const float d = src[i] - palette[block.index(i)];
+            error += alpha_weight * d * d;
+        }
+        return error;
+    }
+
+    static float selectAlphaIndices(const float src[16], float alpha_weight, AlphaBlockDXT5 * block, bool d3d9)
+    {
+        uint8 palette[8];
+        block->evaluatePalette(palette, d3d9);
+
+        float error = 0.0f;
+        for (uint i = 0; i < 16; i++) {
+            uint best = 0;
+            float best_distance = square(src[i] - palette[0]);
+            for (uint p = 1; p < 8; p++) {
+                float distance = square(src[i] - palette[p]);
+                if (distance < best_distance) {
+                    best_distance = distance;
+                    best = p;
+                }
+            }
+            block->setIndex(i, best);
+            error += alpha_weight * best_distance;
+        }
+        return error;
+    }
+
+    // Optimizes the alpha block at the given offset of block.
+    static void optimizeAlphaBlock(const float src[16], float alpha_weight, bool d3d9, float lambda, const Window & window, uint offset, uint8 * block)
+    {
+        const AlphaBlockDXT5 original = *(const AlphaBlockDXT5 *)(block + offset);
+
+        uint8 best[16];
+        memcpy(best, block, window.block_size);
+        float best_cost = evaluateAlphaError(src, alpha_weight, original, d3d9) + lambda * estimateBits(window, block);
+
+        uint8 candidate[16];
+        memcpy(candidate, block, window.block_size);
+        AlphaBlockDXT5 & alpha = *(AlphaBlockDXT5 *)(candidate + offset);
+
+        for (uint i = 0; i < window.count; i++) {
+            const AlphaBlockDXT5 & previous = *(const AlphaBlockDXT5 *)(window.blocks + i * window.block_size + offset);
+
+            for (uint c = 0; c < 3; c++) {
+                float error;
+                if (c == 0) {
+                    // The whole alpha block.
+                    alpha = previous;
+                    error = evaluateAlphaError(src, alpha_weight, alpha, d3d9);
+                }
+                else if (c == 1) {
+                    // The endpoints, with the best indices for them.
+                    alpha = previous;
+                    error = selectAlphaIndices(src, alpha_weight, &alpha, d3d9);
+                }
+                else {
+                    // The indices, with the original endpoints.
+                    alpha.u = (original.u & 0xFFFF) | (previous.u & ~uint64(0xFFFF));
+                    error = evaluateAlphaError(src, alpha_weight, alpha, d3d9);
+                }
+
+                if (error >= best_cost) continue;
+
+                const float cost = error + lambda * estimateBits(window, candidate);
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    memcpy(best, candidate, window.block_size);
+                }
+            }
+        }
+
+        memcpy(block, best, window.block_size);
+    }
+
+} // namespace
+
+
+void nv::rdo_bc1(const Vector4 colors[16], const float weights[16], const Vector3 & color_weights, bool three_color_mode, bool d3d9, float lambda, const BlockDXT1 * previous, uint previous_count, BlockDXT1 * output)
+{
+    Vector3 src[16];
+    for (uint i = 0; i < 16; i++) {
+        src[i] = 255.0f * saturate(colors[i].xyz());
+    }
+
+    ColorMode mode;
+    mode.four_color_only = false;
+    mode.three_color_mode = three_color_mode;
+    mode.d3d9 = d3d9;
+
+    const Window window = makeWindow(previous, previous_count, sizeof(BlockDXT1), s_bc1_fields, 2);
+    optimizeColorBlock(src, weights, color_weights, mode, RDO_LAMBDA_SCALE * lambda, window, 0, (uint8 *)output);
+}
+
+void nv::rdo_bc3(const Vector4 colors[16], const float weights[16], const Vector4 & color_weights, bool d3d9, float lambda, const BlockDXT5 * previous, uint previous_count, BlockDXT5 * output)
+{
+    Vector3 src[16];
+    float alpha[16];
+    for (uint i = 0; i < 16; i++) {
+        src[i] = 255.0f * saturate(colors[i].xyz());
+        alpha[i] = 255.0f * saturate(colors[i].w);
+    }
+
+    ColorMode mode;
+    mode.four_color_only = true;
+    mode.three_color_mode = false;
+    mode.d3d9 = d3d9;
+
+    // The alpha and color blocks are optimized one after the other.
+    const Window window = makeWindow(previous, previous_count, sizeof(BlockDXT5), s_bc3_fields, 4);
+    optimizeAlphaBlock(alpha, color_weights.w, d3d9, RDO_LAMBDA_SCALE * lambda, window, 0, (uint8 *)output);
+    optimizeColorBlock(src, weights, color_weights.xyz(), mode, RDO_LAMBDA_SCALE * lambda, window, 8, (uint8 *)output);
+}
+
+static float evaluateBC7Error(const Vector4 src[16], const float weights[16], const Vector4 & color_weights, const BlockBC7 & block)
+{
+    ColorBlock decoded;
+    block.decodeBlock(&decoded);
+
+    float error = 0.0f;
+    for (uint i = 0; i < 16; i++) {
+        const Color32 c = decoded.color(i);
+        const float dr = src[i].x - c.r;
+        const float dg = src[i].y - c.g;
+        const float db = src[i].z - c.b;
+        const float da = src[i].w - c.a;
+        error += weights[i] * (color_weights.x * dr * dr + color_weights.y * dg * dg + color_weights.z * db * db) + color_weights.w * da * da;
+    }
+    return error;
+}
+
+void nv::rdo_bc7(const Vector4 colors[16], const float weights[16], const Vector4 & color_weights, float lambda, const BlockBC7 * previous, uint previous_count, BlockBC7 * output)
+{
+    Vector4 src[16];
+    for (uint i = 0; i < 16; i++) {
+        src[i] = 255.0f * saturate(colors[i]);
+    }
+
+    const Window window = makeWindow(previous, previous_count, sizeof(BlockBC7), s_bc7_fields, 1);
+    lambda *= RDO_LAMBDA_SCALE;
+
+    BlockBC7 best = *output;
+    float best_cost = evaluateBC7Error(src, weights, color_weights, best) + lambda * estimateBits(window, best.data);
+
+    for (uint i = 0; i < window.count; i++) {
+        const BlockBC7 & candidate = *(const BlockBC7 *)(window.blocks + i * sizeof(BlockBC7));
+        if (memcmp(candidate.data, best.data, sizeof(BlockBC7)) == 0) continue;
+
+        const float error = evaluateBC7Error(src, weights, color_weights, candidate);
+        if (error >= best_cost) continue;
+
+        const float cost = error + lambda * estimateBits(window, candidate.data);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = candidate;
+        }
+    }
+
+    *output = best;
+}
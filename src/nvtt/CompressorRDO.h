@@ -0,0 +1,21 @@
+
+#include "nvcore/nvcore.h"
+
+namespace nv {
+
+    struct BlockDXT1;
+    struct BlockDXT5;
+    struct BlockBC7;
+    class Vector3;
+    class Vector4;
+
+    // Rate-distortion optimization of compressed blocks, see CompressionOptions::setRateDistortionLambda. The block in
+    // output is replaced by a block that reuses the endpoints, the indices or all the bytes of one of the blocks that
+    // precede it in the output, if that reduces error + lambda * bits. The error is the weighted squared error of the
+    // block in 8 bit units and the bits are an estimate of the size of the block after LZ compression.
+    void rdo_bc1(const Vector4 colors[16], const float weights[16], const Vector3 & color_weights, bool three_color_mode, bool d3d9, float lambda, const BlockDXT1 * previous, uint previous_count, BlockDXT1 * output);
+    void rdo_bc3(const Vector4 colors[16], const float weights[16], const Vector4 & color_weights, bool d3d9, float lambda, const BlockDXT5 * previous, uint previous_count, BlockDXT5 * output);
+
+    // BC7 blocks only reuse whole blocks.
+    void rdo_bc7(const Vector4 colors[16], const float weights[16], const Vector4 & color_weights, float lambda, const BlockBC7 * previous, uint previous_count, BlockBC7 * output);
+}
@@ -30,6 +30,7 @@
 #include "CompressionOptions.h"
 #include "OutputOptions.h"
 #include "Surface.h"
+#include "BlockCache.h"
 #include "icbc.h"
 
 #include "CompressorDX9.h"
@@ -68,8 +69,7 @@ Compressor::Compressor() : m(*new Compressor::Private())
     enableCudaAcceleration(m.cudaSupported);
 
     m.dispatcher = &m.defaultDispatcher;
-
-    icbc::init_dxt1();
+    m.pipeliningEnabled = true;
 }
 
 Compressor::~Compressor()
@@ -77,6 +77,13 @@ Compressor::~Compressor()
     delete &m;
 }
 
+Compressor::Private::~Private()
+{
+    for (uint i = 0; i < compressorCache.count(); i++) {
+        delete compressorCache[i].compressor;
+    }
+}
+
 
 void Compressor::enableCudaAcceleration(bool enable)
 {
@@ -112,6 +119,42 @@ void Compressor::setTaskDispatcher(TaskDispatcher * disp)
     }
 }
 
+void Compressor::enablePipelining(bool enable)
+{
+    m.pipeliningEnabled = enable;
+}
+
+bool Compressor::isPipeliningEnabled() const
+{
+    return m.pipeliningEnabled;
+}
+
+void Compressor::enableBlockCache(bool enable)
+{
+    if (!enable) {
+        m.blockCache = NULL;
+    }
+    else if (m.blockCache == NULL) {
+        m.blockCache = new BlockCache;
+    }
+}
+
+bool Compressor::isBlockCacheEnabled() const
+{
+    return m.blockCache != NULL;
+}
+
+void Compressor::blockCacheStatistics(unsigned int * lookupCount, unsigned int * hitCount) const
+{
+    if (m.blockCache != NULL) {
+        m.blockCache->statistics(lookupCount, hitCount);
+    }
+    else {
+        if (lookupCount != NULL) *lookupCount = 0;
+        if (hitCount != NULL) *hitCount = 0;
+    }
+}
+
 
 // Input Options API.
 bool Compressor::process(const InputOptions & inputOptions, const CompressionOptions & compressionOptions, const OutputOptions & outputOptions) const
@@ -119,6 +162,43 @@ bool Compressor::process(const InputOptions & inputOptions, const CompressionOpt
     return m.compress(inputOptions.m, compressionOptions.m, outputOptions.m);
 }
 
+namespace
+{
+    struct BatchContext {
+        const Compressor::Private * compressor;
+        const BatchJob * jobs;
+        bool * results;
+    };
+
+    void BatchTask(void * context, int /*tid*/, int begin, int end)
+    {
+        const BatchContext * batch = (const BatchContext *)context;
+
+        for (int i = begin; i < end; i++) {
+            const BatchJob & job = batch->jobs[i];
+            batch->results[i] = batch->compressor->compress(job.inputOptions->m, job.compressionOptions->m, job.outputOptions->m);
+        }
+    }
+}
+
+bool Compressor::processBatch(const BatchJob * jobs, int jobCount) const
+{
+    if (jobCount <= 0) return true;
+
+    // Each task compresses a whole texture. Small textures are compressed in a single thread, so the parallelism comes
+    // from running many jobs at once, while the blocks of large textures are still dispatched in parallel.
+    Array<bool> results;
+    results.resize(jobCount);
+
+    BatchContext context = { &m, jobs, results.buffer() };
+    m.dispatcher->dispatchRange(BatchTask, &context, jobCount, 1);
+
+    for (int i = 0; i < jobCount; i++) {
+        if (!results[i]) return false;
+    }
+    return true;
+}
+
 int Compressor::estimateSize(const InputOptions & inputOptions, const CompressionOptions & compressionOptions) const
 {
     int w = inputOptions.m.width;
@@ -214,6 +294,51 @@ int Compressor::estimateSize(int w, int h, int d, int mipmapCount, const Compres
 
 
 
+namespace
+{
+    template <typename F>
+    void runPipelineTask(void * context, int /*tid*/, uint /*begin*/, uint /*end*/)
+    {
+        F & f = *reinterpret_cast<F *>(context);
+        f();
+    }
+}
+
+// Prepare and output a sequence of images in order. When pipelining is enabled, the next image is prepared in a separate
+// task while the current one is being compressed, only the output runs in the calling thread. The task runs in the shared
+// task scheduler, so pipelining is only used with the default dispatcher. Custom dispatchers may restrict the work to
+// their own threads.
+template <typename Prepare, typename Output>
+void Compressor::Private::pipeline(int count, Prepare & prepare, Output & output) const
+{
+    const bool pipelined = pipeliningEnabled && dispatcher == &defaultDispatcher;
+    nv::TaskScheduler * scheduler = pipelined ? nv::TaskScheduler::instance() : NULL;
+
+    nvtt::Surface current, next;
+    prepare(0, current);
+
+    for (int i = 0; i < count; i++) {
+        const bool hasNext = (i + 1 < count);
+        auto task = [&]() { prepare(i + 1, next); };
+
+        nv::TaskGroup group;
+        if (pipelined && hasNext) {
+            scheduler->spawn(&group, runPipelineTask<decltype(task)>, &task, 0, 1);
+        }
+
+        output(i, current);
+
+        if (pipelined) {
+            scheduler->wait(&group);
+        }
+        else if (hasNext) {
+            task();
+        }
+
+        current = next;
+    }
+}
+
 bool Compressor::Private::compress(const InputOptions::Private & inputOptions, const CompressionOptions::Private & compressionOptions, const OutputOptions::Private & outputOptions) const
 {
     // Make sure enums match.
@@ -264,38 +389,40 @@ bool Compressor::Private::compress(const InputOptions::Private & inputOptions, c
             int d = depth;
             bool canUseSourceImagesForThisFace = canUseSourceImages;
 
-            img.setImage(inputOptions.inputFormat, inputOptions.width, inputOptions.height, inputOptions.depth, inputOptions.images[f]);
+            auto prepare = [&](int m, nvtt::Surface & tmp) {
+                if (m == 0) {
+                    img.setImage(inputOptions.inputFormat, inputOptions.width, inputOptions.height, inputOptions.depth, inputOptions.images[f]);
 
-            // To normal map.
-            if (inputOptions.convertToNormalMap) {
-                img.toGreyScale(inputOptions.heightFactors.x, inputOptions.heightFactors.y, inputOptions.heightFactors.z, inputOptions.heightFactors.w);
-                img.toNormalMap(inputOptions.bumpFrequencyScale.x, inputOptions.bumpFrequencyScale.y, inputOptions.bumpFrequencyScale.z, inputOptions.bumpFrequencyScale.w);
-            }
+                    // To normal map.
+                    if (inputOptions.convertToNormalMap) {
+                        img.toGreyScale(inputOptions.heightFactors.x, inputOptions.heightFactors.y, inputOptions.heightFactors.z, inputOptions.heightFactors.w);
+                        img.toNormalMap(inputOptions.bumpFrequencyScale.x, inputOptions.bumpFrequencyScale.y, inputOptions.bumpFrequencyScale.z, inputOptions.bumpFrequencyScale.w);
+                    }
 
-            // To linear space.
-            if (!img.isNormalMap()) {
-                img.toLinear(inputOptions.inputGamma);
-            }
+                    // To linear space.
+                    if (!img.isNormalMap()) {
+                        img.toLinear(inputOptions.inputGamma);
+                    }
 
-            // renormalize blue channel to avoid quantization artifacts in mipmaps
-            if (f == 0 && img.isNormalMap() && inputOptions.normalizeMipmaps) {
-                img.expandNormals();
-                img.computeBlueNormal();
-                img.packNormals();
-            }
+                    // renormalize blue channel to avoid quantization artifacts in mipmaps
+                    if (f == 0 && img.isNormalMap() && inputOptions.normalizeMipmaps) {
+                        img.expandNormals();
+                        img.computeBlueNormal();
+                        img.packNormals();
+                    }
 
-            // Resize input.
-            img.resize(w, h, d, ResizeFilter_Box);
+                    // Resize input.
+                    img.resize(w, h, d, ResizeFilter_Box);
 
-            nvtt::Surface tmp = img;
-            if (!img.isNormalMap()) {
-                tmp.toGamma(inputOptions.outputGamma);
-            }
+                    tmp = img;
+                    if (!img.isNormalMap()) {
+                        tmp.toGamma(inputOptions.outputGamma);
+                    }
 
-            quantize(tmp, compressionOptions);
-            compress(tmp, f, 0, compressionOptions, outputOptions);
+                    quantize(tmp, compressionOptions);
+                    return;
+                }
 
-            for (int m = 1; m < mipmapCount; m++) {
                 w = max(1, w/2);
                 h = max(1, h/2);
                 d = max(1, d/2);
@@ -347,135 +474,144 @@ bool Compressor::Private::compress(const InputOptions::Private & inputOptions, c
                 }
 
                 quantize(tmp, compressionOptions);
+            };
+
+            auto output = [&](int m, const nvtt::Surface & tmp) {
                 compress(tmp, f, m, compressionOptions, outputOptions);
-            }
+            };
+
+            pipeline(mipmapCount, prepare, output);
         }
     }
     else
     {
         // KTX files expect face mipmaps to be interleaved.
-        Array<nvtt::Surface> images(faceCount);
-        Array<bool> mipChainBroken(faceCount);
+        Array<nvtt::Surface> images;
+        Array<bool> mipChainBroken;
+        images.resize(faceCount);
+        mipChainBroken.resize(faceCount);
+
+        auto prepare = [&](int i, nvtt::Surface & tmp) {
+            const int m = i / faceCount;
+            const int f = i % faceCount;
+            const int w = max(1, width >> m);
+            const int h = max(1, height >> m);
+            const int d = max(1, depth >> m);
+
+            nvtt::Surface & img = images[f];
+
+            if (m == 0) {
+                img.setWrapMode(inputOptions.wrapMode);
+                img.setAlphaMode(inputOptions.alphaMode);
+                img.setNormalMap(inputOptions.isNormalMap);
+
+                img.setImage(inputOptions.inputFormat, inputOptions.width, inputOptions.height, inputOptions.depth, inputOptions.images[f]);
+
+                // To normal map.
+                if (inputOptions.convertToNormalMap) {
+                    img.toGreyScale(inputOptions.heightFactors.x, inputOptions.heightFactors.y, inputOptions.heightFactors.z, inputOptions.heightFactors.w);
+                    img.toNormalMap(inputOptions.bumpFrequencyScale.x, inputOptions.bumpFrequencyScale.y, inputOptions.bumpFrequencyScale.z, inputOptions.bumpFrequencyScale.w);
+                }
 
-        int w = width;
-        int h = height;
-        int d = depth;
+                // To linear space.
+                if (!img.isNormalMap()) {
+                    img.toLinear(inputOptions.inputGamma);
+                }
 
-        // https://www.khronos.org/opengles/sdk/tools/KTX/file_format_spec/#2.16
-        uint imageSize = estimateSize(w, h, 1, 1, compressionOptions) * faceCount;
-        outputOptions.writeData(&imageSize, sizeof(uint32));
+                // Resize input.
+                img.resize(w, h, d, ResizeFilter_Box);
 
-        for (int f = 0; f < faceCount; f++)
-        {
-            nvtt::Surface s;
-            s.setWrapMode(inputOptions.wrapMode);
-            s.setAlphaMode(inputOptions.alphaMode);
-            s.setNormalMap(inputOptions.isNormalMap);
+                tmp = img;
+                if (!img.isNormalMap()) {
+                    tmp.toGamma(inputOptions.outputGamma);
+                }
 
-            s.setImage(inputOptions.inputFormat, inputOptions.width, inputOptions.height, inputOptions.depth, inputOptions.images[f]);
+                quantize(tmp, compressionOptions);
 
-            // To normal map.
-            if (inputOptions.convertToNormalMap) {
-                s.toGreyScale(inputOptions.heightFactors.x, inputOptions.heightFactors.y, inputOptions.heightFactors.z, inputOptions.heightFactors.w);
-                s.toNormalMap(inputOptions.bumpFrequencyScale.x, inputOptions.bumpFrequencyScale.y, inputOptions.bumpFrequencyScale.z, inputOptions.bumpFrequencyScale.w);
+                mipChainBroken[f] = false;
+                return;
             }
 
-            // To linear space.
-            if (!s.isNormalMap()) {
-                s.toLinear(inputOptions.inputGamma);
+            int idx = m * faceCount + f;
+
+            bool useSourceImages = false;
+            if (!mipChainBroken[f]) {
+                if (inputOptions.images[idx] == NULL) { // One face is missing in this mipmap level.
+                    mipChainBroken[f] = false; // If one level is missing, ignore the following source images.
+                }
+                else {
+                    useSourceImages = true;
+                }
             }
 
-            // Resize input.
-            s.resize(w, h, d, ResizeFilter_Box);
+            if (useSourceImages) {
+                img.setImage(inputOptions.inputFormat, w, h, d, inputOptions.images[idx]);
 
-            nvtt::Surface tmp = s;
-            if (!s.isNormalMap()) {
+                // For already generated mipmaps, we need to convert to linear.
+                if (!img.isNormalMap()) {
+                    img.toLinear(inputOptions.inputGamma);
+                }
+            }
+            else {
+                if (inputOptions.mipmapFilter == MipmapFilter_Kaiser) {
+                    float params[2] = { inputOptions.kaiserStretch, inputOptions.kaiserAlpha };
+                    img.buildNextMipmap(MipmapFilter_Kaiser, inputOptions.kaiserWidth, params);
+                }
+                else {
+                    img.buildNextMipmap(inputOptions.mipmapFilter);
+                }
+            }
+            nvDebugCheck(img.width() == w);
+            nvDebugCheck(img.height() == h);
+            nvDebugCheck(img.depth() == d);
+
+            if (img.isNormalMap()) {
+                if (inputOptions.normalizeMipmaps) {
+                    img.normalizeNormalMap();
+                }
+                tmp = img;
+            }
+            else {
+                tmp = img;
                 tmp.toGamma(inputOptions.outputGamma);
             }
 
             quantize(tmp, compressionOptions);
-            compress(tmp, f, 0, compressionOptions, outputOptions);
-
-            images.push_back(s);
-            mipChainBroken.push_back(false);
-        }
+        };
 
         static const unsigned char padding[3] = {0, 0, 0};
-        for (int m = 1; m < mipmapCount; m++)
-        {
-            w = max(1, w/2);
-            h = max(1, h/2);
-            d = max(1, d/2);
+        uint imageSize = 0;
 
-            // https://www.khronos.org/opengles/sdk/tools/KTX/file_format_spec/#2.16
-            imageSize = estimateSize(w, h, d, 1, compressionOptions) * faceCount;
+        auto output = [&](int i, const nvtt::Surface & tmp) {
+            const int m = i / faceCount;
+            const int f = i % faceCount;
 
-            outputOptions.writeData(&imageSize, sizeof(uint32));
+            // https://www.khronos.org/opengles/sdk/tools/KTX/file_format_spec/#2.16
+            if (f == 0) {
+                const int w = max(1, width >> m);
+                const int h = max(1, height >> m);
+                const int d = (m == 0) ? 1 : max(1, depth >> m);
+                imageSize = estimateSize(w, h, d, 1, compressionOptions) * faceCount;
+                outputOptions.writeData(&imageSize, sizeof(uint32));
+            }
 
-            nvtt::Surface tmp;
+            compress(tmp, f, m, compressionOptions, outputOptions);
 
-            for (int f = 0; f < faceCount; f++)
+            //cube padding
+            if (faceCount == 6 && arraySize == 1)
             {
-                nvtt::Surface& img = images[f];
-                int idx = m * faceCount + f;
-
-                bool useSourceImages = false;
-                if (!mipChainBroken[f]) {
-                    if (inputOptions.images[idx] == NULL) { // One face is missing in this mipmap level.
-                        mipChainBroken[f] = false; // If one level is missing, ignore the following source images.
-                    }
-                    else {
-                        useSourceImages = true;
-                    }
-                }
-
-                if (useSourceImages) {
-                    img.setImage(inputOptions.inputFormat, w, h, d, inputOptions.images[idx]);
-
-                    // For already generated mipmaps, we need to convert to linear.
-                    if (!img.isNormalMap()) {
-                        img.toLinear(inputOptions.inputGamma);
-                    }
-                }
-                else {
-                    if (inputOptions.mipmapFilter == MipmapFilter_Kaiser) {
-                        float params[2] = { inputOptions.kaiserStretch, inputOptions.kaiserAlpha };
-                        img.buildNextMipmap(MipmapFilter_Kaiser, inputOptions.kaiserWidth, params);
-                    }
-                    else {
-                        img.buildNextMipmap(inputOptions.mipmapFilter);
-                    }
-                }
-                nvDebugCheck(img.width() == w);
-                nvDebugCheck(img.height() == h);
-                nvDebugCheck(img.depth() == d);
-
-                if (img.isNormalMap()) {
-                    if (inputOptions.normalizeMipmaps) {
-                        img.normalizeNormalMap();
-                    }
-                    tmp = img;
-                }
-                else {
-                    tmp = img;
-                    tmp.toGamma(inputOptions.outputGamma);
-                }
-
-                quantize(tmp, compressionOptions);
-                compress(tmp, f, m, compressionOptions, outputOptions);
+                //TODO calc offset for uncompressed images
+            }
 
-                //cube padding
-                if (faceCount == 6 && arraySize == 1)
-                {
-                    //TODO calc offset for uncompressed images
+            if (m > 0 && f == faceCount - 1) {
+                int mipPadding = 3 - ((imageSize + 3) % 4);
+                if (mipPadding != 0) {
+                    outputOptions.writeData(&padding, mipPadding);
                 }
             }
+        };
 
-            int mipPadding = 3 - ((imageSize + 3) % 4);
-            if (mipPadding != 0) {
-                outputOptions.writeData(&padding, mipPadding);
-            }
-        }
+        pipeline(mipmapCount * faceCount, prepare, output);
     }
 
     return true;
@@ -496,16 +632,18 @@ bool Compressor::Private::compress(AlphaMode alphaMode, int w, int h, int d, int
     outputOptions.beginImage(size, w, h, d, face, mipmap);
 
     // Decide what compressor to use.
-    AutoPtr<CompressorInterface> compressor;
+    CompressorInterface * compressor = NULL;
+    bool gpu = false;
 #if defined HAVE_CUDA
     if (cudaEnabled && w * h >= 512)
     {
-        compressor = chooseGpuCompressor(compressionOptions);
+        compressor = acquireCompressor(true, compressionOptions);
+        gpu = (compressor != NULL);
     }
 #endif
     if (compressor == NULL)
     {
-        compressor = chooseCpuCompressor(compressionOptions);
+        compressor = acquireCompressor(false, compressionOptions);
     }
 
     if (compressor == NULL)
@@ -514,7 +652,10 @@ bool Compressor::Private::compress(AlphaMode alphaMode, int w, int h, int d, int
     }
     else
     {
+        compressor->setBlockCache(blockCache.ptr());
         compressor->compress(alphaMode, w, h, d, rgba, dispatcher, compressionOptions, outputOptions);
+
+        releaseCompressor(gpu, compressionOptions, compressor);
     }
 
     outputOptions.endImage();
@@ -1046,8 +1187,64 @@ bool Compressor::Private::outputHeader(nvtt::TextureType textureType, int w, int
 }
 
 
+// Maximum number of compressors kept for reuse, the least recently released ones are deleted first.
+#define MAX_CACHED_COMPRESSORS 8
+
+static bool isSameCompressor(const Compressor::Private::CachedCompressor & cached, bool gpu, const CompressionOptions::Private & compressionOptions)
+{
+    return cached.gpu == gpu && cached.format == compressionOptions.format && cached.quality == compressionOptions.quality &&
+        cached.pixelType == compressionOptions.pixelType && cached.rdo == (compressionOptions.rdoLambda > 0.0f) &&
+        cached.externalCompressor == compressionOptions.externalCompressorHash();
+}
+
+CompressorInterface * Compressor::Private::acquireCompressor(bool gpu, const CompressionOptions::Private & compressionOptions) const
+{
+    {
+        Lock<Mutex> lock(compressorMutex);
+
+        for (uint i = compressorCache.count(); i > 0; i--) {
+            if (isSameCompressor(compressorCache[i - 1], gpu, compressionOptions)) {
+                CompressorInterface * compressor = compressorCache[i - 1].compressor;
+                compressorCache.removeAt(i - 1);
+                return compressor;
+            }
+        }
+    }
+
+    return gpu ? chooseGpuCompressor(compressionOptions) : chooseCpuCompressor(compressionOptions);
+}
+
+void Compressor::Private::releaseCompressor(bool gpu, const CompressionOptions::Private & compressionOptions, CompressorInterface * compressor) const
+{
+    CachedCompressor cached;
+    cached.gpu = gpu;
+    cached.format = compressionOptions.format;
+    cached.quality = compressionOptions.quality;
+    cached.pixelType = compressionOptions.pixelType;
+    cached.rdo = (compressionOptions.rdoLambda > 0.0f);
+    cached.externalCompressor = compressionOptions.externalCompressorHash();
+    cached.compressor = compressor;
+
+    Lock<Mutex> lock(compressorMutex);
+
+    if (compressorCache.count() == MAX_CACHED_COMPRESSORS) {
+        delete compressorCache[0].compressor;
+        compressorCache.removeAt(0);
+    }
+    compressorCache.push_back(cached);
+}
+
+// The tables of the BC1 compressor are built once per process, the first time a CPU compressor is chosen.
+static void initCompressorTables()
+{
+    static const bool initialized = (icbc::init_dxt1(), true);
+    (void)initialized;
+}
+
 CompressorInterface * Compressor::Private::chooseCpuCompressor(const CompressionOptions::Private & compressionOptions) const
 {
+    initCompressorTables();
+
     if (compressionOptions.format == Format_RGB)
     {
         return new PixelFormatConverter;
@@ -1090,7 +1287,8 @@ CompressorInterface * Compressor::Private::chooseCpuCompressor(const Compression
     }
     else if (compressionOptions.format == Format_DXT5)
     {
-        if (compressionOptions.quality == Quality_Fastest)
+        // The fast compressor doesn't support rate-distortion optimization.
+        if (compressionOptions.quality == Quality_Fastest && compressionOptions.rdoLambda == 0.0f)
         {
             return new FastCompressorDXT5;
         }
@@ -1130,10 +1328,21 @@ CompressorInterface * Compressor::Private::chooseCpuCompressor(const Compression
     }
     else if (compressionOptions.format == Format_BC6)
     {
+#if defined(HAVE_CMP_CORE)
+        const bool isUnsigned = compressionOptions.pixelType == PixelType_UnsignedFloat || compressionOptions.pixelType == PixelType_UnsignedNorm || compressionOptions.pixelType == PixelType_UnsignedInt;
+        if (compressionOptions.externalCompressor == "cmp" && isUnsigned) return new CmpCompressorBC6;
+        else
+#endif
+
         return new CompressorBC6;
     }
     else if (compressionOptions.format == Format_BC7)
     {
+#if defined(HAVE_CMP_CORE)
+        if (compressionOptions.externalCompressor == "cmp") return new CmpCompressorBC7;
+        else
+#endif
+
         return new CompressorBC7;
     }
     else if (compressionOptions.format == Format_BC3_RGBM)
@@ -1156,7 +1365,7 @@ CompressorInterface * Compressor::Private::chooseCpuCompressor(const Compression
 #endif
         if (compressionOptions.format == Format_ETC1) return new CompressorETC1;
         else if (compressionOptions.format == Format_ETC2_R) return new CompressorETC2_R;
-        //else if (compressionOptions.format == Format_ETC2_RG) return new CompressorETC2_RG;
+        else if (compressionOptions.format == Format_ETC2_RG) return new CompressorETC2_RG;
         else if (compressionOptions.format == Format_ETC2_RGB) return new CompressorETC2_RGB;
         else if (compressionOptions.format == Format_ETC2_RGBA) return new CompressorETC2_RGBA;
     }
@@ -25,7 +25,10 @@
 #ifndef NV_TT_CONTEXT_H
 #define NV_TT_CONTEXT_H
 
+#include "nvthread/Mutex.h"
+
 #include "nvcore/Ptr.h"
+#include "nvcore/Array.h"
 
 #include "nvtt/Compressor.h"
 #include "nvtt/cuda/CudaCompressorDXT.h"
@@ -35,6 +38,7 @@
 namespace nv
 {
     class Image;
+    class BlockCache;
 }
 
 namespace nvtt
@@ -43,7 +47,8 @@ namespace nvtt
 
     struct Compressor::Private
     {
-        Private() {}
+        Private() : compressorMutex("Compressor") {}
+        ~Private();
 
         bool compress(const InputOptions::Private & inputOptions, const CompressionOptions::Private & compressionOptions, const OutputOptions::Private & outputOptions) const;
         bool compress(const Surface & tex, int face, int mipmap, const CompressionOptions::Private & compressionOptions, const OutputOptions::Private & outputOptions) const;
@@ -51,11 +56,19 @@ namespace nvtt
 
         void quantize(Surface & tex, const CompressionOptions::Private & compressionOptions) const;
 
+        template <typename Prepare, typename Output>
+        void pipeline(int count, Prepare & prepare, Output & output) const;
+
         bool outputHeader(nvtt::TextureType textureType, int w, int h, int d, int faceCount, int mipmapCount, bool isNormalMap, const CompressionOptions::Private & compressionOptions, const OutputOptions::Private & outputOptions) const;
 
         nv::CompressorInterface * chooseCpuCompressor(const CompressionOptions::Private & compressionOptions) const;
         nv::CompressorInterface * chooseGpuCompressor(const CompressionOptions::Private & compressionOptions) const;
 
+        // Compressors are kept after use and reused by the following images with the same settings. A compressor is taken
+        // out of the cache while in use, so concurrent calls never share one.
+        nv::CompressorInterface * acquireCompressor(bool gpu, const CompressionOptions::Private & compressionOptions) const;
+        void releaseCompressor(bool gpu, const CompressionOptions::Private & compressionOptions, nv::CompressorInterface * compressor) const;
+
         int estimateSize(int w, int h, int d, int mipmapCount, const CompressionOptions::Private & compressionOptions) const;
 
         bool cudaSupported;
@@ -63,6 +76,24 @@ namespace nvtt
 
         nv::AutoPtr<nv::CudaContext> cuda;
 
+        bool pipeliningEnabled;
+
+        nv::AutoPtr<nv::BlockCache> blockCache;   // NULL if disabled.
+
+        // The options that choose the compressor.
+        struct CachedCompressor {
+            bool gpu;
+            Format format;
+            Quality quality;
+            PixelType pixelType;
+            bool rdo;
+            uint externalCompressor;    // Hash of the name, Array moves its elements with memcpy.
+            nv::CompressorInterface * compressor;
+        };
+
+        mutable nv::Mutex compressorMutex;
+        mutable nv::Array<CachedCompressor> compressorCache;
+
         TaskDispatcher * dispatcher;
         //SequentialTaskDispatcher defaultDispatcher;
         ConcurrentTaskDispatcher defaultDispatcher;
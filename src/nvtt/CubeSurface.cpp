@@ -860,7 +860,7 @@ struct ApplyAngularFilterContext {
     EdgeFixup fixupMethod;
 };
 
-void ApplyAngularFilterTask(void * context, int id)
+void ApplyAngularFilterTask(void * context, int /*tid*/, int id)
 {
     ApplyAngularFilterContext * ctx = (ApplyAngularFilterContext *)context;
 
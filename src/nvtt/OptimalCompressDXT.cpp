@@ -35,6 +35,10 @@
 #include <limits.h>     // INT_MAX
 #include <float.h>      // FLT_MAX
 
+#if NV_USE_SSE >= 2
+#include <emmintrin.h>
+#endif
+
 using namespace nv;
 using namespace OptimalCompress;
 
@@ -243,6 +247,153 @@ namespace
 		}
 	}
 
+#if NV_USE_SSE >= 2
+
+	// ((7 - w) * a + w * b) / 7 in 16 bit lanes. The multiply by 9363 / 65536 is an exact division for the 8 bit range.
+	static inline __m128i interpolateAlpha7(__m128i a, __m128i b, int w)
+	{
+		__m128i x = _mm_add_epi16(_mm_mullo_epi16(a, _mm_set1_epi16(short(7 - w))), _mm_mullo_epi16(b, _mm_set1_epi16(short(w))));
+		return _mm_mulhi_epu16(x, _mm_set1_epi16(9363));
+	}
+
+	// ((5 - w) * a + w * b) / 5 in 16 bit lanes.
+	static inline __m128i interpolateAlpha5(__m128i a, __m128i b, int w)
+	{
+		__m128i x = _mm_add_epi16(_mm_mullo_epi16(a, _mm_set1_epi16(short(5 - w))), _mm_mullo_epi16(b, _mm_set1_epi16(short(w))));
+		return _mm_mulhi_epu16(x, _mm_set1_epi16(13108));
+	}
+
+	static inline __m128i absDifference8(__m128i a, __m128i b)
+	{
+		return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+	}
+
+	// Same palettes as AlphaBlockDXT5::evaluatePalette8 and evaluatePalette6 with d3d9=false, for the 16 endpoint pairs in
+	// the 8 bit lanes of alpha0 and alpha1.
+	static void evaluatePalettes(__m128i alpha0, __m128i alpha1, bool sixStep, __m128i palette[8])
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i a0lo = _mm_unpacklo_epi8(alpha0, zero);
+		const __m128i a0hi = _mm_unpackhi_epi8(alpha0, zero);
+		const __m128i a1lo = _mm_unpacklo_epi8(alpha1, zero);
+		const __m128i a1hi = _mm_unpackhi_epi8(alpha1, zero);
+
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+
+		if (sixStep) {
+			for (int w = 1; w < 5; w++) {
+				palette[w + 1] = _mm_packus_epi16(interpolateAlpha5(a0lo, a1lo, w), interpolateAlpha5(a0hi, a1hi, w));
+			}
+			palette[6] = zero;
+			palette[7] = _mm_set1_epi8(char(0xFF));
+		}
+		else {
+			for (int w = 1; w < 7; w++) {
+				palette[w + 1] = _mm_packus_epi16(interpolateAlpha7(a0lo, a1lo, w), interpolateAlpha7(a0hi, a1hi, w));
+			}
+		}
+	}
+
+	// Try all the pairs (a0, a1) with a1 in [a1Begin, a1End), or (a1, a0) when sixStep is set, and keep the one with the
+	// lowest error. 16 pairs are evaluated at once, with the same results as computeAlphaError.
+	static void searchAlphaEndpoints(const AlphaBlock4x4 & src, int a0, int a1Begin, int a1End, bool sixStep, float & besterror, int & besta0, int & besta1)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i lane = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+		for (int a1 = a1Begin; a1 < a1End; a1 += 16)
+		{
+			// Lanes past the end repeat the first pair, so they can't be selected.
+			const __m128i first = _mm_set1_epi8(char(a1));
+			const __m128i valid = _mm_cmplt_epi8(lane, _mm_set1_epi8(char(min(a1End - a1, 16))));
+			const __m128i candidates = _mm_add_epi8(first, _mm_and_si128(lane, valid));
+
+			__m128i palette[8];
+			if (sixStep) evaluatePalettes(candidates, _mm_set1_epi8(char(a0)), true, palette);
+			else evaluatePalettes(_mm_set1_epi8(char(a0)), candidates, false, palette);
+
+			__m128 error0 = _mm_setzero_ps();
+			__m128 error1 = _mm_setzero_ps();
+			__m128 error2 = _mm_setzero_ps();
+			__m128 error3 = _mm_setzero_ps();
+
+			bool early_out = false;
+			for (uint i = 0; i < 16; i++)
+			{
+				const __m128i alpha = _mm_set1_epi8(char(src.alpha[i]));
+
+				__m128i minDist = absDifference8(alpha, palette[0]);
+				for (uint p = 1; p < 8; p++) {
+					minDist = _mm_min_epu8(minDist, absDifference8(alpha, palette[p]));
+				}
+
+				// The squared distance fits in 16 unsigned bits.
+				__m128i lo = _mm_unpacklo_epi8(minDist, zero);
+				__m128i hi = _mm_unpackhi_epi8(minDist, zero);
+				lo = _mm_mullo_epi16(lo, lo);
+				hi = _mm_mullo_epi16(hi, hi);
+
+				const __m128 weight = _mm_set1_ps(src.weights[i]);
+				error0 = _mm_add_ps(error0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), weight));
+				error1 = _mm_add_ps(error1, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), weight));
+				error2 = _mm_add_ps(error2, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), weight));
+				error3 = _mm_add_ps(error3, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), weight));
+
+				// Early out when none of the pairs can beat the best error.
+				if ((i & 3) == 3) {
+					const __m128 best = _mm_set1_ps(besterror);
+					__m128 below = _mm_or_ps(_mm_or_ps(_mm_cmple_ps(error0, best), _mm_cmple_ps(error1, best)), _mm_or_ps(_mm_cmple_ps(error2, best), _mm_cmple_ps(error3, best)));
+					if (_mm_movemask_ps(below) == 0) {
+						early_out = true;
+						break;
+					}
+				}
+			}
+			if (early_out) continue;
+
+			float errors[16];
+			_mm_storeu_ps(errors + 0, error0);
+			_mm_storeu_ps(errors + 4, error1);
+			_mm_storeu_ps(errors + 8, error2);
+			_mm_storeu_ps(errors + 12, error3);
+
+			for (int l = 0; l < 16; l++)
+			{
+				if (errors[l] < besterror)
+				{
+					besterror = errors[l];
+					besta0 = sixStep ? a1 + l : a0;
+					besta1 = sixStep ? a0 : a1 + l;
+				}
+			}
+		}
+	}
+
+#else
+
+	static void searchAlphaEndpoints(const AlphaBlock4x4 & src, int a0, int a1Begin, int a1End, bool sixStep, float & besterror, int & besta0, int & besta1)
+	{
+		AlphaBlockDXT5 block;
+		block.u = 0;
+
+		for (int a1 = a1Begin; a1 < a1End; a1++)
+		{
+			block.alpha0 = sixStep ? a1 : a0;
+			block.alpha1 = sixStep ? a0 : a1;
+			float error = computeAlphaError(src, &block, besterror);
+
+			if (error < besterror)
+			{
+				besterror = error;
+				besta0 = block.alpha0;
+				besta1 = block.alpha1;
+			}
+		}
+	}
+
+#endif
+
 } // namespace
 
 
@@ -253,6 +404,8 @@ namespace
 // https://mollyrocket.com/forums/viewtopic.php?t=392
 void OptimalCompress::compressDXT1(Color32 c, BlockDXT1 * dxtBlock)
 {
+    initSingleColorLookup();
+
     dxtBlock->col0.r = OMatch5[c.r][0];
     dxtBlock->col0.g = OMatch6[c.g][0];
     dxtBlock->col0.b = OMatch5[c.b][0];
@@ -274,6 +427,8 @@ void OptimalCompress::compressDXT1a(Color32 c, uint alphaMask, BlockDXT1 * dxtBl
         compressDXT1(c, dxtBlock);
     }
     else {
+        initSingleColorLookup();
+
         dxtBlock->col0.r = OMatchAlpha5[c.r][0];
         dxtBlock->col0.g = OMatchAlpha6[c.g][0];
         dxtBlock->col0.b = OMatchAlpha5[c.b][0];
@@ -293,6 +448,8 @@ void OptimalCompress::compressDXT1a(Color32 c, uint alphaMask, BlockDXT1 * dxtBl
 
 void OptimalCompress::compressDXT1G(uint8 g, BlockDXT1 * dxtBlock)
 {
+    initSingleColorLookup();
+
 	dxtBlock->col0.r = 31;
 	dxtBlock->col0.g = OMatch6[g][0];
 	dxtBlock->col0.b = 0;
@@ -543,6 +700,10 @@ void OptimalCompress::compressDXT5A(const AlphaBlock4x4 & src, AlphaBlockDXT5 *
         nvDebugCheck(computeAlphaError(src, dst) == 0);
     }
     else {
+		// Start from the min/max endpoints, dst may not be initialized.
+		dst->alpha0 = maxa;
+		dst->alpha1 = mina;
+
 		float besterror = computeAlphaError(src, dst);
 		int besta0 = maxa;
 		int besta1 = mina;
@@ -554,21 +715,7 @@ void OptimalCompress::compressDXT5A(const AlphaBlock4x4 & src, AlphaBlockDXT5 *
 
 		for (int a0 = mina+9; a0 < maxa; a0++)
 		{
-			for (int a1 = mina; a1 < a0-8; a1++)
-			{
-				nvDebugCheck(a0 - a1 > 8);
-
-				dst->alpha0 = a0;
-				dst->alpha1 = a1;
-				float error = computeAlphaError(src, dst, besterror);
-
-				if (error < besterror)
-				{
-					besterror = error;
-					besta0 = a0;
-					besta1 = a1;
-				}
-			}
+			searchAlphaEndpoints(src, a0, mina, a0-8, /*sixStep=*/false, besterror, besta0, besta1);
 		}
 
         // Try using the 6 step encoding.
@@ -581,21 +728,7 @@ void OptimalCompress::compressDXT5A(const AlphaBlock4x4 & src, AlphaBlockDXT5 *
 
             for (int a0 = mina_no01 + 9; a0 < maxa_no01; a0++)
 		    {
-                for (int a1 = mina_no01; a1 < a0 - 8; a1++)
-			    {
-				    nvDebugCheck(a0 - a1 > 8);
-
-				    dst->alpha0 = a1;
-				    dst->alpha1 = a0;
-				    float error = computeAlphaError(src, dst, besterror);
-
-				    if (error < besterror)
-				    {
-					    besterror = error;
-					    besta0 = a1;
-					    besta1 = a0;
-				    }
-			    }
+                searchAlphaEndpoints(src, a0, mina_no01, a0 - 8, /*sixStep=*/true, besterror, besta0, besta1);
 		    }
         }
 
@@ -67,9 +67,7 @@ static void PrepareOptTable(uint8 * table, const uint8 * expand, int size, bool
 }
 
 
-NV_AT_STARTUP(initSingleColorLookup());
-
-void initSingleColorLookup()
+static void buildSingleColorLookup()
 {
 	uint8 expand5[32];
 	uint8 expand6[64];
@@ -88,3 +86,10 @@ void initSingleColorLookup()
 	PrepareOptTable(&OMatchAlpha6[0][0], expand6, 64, true);
 }
 
+// The tables are built the first time they are used, not at startup.
+void initSingleColorLookup()
+{
+    static const bool initialized = (buildSingleColorLookup(), true);
+    (void)initialized;
+}
+
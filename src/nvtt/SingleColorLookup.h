@@ -6,4 +6,5 @@ extern uint8 OMatch6[256][2];
 extern uint8 OMatchAlpha5[256][2];
 extern uint8 OMatchAlpha6[256][2];
 
+// Builds the tables above, it has to be called before using them.
 void initSingleColorLookup();
\ No newline at end of file
@@ -994,8 +994,7 @@ bool Surface::setImage2D(Format format, Decoder decoder, int w, int h, const voi
                         //nv::decompress_eac(ptr, colors);
                     }
                     else if (format == nvtt::Format_ETC2_RG) {
-                        // @@ Not implemented.
-                        //nv::decompress_eac(ptr, colors);
+                        nv::decompress_eac_rg(ptr, colors);
                     }
                     else if (format == nvtt::Format_ETC2_RGB_A1) {
                         // @@ Not implemented?
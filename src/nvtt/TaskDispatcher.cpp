@@ -0,0 +1,63 @@
+// Copyright (c) 2009-2011 Ignacio Castano <castano@gmail.com>
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+
+#include "TaskDispatcher.h"
+
+#include "nvthread/TaskScheduler.h"
+
+using namespace nvtt;
+
+
+struct ThreadPoolTaskDispatcher::Private
+{
+    Private(uint workerCount, const uint * cpuSet, uint cpuCount) : scheduler(workerCount, cpuSet, cpuCount), dispatcher(&scheduler) {}
+
+    nv::TaskScheduler scheduler;
+    ParallelTaskDispatcher dispatcher;
+};
+
+
+ThreadPoolTaskDispatcher::ThreadPoolTaskDispatcher(int workerCount, const unsigned int * cpuSet/*= 0*/, int cpuCount/*= 0*/) :
+    m(*new ThreadPoolTaskDispatcher::Private(uint(workerCount > 0 ? workerCount : 0), cpuSet, uint(cpuCount > 0 ? cpuCount : 0)))
+{
+}
+
+ThreadPoolTaskDispatcher::~ThreadPoolTaskDispatcher()
+{
+    delete &m;
+}
+
+void ThreadPoolTaskDispatcher::dispatch(Task * task, void * context, int count)
+{
+    m.dispatcher.dispatch(task, context, count);
+}
+
+void ThreadPoolTaskDispatcher::dispatchRange(RangeTask * task, void * context, int count, int grain)
+{
+    m.dispatcher.dispatchRange(task, context, count, grain);
+}
+
+int ThreadPoolTaskDispatcher::threadCount()
+{
+    return m.dispatcher.threadCount();
+}
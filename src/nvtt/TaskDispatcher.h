@@ -25,9 +25,12 @@
 // http://www.threadingbuildingblocks.org/
 #if defined(HAVE_TBB)
 #include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 #endif
 
+#include "nvthread/Atomic.h"
 #include "nvthread/ParallelFor.h"
+#include "nvthread/TaskScheduler.h"
 
 
 namespace nvtt {
@@ -39,14 +42,67 @@ namespace nvtt {
                 task(context, i);
             }
         }
+
+        virtual void dispatchRange(RangeTask * task, void * context, int count, int grain) {
+            if (count > 0) {
+                task(context, 0, 0, count);
+            }
+        }
+
+        virtual int threadCount() { return 1; }
     };
 
+    // Dispatches the tasks to the given scheduler, or to the shared instance if none.
     struct ParallelTaskDispatcher : public TaskDispatcher
     {
+        ParallelTaskDispatcher(nv::TaskScheduler * scheduler = NULL) : scheduler(scheduler) {}
+
+        // The shared instance is created on first use. Dispatches may run concurrently, so the pointer is published
+        // atomically, the instance itself is created only once.
+        nv::TaskScheduler * getScheduler() {
+            nv::TaskScheduler * s = nv::loadAcquirePointer(&scheduler);
+            if (s == NULL) {
+                s = nv::TaskScheduler::instance();
+                nv::storeReleasePointer(&scheduler, s);
+            }
+            return s;
+        }
+
+        struct TaskContext {
+            Task * task;
+            void * context;
+        };
+
+        static void forTask(void * context, int /*tid*/, int idx) {
+            TaskContext * ctx = (TaskContext *)context;
+            ctx->task(ctx->context, idx);
+        }
+
         virtual void dispatch(Task * task, void * context, int count) {
-            nv::ParallelFor parallelFor(task, context);
-            parallelFor.run(count); // @@ Add support for custom grain.
+            TaskContext ctx = { task, context };
+            nv::ParallelFor parallelFor(forTask, &ctx, getScheduler());
+            parallelFor.run(count);
+        }
+
+        struct RangeContext {
+            RangeTask * task;
+            void * context;
+        };
+
+        static void rangeTask(void * context, int tid, uint begin, uint end) {
+            RangeContext * range = (RangeContext *)context;
+            range->task(range->context, tid, int(begin), int(end));
+        }
+
+        virtual void dispatchRange(RangeTask * task, void * context, int count, int grain) {
+            if (count <= 0) return;
+            RangeContext range = { task, context };
+            getScheduler()->run(rangeTask, &range, uint(count), uint(grain > 0 ? grain : 1));
         }
+
+        virtual int threadCount() { return int(getScheduler()->threadCount()); }
+
+        nv::TaskScheduler * scheduler;
     };
 
 
@@ -60,6 +116,19 @@ namespace nvtt {
                 task(context, i);
             }
         }
+
+        virtual void dispatchRange(RangeTask * task, void * context, int count, int grain) {
+            if (grain < 1) grain = 1;
+            const int chunkCount = (count + grain - 1) / grain;
+
+            #pragma omp parallel for schedule(dynamic)
+            for (int i = 0; i < chunkCount; i++) {
+                const int begin = i * grain;
+                task(context, omp_get_thread_num(), begin, begin + grain < count ? begin + grain : count);
+            }
+        }
+
+        virtual int threadCount() { return omp_get_max_threads(); }
     };
 
 #endif
@@ -123,12 +192,29 @@ namespace nvtt {
         void * context;
     };
 
+    struct RangeTaskFunctor {
+        RangeTaskFunctor(RangeTask * task, void * context) : task(task), context(context) {}
+        void operator()(const tbb::blocked_range<int> & r) const {
+            task(context, tbb::this_task_arena::current_thread_index(), r.begin(), r.end());
+        }
+        RangeTask * task;
+        void * context;
+    };
+
     // Task dispatcher using Inte's Thread Building Blocks.
     struct IntelTaskDispatcher : public TaskDispatcher
     {
         virtual void dispatch(Task * task, void * context, int count) {
             parallel_for(blocked_range<int>(0, count, 1), TaskFunctor(task, context));
         }
+
+        virtual void dispatchRange(RangeTask * task, void * context, int count, int grain) {
+            if (count <= 0) return;
+            // The simple partitioner splits the range down to the grain size, but no further.
+            tbb::parallel_for(tbb::blocked_range<int>(0, count, grain > 0 ? grain : 1), RangeTaskFunctor(task, context), tbb::simple_partitioner());
+        }
+
+        virtual int threadCount() { return tbb::this_task_arena::max_concurrency(); }
     };
 
 #endif
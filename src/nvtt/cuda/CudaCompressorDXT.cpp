@@ -89,6 +89,7 @@ CudaContext::CudaContext() :
     cudaMalloc((void**) &result, MAX_BLOCKS * 8U);
 
     // Init single color lookup contant tables.
+    initSingleColorLookup();
 	setupOMatchTables(OMatch5, sizeof(OMatch5), OMatch6, sizeof(OMatch6));
 #endif
 }
@@ -1,3 +1,4 @@
 #define ICBC_IMPLEMENTATION
+#define ICBC_DISPATCH 1
 //#define ICBC_SIMD 2 // SSE4.1
 #include "icbc.h"
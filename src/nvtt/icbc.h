@@ -15,8 +15,24 @@ namespace icbc {
         Decoder_AMD = 2
     };
 
+    enum SimdLevel {
+        SimdLevel_Scalar = 0,
+        SimdLevel_SSE2 = 1,
+        SimdLevel_SSE41 = 2,
+        SimdLevel_AVX1 = 3,
+        SimdLevel_AVX2 = 4,
+        SimdLevel_AVX512 = 5,
+        SimdLevel_NEON = -1,
+        SimdLevel_VMX = -2,
+    };
+
+    // Initializes the encoder tables. When built with ICBC_DISPATCH this also selects the best instruction set supported
+    // by the CPU. The ICBC_SIMD environment variable (scalar, sse2, sse41, avx, avx2 or avx512) limits the selection.
     void init_dxt1(Decoder decoder = Decoder_D3D10);
 
+    // Instruction set selected by init_dxt1.
+    SimdLevel simd_level();
+
     enum Quality {
         Quality_Level1,  // Box fit + least squares fit.
         Quality_Level2,  // Cluster fit 4, threshold = 24.
@@ -37,6 +53,12 @@ namespace icbc {
     float evaluate_dxt1_error(const unsigned char rgba_block[16 * 4], const void * block, Decoder decoder = Decoder_D3D10);
 
     float compress_dxt1(Quality level, const float * input_colors, const float * input_weights, const float color_weights[3], bool three_color_mode, bool three_color_black, void * output);
+
+    // Compresses block_count blocks stored in structure-of-arrays layout: texel i of block b is at index i * stride + b of
+    // each plane, and input_colors holds the r, g and b planes one after the other, each 16 * stride floats. The blocks
+    // are written consecutively to output, and their errors to output_errors if not null.
+    // Quality_Fast is vectorized across blocks, the other levels compress one block at a time.
+    void compress_dxt1_batch(Quality level, int block_count, const float * input_colors, const float * input_weights, int stride, const float color_weights[3], bool three_color_mode, bool three_color_black, void * output, float * output_errors = nullptr);
 }
 
 #endif // ICBC_H
@@ -96,6 +118,27 @@ namespace icbc {
     #endif
 #endif
 
+// Runtime dispatch:
+// The translation unit that defines ICBC_DISPATCH implements the public API for the instruction set it is compiled for,
+// and on x86 forwards compress_dxt1 to a faster version if the CPU supports it. These versions are compiled in separate
+// translation units that define ICBC_DISPATCH_TARGET and set ICBC_SIMD to ICBC_SSE41, ICBC_AVX2 and ICBC_AVX512 with the
+// matching compiler flags. Each one is placed in its own namespace, so that their definitions do not collide.
+#if ICBC_DISPATCH_TARGET
+    #if ICBC_SIMD == ICBC_SSE41
+        #define ICBC_TARGET_NAMESPACE sse41
+    #elif ICBC_SIMD == ICBC_AVX2
+        #define ICBC_TARGET_NAMESPACE avx2
+    #elif ICBC_SIMD == ICBC_AVX512
+        #define ICBC_TARGET_NAMESPACE avx512
+    #else
+        #error "Unsupported dispatch target."
+    #endif
+#endif
+
+#if ICBC_DISPATCH && ICBC_X86
+    #define ICBC_DISPATCH_X86 1
+#endif
+
 // AVX1 does not require FMA, and depending on whether it's Intel or AMD you may have FMA3 or FMA4. What a mess.
 #ifndef ICBC_USE_FMA
 //#define ICBC_USE_FMA 3
@@ -154,6 +197,14 @@ namespace icbc {
 #include <intrin.h> // _BitScanReverse
 #endif
 
+#if ICBC_DISPATCH_X86 && __GNUC__
+#include <cpuid.h>  // __get_cpuid_count
+#endif
+
+#if ICBC_DISPATCH
+#include <stdio.h>  // fprintf
+#endif
+
 #include <stdint.h>
 #include <stdlib.h> // abs
 #include <string.h> // memset
@@ -170,6 +221,9 @@ namespace icbc {
 #endif
 
 namespace icbc {
+#ifdef ICBC_TARGET_NAMESPACE
+namespace ICBC_TARGET_NAMESPACE {
+#endif
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // Basic Templates
@@ -374,6 +428,7 @@ ICBC_FORCEINLINE VFloat vmsub(VFloat a, VFloat b, VFloat c) { return a * b - c;
 ICBC_FORCEINLINE VFloat vm2sub(VFloat a, VFloat b, VFloat c, VFloat d) { return a * b - c * d; }
 ICBC_FORCEINLINE VFloat vsaturate(VFloat a) { return min(max(a, 0.0f), 1.0f); }
 ICBC_FORCEINLINE VFloat vround01(VFloat a) { return float(int(a + 0.5f)); }
+ICBC_FORCEINLINE VFloat vtruncate(VFloat a) { return float(int(a)); }
 ICBC_FORCEINLINE VFloat lane_id() { return 0; }
 ICBC_FORCEINLINE VFloat vselect(VMask mask, VFloat a, VFloat b) { return mask ? b : a; }
 ICBC_FORCEINLINE VMask vbroadcast(bool b) { return b; }
@@ -422,7 +477,7 @@ ICBC_FORCEINLINE VFloat vbroadcast(float x) {
 }
 
 ICBC_FORCEINLINE VFloat vload(const float * ptr) {
-    return _mm_load_ps(ptr);
+    return _mm_loadu_ps(ptr);
 }
 
 ICBC_FORCEINLINE VFloat vgather(const float * base, VFloat index) {
@@ -604,7 +659,7 @@ ICBC_FORCEINLINE VFloat vbroadcast(float a) {
 }
 
 ICBC_FORCEINLINE VFloat vload(const float * ptr) {
-    return _mm256_load_ps(ptr);
+    return _mm256_loadu_ps(ptr);
 }
 
 ICBC_FORCEINLINE VFloat vgather(const float * base, VFloat index) {
@@ -773,7 +828,7 @@ ICBC_FORCEINLINE VInt vbroadcast(int a) {
 }
 
 ICBC_FORCEINLINE VInt vload(const int * ptr) {
-    return _mm256_load_si256((const __m256i*)ptr);
+    return _mm256_loadu_si256((const __m256i*)ptr);
 }
 
 ICBC_FORCEINLINE VInt operator- (VInt A, int b) { return _mm256_sub_epi32(A, _mm256_set1_epi32(b)); }
@@ -847,15 +902,15 @@ ICBC_FORCEINLINE VFloat vbroadcast(float a) {
 }
 
 ICBC_FORCEINLINE VFloat vload(const float * ptr) {
-    return _mm512_load_ps(ptr);
+    return _mm512_loadu_ps(ptr);
 }
 
 ICBC_FORCEINLINE VFloat vload(VMask mask, const float * ptr) {
-    return _mm512_mask_load_ps(_mm512_undefined(), mask.m, ptr);
+    return _mm512_mask_loadu_ps(_mm512_undefined(), mask.m, ptr);
 }
 
 ICBC_FORCEINLINE VFloat vload(VMask mask, const float * ptr, float fallback) {
-    return _mm512_mask_load_ps(_mm512_set1_ps(fallback), mask.m, ptr);
+    return _mm512_mask_loadu_ps(_mm512_set1_ps(fallback), mask.m, ptr);
 }
 
 ICBC_FORCEINLINE VFloat vgather(const float * base, VFloat index) {
@@ -973,7 +1028,7 @@ ICBC_FORCEINLINE VInt vbroadcast(int a) {
 }
 
 ICBC_FORCEINLINE VInt vload(const int * ptr) {
-    return _mm512_load_epi32(ptr);
+    return _mm512_loadu_epi32(ptr);
 }
 
 ICBC_FORCEINLINE VInt operator- (VInt A, int b) { return _mm512_sub_epi32(A, vbroadcast(b)); }
@@ -1326,6 +1381,25 @@ ICBC_FORCEINLINE void vtranspose4(VFloat & a, VFloat & b, VFloat & c, VFloat & d
 
 #endif // ICBC_SIMD == *
 
+#if ICBC_SIMD == ICBC_SCALAR || ICBC_SIMD == ICBC_NEON || ICBC_SIMD == ICBC_VMX
+ICBC_FORCEINLINE VFloat vgather(const float * base, VFloat index) {
+    VFloat v;
+    for (int i = 0; i < VEC_SIZE; i++) {
+        lane(v, i) = base[int(lane(index, i))];
+    }
+    return v;
+}
+#endif
+
+// Same as max and min above.
+ICBC_FORCEINLINE VFloat vmax(VFloat a, VFloat b) {
+    return vselect(b < a, b, a);
+}
+
+ICBC_FORCEINLINE VFloat vmin(VFloat a, VFloat b) {
+    return vselect(a < b, b, a);
+}
+
 #if ICBC_SIMD != ICBC_SCALAR
 ICBC_FORCEINLINE VFloat vmadd(VFloat a, float b, VFloat c) {
     VFloat vb = vbroadcast(b);
@@ -3559,12 +3633,529 @@ static float compress_dxt1(Quality level, const Vector4 input_colors[16], const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Batch compression.
+
+// The fast quality level is vectorized across blocks, each lane processes a different block. The steps are the same as
+// in compress_dxt1 for Quality_Level1, box fit followed by a least squares fit, and so are the results, unless the
+// compiler contracts the scalar code into fused multiply-adds differently.
+
+// c / 255.0f, to evaluate the palette the same way as color_to_vector3.
+static float s_unorm8_to_float[256];
+
+static void init_batch_tables() {
+    for (int i = 0; i < 256; i++) {
+        s_unorm8_to_float[i] = float(i) / 255.0f;
+    }
+}
+
+// 565 color components.
+struct VColor16 {
+    VFloat r;
+    VFloat g;
+    VFloat b;
+};
+
+// The indices of the first and last 8 texels are kept apart, so that they are exact in floating point.
+struct VBlockDXT1 {
+    VFloat col0;
+    VFloat col1;
+    VFloat indices0;
+    VFloat indices1;
+};
+
+ICBC_FORCEINLINE VColor16 vselect(VMask mask, const VColor16 & a, const VColor16 & b) {
+    VColor16 c;
+    c.r = vselect(mask, a.r, b.r);
+    c.g = vselect(mask, a.g, b.g);
+    c.b = vselect(mask, a.b, b.b);
+    return c;
+}
+
+ICBC_FORCEINLINE VVector3 vtruncate(const VVector3 & v) {
+    VVector3 t;
+    t.x = vtruncate(v.x);
+    t.y = vtruncate(v.y);
+    t.z = vtruncate(v.z);
+    return t;
+}
+
+ICBC_FORCEINLINE VVector3 vgather(const float * base, const VVector3 & index) {
+    VVector3 v;
+    v.x = vgather(base, index.x);
+    v.y = vgather(base, index.y);
+    v.z = vgather(base, index.z);
+    return v;
+}
+
+ICBC_FORCEINLINE VVector3 vsaturate(const VVector3 & v) {
+    VVector3 s;
+    s.x = vsaturate(v.x);
+    s.y = vsaturate(v.y);
+    s.z = vsaturate(v.z);
+    return s;
+}
+
+// Same as vector3_to_color16 for one component.
+ICBC_FORCEINLINE VFloat vquantize(VFloat x, float scale, const float * midpoints) {
+    VFloat q = vtruncate(vmin(vmax(x * vbroadcast(scale), vzero()), vbroadcast(scale)));
+    return q + vselect(x > vgather(midpoints, q), vzero(), vbroadcast(1.0f));
+}
+
+ICBC_FORCEINLINE VColor16 vector3_to_color16(const VVector3 & v) {
+    VColor16 c;
+    c.r = vquantize(v.x, 31.0f, midpoints5);
+    c.g = vquantize(v.y, 63.0f, midpoints6);
+    c.b = vquantize(v.z, 31.0f, midpoints5);
+    return c;
+}
+
+// Value of Color16::u.
+ICBC_FORCEINLINE VFloat color16_to_uint(const VColor16 & c) {
+    return c.r * vbroadcast(2048.0f) + c.g * vbroadcast(32.0f) + c.b;
+}
+
+// Same as bitexpand_color16_to_color32, the components are in the [0, 255] range.
+ICBC_FORCEINLINE VVector3 bitexpand_color16(const VColor16 & c) {
+    VVector3 v;
+    v.x = c.r * vbroadcast(8.0f) + vtruncate(c.r * vbroadcast(1.0f / 4));
+    v.y = c.g * vbroadcast(4.0f) + vtruncate(c.g * vbroadcast(1.0f / 16));
+    v.z = c.b * vbroadcast(8.0f) + vtruncate(c.b * vbroadcast(1.0f / 4));
+    return v;
+}
+
+// Same as evaluate_palette. The integer arithmetic of the decoders is exact in floating point, since the values are small
+// and the divisions by powers of two are exact. The divisions by 3 are rounded up, which does not change the truncation.
+static void evaluate_palette(const VColor16 & c0, const VColor16 & c1, VVector3 palette[4]) {
+    const VVector3 p0 = bitexpand_color16(c0);
+    const VVector3 p1 = bitexpand_color16(c1);
+
+    VVector3 p2, p3;    // 4 color mode.
+    VVector3 q2;        // 3 color mode, the last color is black.
+
+    if (s_decoder == Decoder_NVIDIA) {
+        const VFloat gdiff = p1.y - p0.y;
+        const VFloat gdiff4 = vtruncate(gdiff * vbroadcast(1.0f / 4));
+        const VFloat half = vbroadcast(128.0f);
+        const VFloat scale = vbroadcast(1.0f / 256);
+
+        p2.x = vtruncate((c0.r * vbroadcast(2.0f) + c1.r) * vbroadcast(22.0f / 8));
+        p2.y = vtruncate((p0.y * vbroadcast(256.0f) + gdiff4 + half + gdiff * vbroadcast(80.0f)) * scale);
+        p2.z = vtruncate((c0.b * vbroadcast(2.0f) + c1.b) * vbroadcast(22.0f / 8));
+
+        p3.x = vtruncate((c1.r * vbroadcast(2.0f) + c0.r) * vbroadcast(22.0f / 8));
+        p3.y = vtruncate((p1.y * vbroadcast(256.0f) - gdiff4 + half - gdiff * vbroadcast(80.0f)) * scale);
+        p3.z = vtruncate((c1.b * vbroadcast(2.0f) + c0.b) * vbroadcast(22.0f / 8));
+
+        q2.x = vtruncate((c0.r + c1.r) * vbroadcast(33.0f / 8));
+        q2.y = vtruncate((p0.y * vbroadcast(256.0f) + gdiff4 + half + gdiff * vbroadcast(128.0f)) * scale);
+        q2.z = vtruncate((c0.b + c1.b) * vbroadcast(33.0f / 8));
+    }
+    else if (s_decoder == Decoder_AMD) {
+        const VFloat bias = vbroadcast(32.0f);
+        const VFloat scale = vbroadcast(1.0f / 64);
+
+        p2.x = vtruncate((p0.x * vbroadcast(43.0f) + p1.x * vbroadcast(21.0f) + bias) * scale);
+        p2.y = vtruncate((p0.y * vbroadcast(43.0f) + p1.y * vbroadcast(21.0f) + bias) * scale);
+        p2.z = vtruncate((p0.z * vbroadcast(43.0f) + p1.z * vbroadcast(21.0f) + bias) * scale);
+
+        p3.x = vtruncate((p1.x * vbroadcast(43.0f) + p0.x * vbroadcast(21.0f) + bias) * scale);
+        p3.y = vtruncate((p1.y * vbroadcast(43.0f) + p0.y * vbroadcast(21.0f) + bias) * scale);
+        p3.z = vtruncate((p1.z * vbroadcast(43.0f) + p0.z * vbroadcast(21.0f) + bias) * scale);
+
+        q2 = vtruncate((p0 + p1 + vbroadcast(1, 1, 1)) * vbroadcast(0.5f));
+    }
+    else {
+        p2 = vtruncate((p0 * vbroadcast(2.0f) + p1) * vbroadcast(1.0f / 3));
+        p3 = vtruncate((p1 * vbroadcast(2.0f) + p0) * vbroadcast(1.0f / 3));
+        q2 = vtruncate((p0 + p1) * vbroadcast(0.5f));
+    }
+
+    const VMask four_colors = color16_to_uint(c0) > color16_to_uint(c1);
+
+    palette[0] = vgather(s_unorm8_to_float, p0);
+    palette[1] = vgather(s_unorm8_to_float, p1);
+    palette[2] = vgather(s_unorm8_to_float, vselect(four_colors, q2, p2));
+    palette[3] = vgather(s_unorm8_to_float, vselect(four_colors, vbroadcast(0, 0, 0), p3));
+}
+
+// Same as output_block4 followed by evaluate_mse. The interpolation factors of the selected palette entries are stored
+// in betas, as used by optimize_end_points4.
+static VFloat output_block4(const VVector3 colors[16], const VFloat weights[16], const VVector3 & vw, const VVector3 & v0, const VVector3 & v1, VBlockDXT1 * block, VFloat betas[16])
+{
+    VColor16 color0 = vector3_to_color16(v0);
+    VColor16 color1 = vector3_to_color16(v1);
+
+    const VMask swap_colors = color16_to_uint(color0) < color16_to_uint(color1);
+    const VColor16 tmp = color0;
+    color0 = vselect(swap_colors, color0, color1);
+    color1 = vselect(swap_colors, color1, tmp);
+
+    VVector3 palette[4];
+    evaluate_palette(color0, color1, palette);
+
+    const VVector3 vp0 = palette[0] * vw;
+    const VVector3 vp1 = palette[1] * vw;
+    const VVector3 vp2 = palette[2] * vw;
+    const VVector3 vp3 = palette[3] * vw;
+
+    VFloat indices[2] = { vzero(), vzero() };
+    VFloat error = vzero();
+
+    for (int i = 0; i < 16; i++) {
+        // Same as compute_indices4.
+        VVector3 vc = colors[i] * vw;
+
+        VFloat d0 = vlen2(vc - vp0);
+        VFloat d1 = vlen2(vc - vp1);
+        VFloat d2 = vlen2(vc - vp2);
+        VFloat d3 = vlen2(vc - vp3);
+
+        VMask b1 = d1 > d2;
+        VMask b2 = d0 > d2;
+        VMask x0 = b1 & b2;
+
+        VMask b0 = d0 > d3;
+        VMask b3 = d1 > d3;
+        x0 = x0 | (b0 & b3);
+
+        VMask b4 = d2 > d3;
+        VMask x1 = b0 & b4;
+
+        // x0 is the high bit of the index and x1 the low bit.
+        VFloat index = vselect(x0, vzero(), vbroadcast(2.0f)) + vselect(x1, vzero(), vbroadcast(1.0f));
+        indices[i / 8] = indices[i / 8] + index * vbroadcast(float(1 << (2 * (i % 8))));
+
+        VVector3 p = vselect(x0, vselect(x1, palette[0], palette[1]), vselect(x1, palette[2], palette[3]));
+        VVector3 d = (p - colors[i]) * vw * vbroadcast(255.0f);
+        error = error + weights[i] * vdot(d, d);
+
+        betas[i] = vselect(x0, vselect(x1, vzero(), vbroadcast(1.0f)), vselect(x1, vbroadcast(1.0f / 3.0f), vbroadcast(2.0f / 3.0f)));
+    }
+
+    block->col0 = color16_to_uint(color0);
+    block->col1 = color16_to_uint(color1);
+    block->indices0 = indices[0];
+    block->indices1 = indices[1];
+
+    return error;
+}
+
+// Compresses VEC_SIZE blocks, and writes the first count of them.
+static void compress_dxt1_fast(const float * input_colors, const float * input_weights, int stride, const Vector3 & color_weights, int count, BlockDXT1 * output, float * output_errors)
+{
+    VVector3 colors[16];
+    VFloat weights[16];
+    for (int i = 0; i < 16; i++) {
+        colors[i].x = vload(input_colors + (0 * 16 + i) * stride);
+        colors[i].y = vload(input_colors + (1 * 16 + i) * stride);
+        colors[i].z = vload(input_colors + (2 * 16 + i) * stride);
+        weights[i] = vload(input_weights + i * stride);
+    }
+
+    const VVector3 vw = vbroadcast(color_weights);
+
+    // Same as fit_colors_bbox.
+    VVector3 c0 = vbroadcast(0, 0, 0);
+    VVector3 c1 = vbroadcast(1, 1, 1);
+    for (int i = 0; i < 16; i++) {
+        c0.x = vmax(c0.x, colors[i].x);
+        c0.y = vmax(c0.y, colors[i].y);
+        c0.z = vmax(c0.z, colors[i].z);
+        c1.x = vmin(c1.x, colors[i].x);
+        c1.y = vmin(c1.y, colors[i].y);
+        c1.z = vmin(c1.z, colors[i].z);
+    }
+
+    // Same as inset_bbox.
+    const float bias = (8.0f / 255.0f) / 16.0f;
+    const VVector3 inset = (c0 - c1) * vbroadcast(1.0f / 16.0f) - vbroadcast(bias, bias, bias);
+    c0 = vsaturate(c0 - inset);
+    c1 = vsaturate(c1 + inset);
+
+    // Same as select_diagonal.
+    const VVector3 center = (c0 + c1) * vbroadcast(0.5f);
+    VFloat cov_xz = vzero();
+    VFloat cov_yz = vzero();
+    for (int i = 0; i < 16; i++) {
+        VVector3 t = colors[i] - center;
+        cov_xz = cov_xz + t.x * t.z;
+        cov_yz = cov_yz + t.y * t.z;
+    }
+
+    const VMask swap_x = cov_xz < vzero();
+    const VMask swap_y = cov_yz < vzero();
+    const VFloat x0 = vselect(swap_x, c0.x, c1.x);
+    const VFloat x1 = vselect(swap_x, c1.x, c0.x);
+    const VFloat y0 = vselect(swap_y, c0.y, c1.y);
+    const VFloat y1 = vselect(swap_y, c1.y, c0.y);
+    c0.x = x0; c0.y = y0;
+    c1.x = x1; c1.y = y1;
+
+    VBlockDXT1 block;
+    VFloat betas[16];
+    VFloat error = output_block4(colors, weights, vw, c0, c1, &block, betas);
+
+    // Same as optimize_end_points4.
+    VFloat alpha2_sum = vzero();
+    VFloat beta2_sum = vzero();
+    VFloat alphabeta_sum = vzero();
+    VVector3 alphax_sum = vbroadcast(0, 0, 0);
+    VVector3 betax_sum = vbroadcast(0, 0, 0);
+
+    for (int i = 0; i < 16; i++) {
+        VFloat beta = betas[i];
+        VFloat alpha = vbroadcast(1.0f) - beta;
+
+        alpha2_sum = alpha2_sum + alpha * alpha;
+        beta2_sum = beta2_sum + beta * beta;
+        alphabeta_sum = alphabeta_sum + alpha * beta;
+        alphax_sum = alphax_sum + colors[i] * alpha;
+        betax_sum = betax_sum + colors[i] * beta;
+    }
+
+    const VFloat denom = alpha2_sum * beta2_sum - alphabeta_sum * alphabeta_sum;
+    const VMask solved = (denom >= vbroadcast(0.0001f)) | (denom <= vbroadcast(-0.0001f));
+
+    const VFloat factor = vrcp(denom);
+    VVector3 a = vsaturate((alphax_sum * beta2_sum - betax_sum * alphabeta_sum) * factor);
+    VVector3 b = vsaturate((betax_sum * alpha2_sum - alphax_sum * alphabeta_sum) * factor);
+
+    // The blocks without a solution are discarded below, use valid end points for them.
+    a = vselect(solved, c0, a);
+    b = vselect(solved, c1, b);
+
+    VBlockDXT1 optimized_block;
+    VFloat optimized_error = output_block4(colors, weights, vw, a, b, &optimized_block, betas);
+
+    const VMask better = solved & (optimized_error < error);
+    block.col0 = vselect(better, block.col0, optimized_block.col0);
+    block.col1 = vselect(better, block.col1, optimized_block.col1);
+    block.indices0 = vselect(better, block.indices0, optimized_block.indices0);
+    block.indices1 = vselect(better, block.indices1, optimized_block.indices1);
+    error = vselect(better, error, optimized_error);
+
+    for (int i = 0; i < count; i++) {
+        output[i].col0.u = uint16(lane(block.col0, i));
+        output[i].col1.u = uint16(lane(block.col1, i));
+        output[i].indices = uint32(lane(block.indices0, i)) | (uint32(lane(block.indices1, i)) << 16);
+        if (output_errors != NULL) output_errors[i] = lane(error, i);
+    }
+}
+
+static void compress_dxt1_batch(Quality level, int block_count, const float * input_colors, const float * input_weights, int stride, const Vector3 & color_weights, bool three_color_mode, bool three_color_black, BlockDXT1 * output, float * output_errors)
+{
+    if (level == Quality_Level1) {
+        int b = 0;
+        for (; b + VEC_SIZE <= block_count; b += VEC_SIZE) {
+            compress_dxt1_fast(input_colors + b, input_weights + b, stride, color_weights, VEC_SIZE, output + b, output_errors != NULL ? output_errors + b : NULL);
+        }
+
+        // Copy the remaining blocks, so that the loads do not read past the end of the input.
+        if (b < block_count) {
+            const int count = block_count - b;
+
+            float colors[3 * 16 * VEC_SIZE] = {};
+            float weights[16 * VEC_SIZE] = {};
+            for (int i = 0; i < 16; i++) {
+                for (int j = 0; j < count; j++) {
+                    colors[(0 * 16 + i) * VEC_SIZE + j] = input_colors[(0 * 16 + i) * stride + b + j];
+                    colors[(1 * 16 + i) * VEC_SIZE + j] = input_colors[(1 * 16 + i) * stride + b + j];
+                    colors[(2 * 16 + i) * VEC_SIZE + j] = input_colors[(2 * 16 + i) * stride + b + j];
+                    weights[i * VEC_SIZE + j] = input_weights[i * stride + b + j];
+                }
+            }
+
+            compress_dxt1_fast(colors, weights, VEC_SIZE, color_weights, count, output + b, output_errors != NULL ? output_errors + b : NULL);
+        }
+    }
+    else {
+        for (int b = 0; b < block_count; b++) {
+            Vector4 colors[16];
+            float weights[16];
+            for (int i = 0; i < 16; i++) {
+                colors[i].x = input_colors[(0 * 16 + i) * stride + b];
+                colors[i].y = input_colors[(1 * 16 + i) * stride + b];
+                colors[i].z = input_colors[(2 * 16 + i) * stride + b];
+                colors[i].w = 0.0f;
+                weights[i] = input_weights[i * stride + b];
+            }
+
+            float error = compress_dxt1(level, colors, weights, color_weights, three_color_mode, three_color_black, output + b);
+            if (output_errors != NULL) output_errors[b] = error;
+        }
+    }
+}
+
+
 // Public API
 
+#if ICBC_DISPATCH_X86
+
+// Versions compiled in other translation units, see ICBC_DISPATCH_TARGET.
+namespace sse41 {
+    void init_dxt1(Decoder decoder);
+    float compress_dxt1(Quality level, const float * input_colors, const float * input_weights, const float color_weights[3], bool three_color_mode, bool three_color_black, void * output);
+    void compress_dxt1_batch(Quality level, int block_count, const float * input_colors, const float * input_weights, int stride, const float color_weights[3], bool three_color_mode, bool three_color_black, void * output, float * output_errors);
+}
+namespace avx2 {
+    void init_dxt1(Decoder decoder);
+    float compress_dxt1(Quality level, const float * input_colors, const float * input_weights, const float color_weights[3], bool three_color_mode, bool three_color_black, void * output);
+    void compress_dxt1_batch(Quality level, int block_count, const float * input_colors, const float * input_weights, int stride, const float color_weights[3], bool three_color_mode, bool three_color_black, void * output, float * output_errors);
+}
+namespace avx512 {
+    void init_dxt1(Decoder decoder);
+    float compress_dxt1(Quality level, const float * input_colors, const float * input_weights, const float color_weights[3], bool three_color_mode, bool three_color_black, void * output);
+    void compress_dxt1_batch(Quality level, int block_count, const float * input_colors, const float * input_weights, int stride, const float color_weights[3], bool three_color_mode, bool three_color_black, void * output, float * output_errors);
+}
+
+static void cpuid(int info[4], int leaf) {
+#if _MSC_VER
+    __cpuidex(info, leaf, 0);
+#else
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+    __get_cpuid_count(leaf, 0, &a, &b, &c, &d);
+    info[0] = int(a); info[1] = int(b); info[2] = int(c); info[3] = int(d);
+#endif
+}
+
+// Extended control register, tells what register state the OS saves on context switches.
+static uint64_t xgetbv() {
+#if _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int a, d;
+    __asm__ __volatile__ ("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (uint64_t(d) << 32) | a;
+#endif
+}
+
+// Highest level supported by the CPU and the OS, using the same features as the code paths above.
+static int cpu_simd_level() {
+    int info[4];
+    cpuid(info, 0);
+    const int max_leaf = info[0];
+
+    cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+
+    bool avx2 = false, bmi2 = false, avx512f = false;
+    if (max_leaf >= 7) {
+        cpuid(info, 7);
+        avx2 = (info[1] & (1 << 5)) != 0;
+        bmi2 = (info[1] & (1 << 8)) != 0;
+        avx512f = (info[1] & (1 << 16)) != 0;
+    }
+
+    const uint64_t xcr0 = osxsave ? xgetbv() : 0;
+    const bool os_ymm = (xcr0 & 0x6) == 0x6;
+    const bool os_zmm = (xcr0 & 0xE6) == 0xE6;
+
+    if (os_zmm && avx512f && avx2 && fma && bmi2) return ICBC_AVX512;
+    if (os_ymm && avx2 && fma && bmi2) return ICBC_AVX2;
+    if (os_ymm && avx) return ICBC_AVX1;
+    if (sse41) return ICBC_SSE41;
+    if (sse2) return ICBC_SSE2;
+    return ICBC_SCALAR;
+}
+
+#endif // ICBC_DISPATCH_X86
+
+#if ICBC_DISPATCH
+
+// Level requested with the ICBC_SIMD environment variable.
+static const char * const s_simd_names[] = { "scalar", "sse2", "sse41", "avx", "avx2", "avx512" };
+
+static int env_simd_level() {
+    const char * str = getenv("ICBC_SIMD");
+    if (str != NULL) {
+        for (int i = 0; i < 6; i++) {
+            if (strcmp(str, s_simd_names[i]) == 0) return i;
+        }
+    }
+    return ICBC_AVX512;
+}
+
+typedef float CompressFunction(Quality level, const float * input_colors, const float * input_weights, const float color_weights[3], bool three_color_mode, bool three_color_black, void * output);
+
+static float compress_dxt1_default(Quality level, const float * input_colors, const float * input_weights, const float rgb[3], bool three_color_mode, bool three_color_black, void * output) {
+    return compress_dxt1(level, (Vector4*)input_colors, input_weights, { rgb[0], rgb[1], rgb[2] }, three_color_mode, three_color_black, (BlockDXT1*)output);
+}
+
+typedef void BatchFunction(Quality level, int block_count, const float * input_colors, const float * input_weights, int stride, const float color_weights[3], bool three_color_mode, bool three_color_black, void * output, float * output_errors);
+
+static void compress_dxt1_batch_default(Quality level, int block_count, const float * input_colors, const float * input_weights, int stride, const float rgb[3], bool three_color_mode, bool three_color_black, void * output, float * output_errors) {
+    compress_dxt1_batch(level, block_count, input_colors, input_weights, stride, { rgb[0], rgb[1], rgb[2] }, three_color_mode, three_color_black, (BlockDXT1*)output, output_errors);
+}
+
+static int s_simd_level = ICBC_SIMD;
+static CompressFunction * s_compress_dxt1 = compress_dxt1_default;
+static BatchFunction * s_compress_dxt1_batch = compress_dxt1_batch_default;
+
+#endif // ICBC_DISPATCH
+
 void init_dxt1(Decoder decoder) {
     s_decoder = decoder;
     init_single_color_tables(decoder);
     init_cluster_tables();
+    init_batch_tables();
+
+#if ICBC_DISPATCH
+    struct Version {
+        int level;
+        void (* init)(Decoder decoder);
+        CompressFunction * compress;
+        BatchFunction * batch;
+    };
+
+    const Version versions[] = {
+        { ICBC_SIMD, NULL, compress_dxt1_default, compress_dxt1_batch_default },
+#if ICBC_DISPATCH_X86
+        { ICBC_SSE41, sse41::init_dxt1, sse41::compress_dxt1, sse41::compress_dxt1_batch },
+        { ICBC_AVX2, avx2::init_dxt1, avx2::compress_dxt1, avx2::compress_dxt1_batch },
+        { ICBC_AVX512, avx512::init_dxt1, avx512::compress_dxt1, avx512::compress_dxt1_batch },
+#endif
+    };
+    const int version_count = int(sizeof(versions) / sizeof(versions[0]));
+
+#if ICBC_DISPATCH_X86
+    const int level = min(cpu_simd_level(), env_simd_level());
+#else
+    const int level = env_simd_level();
+#endif
+
+    // Pick the highest version that does not exceed the level, or the lowest one if they all do.
+    const Version * best = NULL;
+    for (int i = 0; i < version_count; i++) {
+        if (versions[i].level <= level && (best == NULL || versions[i].level > best->level)) best = &versions[i];
+    }
+    if (best == NULL) {
+        best = &versions[0];
+        for (int i = 1; i < version_count; i++) {
+            if (versions[i].level < best->level) best = &versions[i];
+        }
+        if (best->level >= 0 && best->level < 6) {
+            fprintf(stderr, "icbc: no %s version is available, using %s.\n", s_simd_names[level], s_simd_names[best->level]);
+        }
+    }
+
+    if (best->init != NULL) best->init(decoder);
+    s_simd_level = best->level;
+    s_compress_dxt1 = best->compress;
+    s_compress_dxt1_batch = best->batch;
+#endif
+}
+
+SimdLevel simd_level() {
+#if ICBC_DISPATCH
+    return SimdLevel(s_simd_level);
+#else
+    return SimdLevel(ICBC_SIMD);
+#endif
 }
 
 void decode_dxt1(const void * block, unsigned char rgba_block[16 * 4], Decoder decoder/*=Decoder_D3D10*/) {
@@ -3576,9 +4167,24 @@ float evaluate_dxt1_error(const unsigned char rgba_block[16 * 4], const void * d
 }
 
 float compress_dxt1(Quality level, const float * input_colors, const float * input_weights, const float rgb[3], bool three_color_mode, bool three_color_black, void * output) {
+#if ICBC_DISPATCH
+    return s_compress_dxt1(level, input_colors, input_weights, rgb, three_color_mode, three_color_black, output);
+#else
     return compress_dxt1(level, (Vector4*)input_colors, input_weights, { rgb[0], rgb[1], rgb[2] }, three_color_mode, three_color_black, (BlockDXT1*)output);
+#endif
+}
+
+void compress_dxt1_batch(Quality level, int block_count, const float * input_colors, const float * input_weights, int stride, const float rgb[3], bool three_color_mode, bool three_color_black, void * output, float * output_errors/*=nullptr*/) {
+#if ICBC_DISPATCH
+    s_compress_dxt1_batch(level, block_count, input_colors, input_weights, stride, rgb, three_color_mode, three_color_black, output, output_errors);
+#else
+    compress_dxt1_batch(level, block_count, input_colors, input_weights, stride, { rgb[0], rgb[1], rgb[2] }, three_color_mode, three_color_black, (BlockDXT1*)output, output_errors);
+#endif
 }
 
+#ifdef ICBC_TARGET_NAMESPACE
+} // ICBC_TARGET_NAMESPACE
+#endif
 } // icbc
 
 // // Do not polute preprocessor definitions.
@@ -0,0 +1,7 @@
+// SSE4.1 version of the BC1 encoder, icbc::init_dxt1 selects it when the CPU supports it.
+#if defined(__i386__) || defined(_M_IX86) || defined(__x86_64__) || defined(_M_X64)
+#define ICBC_IMPLEMENTATION
+#define ICBC_DISPATCH_TARGET 1
+#define ICBC_SIMD 2 // SSE4.1
+#include "icbc.h"
+#endif
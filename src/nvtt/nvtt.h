@@ -172,6 +172,17 @@ namespace nvtt
         NVTT_API void setColorWeights(float red, float green, float blue, float alpha = 1.0f);
         NVTT_API void setRGBMThreshold(float min_m);
 
+        // Trade quality for a smaller size of the output after lossless compression, for example with zstd. Blocks reuse the
+        // endpoints and indices of the previous blocks when that increases the squared error of the block, in 8 bit units,
+        // by less than lambda for each bit saved. Only BC1, BC3 and BC7 support it. Disabled (0) by default. (New in NVTT 2.2)
+        NVTT_API void setRateDistortionLambda(float lambda);
+
+        // Compress each block at the fast quality first, and compress it again at the quality set with setQuality only if
+        // its RMS error, in 8 bit units, is above errorThreshold + varianceThreshold * the standard deviation of the block.
+        // Most blocks are easy, so this gets close to the full quality at a fraction of its cost. Only BC1, BC2, BC3 and BC7
+        // support it. A negative errorThreshold disables it, which is the default. (New in NVTT 2.2)
+        NVTT_API void setAdaptiveQuality(Quality fastQuality, float errorThreshold, float varianceThreshold = 0.0f);
+
         NVTT_API void setExternalCompressor(const char * name);
 
         // Set color mask to describe the RGB/RGBA format.
@@ -336,6 +347,8 @@ namespace nvtt
         virtual void beginImage(int size, int width, int height, int depth, int face, int miplevel) = 0;
 
         // Output data. Compressed data is output as soon as it's generated to minimize memory allocations.
+        // The data of an image may be written from the threads of the task dispatcher instead of the calling thread. The
+        // calls never overlap and the data is written in order, before endImage is called. (Changed in NVTT 2.2)
         virtual bool writeData(const void * data, int size) = 0;
 
         // Indicate the end of the compressed image. (New in NVTT 2.1)
@@ -402,12 +415,70 @@ namespace nvtt
     // (New in NVTT 2.1)
     typedef void Task(void * context, int id);
 
+    // Task that processes the items in the range [begin, end). (New in NVTT 2.2)
+    // The thread index is in the range [0, threadCount) of the dispatcher, or -1 when the dispatcher does not provide
+    // thread indices. The indices are only unique among the worker threads of the dispatcher: the threads that dispatch
+    // tasks and help executing them share index 0, so tasks dispatched from several threads at the same time can run
+    // with the same index.
+    typedef void RangeTask(void * context, int tid, int begin, int end);
+
     // (New in NVTT 2.1)
     struct TaskDispatcher
     {
         virtual ~TaskDispatcher() {}
 
         virtual void dispatch(Task * task, void * context, int count) = 0;
+
+        // Process count items in chunks of at most grain items. The default implementation dispatches one task per chunk. (New in NVTT 2.2)
+        virtual void dispatchRange(RangeTask * task, void * context, int count, int grain)
+        {
+            if (grain < 1) grain = 1;
+            RangeContext range = { task, context, count, grain };
+            dispatch(rangeTask, &range, (count + grain - 1) / grain);
+        }
+
+        // Number of thread indices passed to range tasks, 0 if not supported. (New in NVTT 2.2)
+        virtual int threadCount() { return 0; }
+
+    private:
+        struct RangeContext {
+            RangeTask * task;
+            void * context;
+            int count;
+            int grain;
+        };
+
+        static void rangeTask(void * context, int id)
+        {
+            const RangeContext * range = (const RangeContext *)context;
+            int begin = id * range->grain;
+            int end = begin + range->grain < range->count ? begin + range->grain : range->count;
+            range->task(range->context, -1, begin, end);
+        }
+    };
+
+    // Task dispatcher that owns its own pool of worker threads. Compressors that use different pools do not compete for the
+    // same workers, and the workers can be restricted to a set of logical processors, for example, the processors of a
+    // NUMA node. The threads that dispatch tasks help executing them. (New in NVTT 2.2)
+    struct ThreadPoolTaskDispatcher : public TaskDispatcher
+    {
+        NVTT_FORBID_COPY(ThreadPoolTaskDispatcher);
+        NVTT_DECLARE_PIMPL(ThreadPoolTaskDispatcher);
+
+        NVTT_API ThreadPoolTaskDispatcher(int workerCount, const unsigned int * cpuSet = 0, int cpuCount = 0);
+        NVTT_API virtual ~ThreadPoolTaskDispatcher();
+
+        NVTT_API virtual void dispatch(Task * task, void * context, int count);
+        NVTT_API virtual void dispatchRange(RangeTask * task, void * context, int count, int grain);
+        NVTT_API virtual int threadCount();
+    };
+
+    // A texture compression job of a batch. (New in NVTT 2.2)
+    struct BatchJob
+    {
+        const InputOptions * inputOptions;
+        const CompressionOptions * compressionOptions;
+        const OutputOptions * outputOptions;
     };
 
     // Context.
@@ -424,10 +495,28 @@ namespace nvtt
         NVTT_API bool isCudaAccelerationEnabled() const;
         NVTT_API void setTaskDispatcher(TaskDispatcher * disp); // (New in NVTT 2.1)
 
+        // Generate the next mipmap while the current one is being compressed. Enabled by default. Only used with the default
+        // task dispatcher, with other dispatchers the mipmaps are generated in the calling thread. (New in NVTT 2.2)
+        NVTT_API void enablePipelining(bool enable);
+        NVTT_API bool isPipeliningEnabled() const;
+
+        // Reuse the compressed block of input blocks that are identical to a block compressed earlier with the same
+        // settings, in the same image or in any other image compressed with this context. The cache has a fixed size.
+        // Disabled by default. (New in NVTT 2.2)
+        NVTT_API void enableBlockCache(bool enable);
+        NVTT_API bool isBlockCacheEnabled() const;
+
+        // Number of blocks looked up in the block cache and number of blocks found since it was enabled. (New in NVTT 2.2)
+        NVTT_API void blockCacheStatistics(unsigned int * lookupCount, unsigned int * hitCount) const;
+
         // InputOptions API.
         NVTT_API bool process(const InputOptions & inputOptions, const CompressionOptions & compressionOptions, const OutputOptions & outputOptions) const;
         NVTT_API int estimateSize(const InputOptions & inputOptions, const CompressionOptions & compressionOptions) const;
 
+        // Process many textures in a single parallel dispatch. The output of each job is written in order, but jobs run
+        // concurrently, so they should not share output handlers. Returns false if any job fails. (New in NVTT 2.2)
+        NVTT_API bool processBatch(const BatchJob * jobs, int jobCount) const;
+
         // Surface API. (New in NVTT 2.1)
         NVTT_API bool outputHeader(const Surface & img, int mipmapCount, const CompressionOptions & compressionOptions, const OutputOptions & outputOptions) const;
         NVTT_API bool compress(const Surface & img, int face, int mipmap, const CompressionOptions & compressionOptions, const OutputOptions & outputOptions) const;
@@ -0,0 +1,111 @@
+// This code is in the public domain -- castano@gmail.com
+
+// Measures the round trip latency of dispatching work to the worker threads, that is, the time it takes to wake up the
+// workers, run an empty task and wait for them to finish.
+
+#include <nvthread/ThreadPool.h>
+#include <nvthread/ParallelFor.h>
+#include <nvthread/TaskScheduler.h>
+#include <nvthread/Atomic.h>
+#include <nvcore/Timer.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace nv;
+
+static uint s_counter = 0;
+
+static void emptyThreadTask(void * /*context*/, int /*id*/) {
+    atomicIncrement(&s_counter);
+}
+
+static void emptyForTask(void * /*context*/, int /*tid*/, int /*idx*/) {
+    atomicIncrement(&s_counter);
+}
+
+static void emptyRangeTask(void * /*context*/, int /*tid*/, uint /*begin*/, uint /*end*/) {
+    atomicIncrement(&s_counter);
+}
+
+static void benchThreadPool(uint threadCount, uint spinCount, int iterations) {
+    ThreadPool pool(threadCount, /*useThreadAffinity=*/false, /*useCallingThread=*/true, spinCount);
+
+    // Warm up.
+    pool.run(emptyThreadTask, NULL);
+
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < iterations; i++) {
+        pool.run(emptyThreadTask, NULL);
+    }
+    timer.stop();
+
+    printf("ThreadPool   spin %5u: %8.2f us\n", spinCount, 1e6f * timer.elapsed() / iterations);
+}
+
+static void benchParallelFor(uint threadCount, int iterations) {
+    ParallelFor parallelFor(emptyForTask, NULL);
+    parallelFor.run(threadCount);
+
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < iterations; i++) {
+        parallelFor.run(threadCount);
+    }
+    timer.stop();
+
+    printf("ParallelFor            : %8.2f us\n", 1e6f * timer.elapsed() / iterations);
+}
+
+static void benchTaskScheduler(uint threadCount, int iterations) {
+    TaskScheduler * scheduler = TaskScheduler::instance();
+    scheduler->run(emptyRangeTask, NULL, threadCount, 1);
+
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < iterations; i++) {
+        scheduler->run(emptyRangeTask, NULL, threadCount, 1);
+    }
+    timer.stop();
+
+    printf("TaskScheduler          : %8.2f us\n", 1e6f * timer.elapsed() / iterations);
+}
+
+int main(int argc, char * argv[])
+{
+    int iterations = 10000;
+    uint threadCount = processorCount();
+    uint spinCount = ThreadPool::DefaultSpinCount;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp("-iterations", argv[i]) == 0) {
+            if (i+1 < argc) iterations = atoi(argv[++i]);
+        }
+        else if (strcmp("-threads", argv[i]) == 0) {
+            if (i+1 < argc) threadCount = atoi(argv[++i]);
+        }
+        else if (strcmp("-spin", argv[i]) == 0) {
+            if (i+1 < argc) spinCount = atoi(argv[++i]);
+        }
+        else {
+            printf("usage: nvdispatchbench [-iterations <n>] [-threads <n>] [-spin <n>]\n");
+            return 1;
+        }
+    }
+
+    if (iterations < 1) iterations = 1;
+    if (threadCount < 1) threadCount = 1;
+
+    printf("Dispatch round trip latency, %u threads, %d iterations:\n", threadCount, iterations);
+
+    benchThreadPool(threadCount, 0, iterations);
+    if (spinCount != 0) {
+        benchThreadPool(threadCount, spinCount, iterations);
+    }
+    benchParallelFor(threadCount, iterations);
+    benchTaskScheduler(threadCount, iterations);
+
+    return 0;
+}
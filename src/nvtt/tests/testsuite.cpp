@@ -196,6 +196,8 @@ enum Mode {
     //Mode_BC5_Normal_DualParaboloid,
     Mode_BC6,
     Mode_BC7,
+    Mode_BC6_CMP,
+    Mode_BC7_CMP,
     Mode_ETC1_IC,
     Mode_ETC1_EtcLib,
     Mode_ETC2_EtcLib,
@@ -203,6 +205,7 @@ enum Mode {
     Mode_ETC1_Intel,
     Mode_ETC1_Ericson,
     Mode_ETC2_RGBM,
+    Mode_ETC2_RG_Normal,
     Mode_PVR,
     Mode_Count
 };
@@ -224,6 +227,8 @@ static const char * s_modeNames[] = {
     //"BC5-Normal-DualParaboloid",    // Mode_BC5_Normal_DualParaboloid,
     "BC6",          // Mode_BC6,
     "BC7",          // Mode_BC7,
+    "BC6-CMP",      // Mode_BC6_CMP,
+    "BC7-CMP",      // Mode_BC7_CMP,
     "ETC1-IC",
     "ETC1-EtcLib",
     "ETC2-EtcLib",
@@ -231,6 +236,7 @@ static const char * s_modeNames[] = {
     "ETC1-Intel",
     "ETC1-Ericson",
     "ETC2-RGBM",
+    "ETC2-RG-Normal",
     "PVR",
 };
 nvStaticCheck(NV_ARRAY_SIZE(s_modeNames) == Mode_Count);
@@ -243,14 +249,16 @@ struct Test {
 static Test s_imageTests[] = {
 /*0*/   {"Color", 3, {Mode_BC1, Mode_BC3_YCoCg, Mode_BC3_RGBM, /*Mode_BC3_LUVW*/}},
 /*1*/   {"Alpha", 3, {Mode_BC1_Alpha, Mode_BC2_Alpha, Mode_BC3_Alpha}},
-/*2*/   {"Normal", 4, {Mode_BC5_Normal, Mode_BC5_Normal_Stereographic, Mode_BC5_Normal_Paraboloid, Mode_BC5_Normal_Quartic}},
+/*2*/   {"Normal", 5, {Mode_BC5_Normal, Mode_BC5_Normal_Stereographic, Mode_BC5_Normal_Paraboloid, Mode_BC5_Normal_Quartic, Mode_ETC2_RG_Normal}},
 /*3*/   {"Lightmap", 4, {Mode_BC1, Mode_BC3_YCoCg, Mode_BC3_RGBM, Mode_BC3_RGBS}},
 /*4*/   {"HDR", 3, {Mode_ETC2_RGBM, Mode_BC3_RGBM, Mode_BC6}},
 /*5*/   {"BC6", 1, {Mode_BC6}},
 /*6*/   {"BC7", 1, {Mode_BC7}},
 /*7*/   {"ETC", 3, {Mode_ETC1_IC, Mode_ETC1_RgEtc, Mode_ETC2_EtcLib}},
 /*8*/   {"Color Mobile", 4, {Mode_PVR, Mode_ETC1_IC, Mode_ETC2_EtcLib, Mode_BC1}},
-/*9*/   //{"ETC-Lightmap", 2, {Mode_BC3_RGBM, Mode_ETC_RGBM}},
+/*9*/   {"BC6 CMP", 2, {Mode_BC6, Mode_BC6_CMP}},
+/*10*/  {"BC7 CMP", 2, {Mode_BC7, Mode_BC7_CMP}},
+/*11*/  //{"ETC-Lightmap", 2, {Mode_BC3_RGBM, Mode_ETC_RGBM}},
 };
 const int s_imageTestCount = ARRAY_SIZE(s_imageTests);
 
@@ -334,6 +342,104 @@ enum ErrorMode {
 };
 
 
+// Compresses images whose sizes are not multiples of 4 and checks the channels that the format stores without color
+// conversion. The images have a constant alpha, or an alpha ramp that the 8 value palette of BC3 encodes exactly, and
+// the pixels that pad the partial blocks must not leak into the palettes of the blocks.
+static bool testPartialBlocks(bool nocuda)
+{
+    struct PartialTest {
+        nvtt::Format format;
+        nvtt::Quality quality;
+    };
+    static const PartialTest tests[] = {
+        {nvtt::Format_BC2, nvtt::Quality_Normal},
+        {nvtt::Format_BC3, nvtt::Quality_Normal},
+        {nvtt::Format_BC3, nvtt::Quality_Highest},
+        {nvtt::Format_BC3n, nvtt::Quality_Normal},
+        {nvtt::Format_BC3n, nvtt::Quality_Highest},
+    };
+    static const int sizes[][2] = { {1, 1}, {2, 2}, {3, 3}, {5, 6}, {7, 2} };
+
+    // Alpha of BC2 is quantized to 4 bits, the closest value to 200 is 204. The ramp uses multiples of 17, but the
+    // encoders don't always find its exact palette. Padding the partial blocks with black raises their error above 8.
+    const int tolerance = 6;
+
+    nvtt::Context context;
+    context.enableCudaAcceleration(!nocuda);
+
+    MyOutputHandler outputHandler;
+    nvtt::OutputOptions outputOptions;
+    outputOptions.setOutputHeader(false);
+    outputOptions.setOutputHandler(&outputHandler);
+
+    int failedTests = 0;
+
+    for (int t = 0; t < int(ARRAY_SIZE(tests)); t++)
+    {
+        nvtt::CompressionOptions compressionOptions;
+        compressionOptions.setFormat(tests[t].format);
+        compressionOptions.setQuality(tests[t].quality);
+
+        for (int s = 0; s < int(ARRAY_SIZE(sizes)); s++)
+        {
+            for (int ramp = 0; ramp < 2; ramp++)
+            {
+                const int w = sizes[s][0];
+                const int h = sizes[s][1];
+
+                // X of the normal maps is stored in alpha, it's the same as alpha here.
+                Color32 pixels[8 * 8];
+                for (int i = 0; i < w * h; i++) {
+                    const uint8 a = ramp ? uint8(119 + 17 * (i % 8)) : 200;
+                    pixels[i] = Color32(a, 160, 40, a);
+                }
+
+                nvtt::Surface img;
+                img.setImage(nvtt::InputFormat_BGRA_8UB, w, h, 1, pixels);
+                if (tests[t].format != nvtt::Format_BC3n) {
+                    img.setAlphaMode(nvtt::AlphaMode_Transparency);
+                }
+
+                context.compress(img, 0, 0, compressionOptions, outputOptions);
+
+                int maxError = 0;
+                const int bw = (w + 3) / 4;
+                for (int y = 0; y < h; y++) {
+                    for (int x = 0; x < w; x++) {
+                        const uint8 * block = outputHandler.m_data + 16 * ((y / 4) * bw + x / 4);
+
+                        ColorBlock decoded;
+                        if (tests[t].format == nvtt::Format_BC2) {
+                            ((const BlockDXT3 *)block)->decodeBlock(&decoded);
+                        }
+                        else {
+                            ((const BlockDXT5 *)block)->decodeBlock(&decoded);
+                        }
+
+                        const Color32 p = decoded.color(x % 4, y % 4);
+                        int error = abs(p.a - pixels[y * w + x].a);
+                        if (tests[t].format == nvtt::Format_BC3n) {
+                            // Y is stored in green.
+                            error = max(error, abs(p.g - pixels[y * w + x].g));
+                        }
+                        maxError = max(maxError, error);
+                    }
+                }
+
+                if (maxError > tolerance) {
+                    printf("  Format %d, quality %d, %dx%d %s: error %d (FAILED)\n", tests[t].format, tests[t].quality, w, h, ramp ? "ramp" : "constant", maxError);
+                    failedTests++;
+                }
+            }
+        }
+    }
+
+    printf("%d partial block tests failed.\n", failedTests);
+
+    return failedTests == 0;
+}
+
+
 int main(int argc, char *argv[])
 {
     MyAssertHandler assertHandler;
@@ -356,6 +462,7 @@ int main(int argc, char *argv[])
     Path basePath = "";
     const char * outPath = "output";
     const char * regressPath = NULL;
+    bool partial = false;
 
     // Parse arguments.
     for (int i = 1; i < argc; i++)
@@ -404,6 +511,10 @@ int main(int argc, char *argv[])
         {
             nocuda = true;
         }
+        else if (strcmp("-partial", argv[i]) == 0)
+        {
+            partial = true;
+        }
         else if (strcmp("-help", argv[i]) == 0)
         {
             showHelp = true;
@@ -468,6 +579,7 @@ int main(int argc, char *argv[])
         printf("Compression options:\n");
         printf("  -fast          \tFast compression.\n");
         printf("  -nocuda        \tDo not use cuda compressor.\n");
+        printf("  -partial       \tTest blocks that are partially out of the image, instead of an image set.\n");
 
         printf("Output options:\n");
         printf("  -out <path>    \tOutput directory.\n");
@@ -479,6 +591,11 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    if (partial)
+    {
+        return testPartialBlocks(nocuda) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     nvtt::CompressionOptions compressionOptions;
     compressionOptions.setFormat(nvtt::Format_BC1);
     if (fast)
@@ -626,6 +743,7 @@ int main(int argc, char *argv[])
     {
         float totalCompressionTime = 0;
         float totalError = 0;
+        float totalPixelCount = 0;
 
         Mode mode = test.modes[t];
 
@@ -654,6 +772,16 @@ int main(int argc, char *argv[])
         {
             format = nvtt::Format_BC7;
         }
+        else if (mode == Mode_BC6_CMP)
+        {
+            format = nvtt::Format_BC6;
+            compressor_name = "cmp";
+        }
+        else if (mode == Mode_BC7_CMP)
+        {
+            format = nvtt::Format_BC7;
+            compressor_name = "cmp";
+        }
         else if (mode == Mode_ETC1_IC)
         {
             format = nvtt::Format_ETC1;
@@ -687,6 +815,10 @@ int main(int argc, char *argv[])
         {
             format = nvtt::Format_ETC2_RGBM;
         }
+        else if (mode == Mode_ETC2_RG_Normal)
+        {
+            format = nvtt::Format_ETC2_RG;
+        }
         else if (mode == Mode_PVR)
         {
             format = nvtt::Format_PVR_4BPP_RGB;
@@ -697,7 +829,7 @@ int main(int argc, char *argv[])
         }
         
         compressionOptions.setFormat(format);
-        if (compressor_name) compressionOptions.setExternalCompressor(compressor_name);
+        compressionOptions.setExternalCompressor(compressor_name ? compressor_name : "");
 
         if (set.type == ImageType_RGBA) {
             img.setAlphaMode(nvtt::AlphaMode_Transparency);
@@ -815,7 +947,7 @@ int main(int argc, char *argv[])
                 tmp.swizzle(0, 3, 1, 4); // Co Cg 1 Y -> Co Y Cg 1
                 tmp.copyChannel(img, 3); // Restore alpha channel for weighting.*/
             }
-            else if (mode == Mode_BC5_Normal) {
+            else if (mode == Mode_BC5_Normal || mode == Mode_ETC2_RG_Normal) {
                 tmp.transformNormals(nvtt::NormalTransform_Orthographic);
             }
             else if (mode == Mode_BC5_Normal_Stereographic) {
@@ -839,8 +971,10 @@ int main(int argc, char *argv[])
             context.compress(tmp, 0, 0, compressionOptions, outputOptions);
 
             timer.stop();
-            printf("  Time:  \t%.3f sec\n", timer.elapsed());
+            const float pixelCount = float(tmp.width() * tmp.height());
+            printf("  Time:  \t%.3f sec (%.2f MPix/s)\n", timer.elapsed(), pixelCount / (timer.elapsed() * 1000000));
             totalCompressionTime += timer.elapsed();
+            totalPixelCount += pixelCount;
 
             nvtt::Surface img_out = outputHandler.decompress(mode, format, decoder);
             img_out.setAlphaMode(img.alphaMode());
@@ -907,7 +1041,7 @@ int main(int argc, char *argv[])
                 img_out.scaleBias(1, 1.0, -0.5);
                 img_out.fromYCoCg();*/
             }
-            else if (mode == Mode_BC5_Normal) {
+            else if (mode == Mode_BC5_Normal || mode == Mode_ETC2_RG_Normal) {
                 img_out.reconstructNormals(nvtt::NormalTransform_Orthographic);
             }
             else if (mode == Mode_BC5_Normal_Stereographic) {
@@ -1058,7 +1192,7 @@ int main(int argc, char *argv[])
         totalError /= set.fileCount;
 
         printf("Total Results:\n");
-        printf("  Total Compression Time:\t%.3f sec\n", totalCompressionTime);
+        printf("  Total Compression Time:\t%.3f sec (%.2f MPix/s)\n", totalCompressionTime, totalPixelCount / (totalCompressionTime * 1000000));
         printf("  Average Error:         \t%.4f\n", totalError);
 
         if (t != test.count-1) graphWriter << "|";
@@ -271,6 +271,8 @@ int main(int argc, char *argv[])
     bool noMipmaps = false;
     bool fast = false;
     bool nocuda = false;
+    float rdoLambda = 0.0f;
+    float adaptiveThreshold = -1.0f;
     bool bc1n = false;
     bool luminance = false;
     nvtt::Format format = nvtt::Format_Unknown;
@@ -444,6 +446,20 @@ int main(int argc, char *argv[])
         {
             nocuda = true;
         }
+        else if (strcmp("-rdo", argv[i]) == 0)
+        {
+            if (i+1 < argc && argv[i+1][0] != '-') {
+                rdoLambda = (float)atof(argv[i+1]);
+                i++;
+            }
+        }
+        else if (strcmp("-adaptive", argv[i]) == 0)
+        {
+            if (i+1 < argc && argv[i+1][0] != '-') {
+                adaptiveThreshold = (float)atof(argv[i+1]);
+                i++;
+            }
+        }
         else if (strcmp("-rgb", argv[i]) == 0)
         {
             format = nvtt::Format_RGB;
@@ -695,6 +711,8 @@ int main(int argc, char *argv[])
         printf("\nCompression options:\n");
         printf("  -fast         Fast compression.\n");
         printf("  -nocuda       Do not use cuda compressor.\n");
+        printf("  -rdo <lambda> Rate-distortion optimization for smaller zstd output, BC1, BC3 and BC7 only.\n");
+        printf("  -adaptive <rms> Fast compression, blocks with a higher RMS error are compressed again, BC1, BC2, BC3 and BC7 only.\n");
         printf("  -rgb          RGBA format\n");
         printf("  -lumi         LUMINANCE format\n");
         printf("  -bc1          BC1 format (DXT1)\n");
@@ -1063,6 +1081,8 @@ int main(int argc, char *argv[])
 
     nvtt::CompressionOptions compressionOptions;
     compressionOptions.setFormat(format);
+    compressionOptions.setRateDistortionLambda(rdoLambda);
+    compressionOptions.setAdaptiveQuality(nvtt::Quality_Fastest, adaptiveThreshold);
 
     compressionOptions.setQuantization(/*color dithering*/true, /*alpha dithering*/false, /*binary alpha*/false);
 